@@ -0,0 +1,655 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Aircraft profile registry, see Aircraft.h
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include "Aircraft.h"
+#include "Logger.h"
+
+// maximum number of match keys over all the profiles
+#define AIRCRAFT_MAX_MATCH_KEYS 256
+// longest match key
+#define AIRCRAFT_MATCH_KEY_SIZE 64
+// number of buckets in the match key index, must be a power of two
+#define AIRCRAFT_INDEX_SIZE 512
+// longest line in the profiles file
+#define AIRCRAFT_LINE_SIZE 256
+// marks the end of a chain of match keys
+#define AIRCRAFT_NO_KEY -1
+// longest path of a profiles file
+#define AIRCRAFT_PATH_SIZE 512
+// number of problems with a profiles file that are kept to be logged, and the longest,
+// the logger keeps no more of a string than LOGGER_TEXT_SIZE
+#define AIRCRAFT_MAX_PROBLEMS 16
+#define AIRCRAFT_PROBLEM_SIZE LOGGER_TEXT_SIZE
+
+// FNV-1a hash parameters
+#define FNV_OFFSET_BASIS 2166136261u
+#define FNV_PRIME        16777619u
+
+// one match key
+typedef struct _match_key_t
+{
+  char     Text[AIRCRAFT_MATCH_KEY_SIZE];   // lower case
+  int      Length;
+  uint32_t FirstWordHash;                   // hash of the first word of Text
+  int      Profile;                         // index of the profile it matches
+  int      Next;                            // next key in the same index bucket, AIRCRAFT_NO_KEY at the end
+} match_key_t;
+
+// the profiles and their match keys
+typedef struct _registry_t
+{
+  aircraft_profile_t Profiles[AIRCRAFT_MAX_PROFILES];
+  int                NumProfiles;
+  match_key_t        Keys[AIRCRAFT_MAX_MATCH_KEYS];
+  int                NumKeys;
+  int                Index[AIRCRAFT_INDEX_SIZE];      // first key in each bucket, AIRCRAFT_NO_KEY if empty
+} registry_t;
+
+// what was found when reading a profiles file, so it can be logged from the sim thread
+typedef struct _load_report_t
+{
+  bool     FileFound;
+  int      NumProblems;                                        // can be more than are kept
+  char     Problems[AIRCRAFT_MAX_PROBLEMS][AIRCRAFT_PROBLEM_SIZE];
+  uint64_t DurationNs;                                         // time taken to read the file
+} load_report_t;
+
+// the profiles in use and the profiles being loaded from a file
+static registry_t Registry;
+static registry_t Loading;
+// the load running on the worker thread, Loading and LoadReport belong to it until it is joined
+static std::thread Loader;
+static char LoaderPath[AIRCRAFT_PATH_SIZE];
+static load_report_t LoadReport;
+// the normalized description of the aircraft being matched, reused for each match
+static char Normalized[AIRCRAFT_DESCRIPTION_SIZE];
+
+// names of the handles in the profiles file, indexed by aircraft_handle_t
+static const char *HandleKeys[] =
+{
+  "reverse_thrust_command",
+  "throttle_down_command",
+  "throttle_ratio",
+  "indicated_airspeed",
+  "gear_on_ground",
+  "flap_angle",
+  "gear_deploy_ratio",
+  "altitude_above_ground",
+  "engine_throttle_ratio",
+  "num_engines",
+  "ground_speed",
+  "reverser_mode",
+  "mains_down_command"
+};
+
+// the handles used when a profile doesn't name them, indexed by aircraft_handle_t
+static const char *DefaultHandleNames[] =
+{
+  "sim/engines/thrust_reverse_hold",
+  "sim/engines/throttle_down",
+  "sim/cockpit2/engine/actuators/throttle_ratio_all",
+  "sim/flightmodel/position/indicated_airspeed2",
+  "sim/flightmodel2/gear/on_ground",
+  "sim/flightmodel2/wing/flap1_deg",
+  "sim/flightmodel2/gear/deploy_ratio",
+  "sim/flightmodel2/position/y_agl",
+  "sim/cockpit2/engine/actuators/throttle_ratio",
+  "sim/aircraft/engine/acf_num_engines",
+  "sim/flightmodel/position/groundspeed",
+  "sim/cockpit2/engine/actuators/prop_mode",
+  ""
+};
+
+// the profiles used when there is no profiles file
+static const char *BuiltInProfiles[][2] =
+{
+  // name                 match key
+  {"X-Crafts ERJ Family", "x-crafts erj"},
+};
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// INTERNAL FUNCTIONS
+
+// hashes the word at the start of Text, up to the first space or the end
+static uint32_t HashWord
+  (
+  const char *Text
+  )
+{
+  uint32_t Hash = FNV_OFFSET_BASIS;
+  while ((*Text != '\0') && !isspace((unsigned char)*Text))
+  {
+    Hash ^= (unsigned char)*Text++;
+    Hash *= FNV_PRIME;
+  }
+
+  return Hash;
+}
+
+// checks if a character is part of a word, bytes above 127 are parts of UTF-8 characters
+static bool IsWordChar
+  (
+  unsigned char c
+  )
+{
+  return isalnum(c) || (c >= 0x80);
+}
+
+// converts up to Size bytes of Text, stopping at a zero byte, into lower case words
+// separated by single spaces in one pass. a '-' or '.' between two word characters is kept,
+// e.g. "erj-175", any other punctuation separates words. a group in brackets at the end
+// is usually the livery so it is removed
+// returns the length of the result, which is always terminated and truncated to fit
+static int Normalize
+  (
+  const char *Text,
+  int Size,
+  char *Result,
+  int ResultSize
+  )
+{
+  int Length = 0;
+  bool Separate = false;          // a separator has been seen since the last word character
+  int Depth = 0;                  // bracket nesting
+  int GroupStart = -1;            // length of the result when the outermost bracket opened
+  bool GroupAtEnd = false;        // set while nothing but separators follow the last group
+
+  for (int i = 0; (i < Size) && (Text[i] != '\0') && (Length < ResultSize - 1); i++)
+  {
+    unsigned char c = (unsigned char)Text[i];
+
+    if (IsWordChar(c))
+    {
+      if (Separate && (Length > 0))
+      {
+        if (Length + 2 >= ResultSize) break;
+        Result[Length++] = ' ';
+      }
+      Separate = false;
+      if (Depth == 0) GroupAtEnd = false;
+      Result[Length++] = (char)tolower(c);
+    }
+    else if (((c == '-') || (c == '.')) && !Separate && (Length > 0) && (i + 1 < Size) && IsWordChar((unsigned char)Text[i + 1]))
+    {
+      Result[Length++] = (char)c;
+    }
+    else
+    {
+      Separate = true;
+      if ((c == '(') || (c == '['))
+      {
+        if (Depth == 0) GroupStart = Length;
+        Depth++;
+      }
+      else if (((c == ')') || (c == ']')) && (Depth > 0))
+      {
+        Depth--;
+        if (Depth == 0) GroupAtEnd = true;
+      }
+    }
+  }
+
+  // keep the group if it is the whole description
+  if (GroupAtEnd && (GroupStart > 0)) Length = GroupStart;
+  Result[Length] = '\0';
+
+  return Length;
+}
+
+// removes spaces from the start and end of Text
+// returns the start of the trimmed text
+static char *Trim
+  (
+  char *Text
+  )
+{
+  while (isspace((unsigned char)*Text)) Text++;
+
+  char *End = Text + strlen(Text);
+  while ((End > Text) && isspace((unsigned char)End[-1])) End--;
+  *End = '\0';
+
+  return Text;
+}
+
+// empties a registry
+static void ClearRegistry
+  (
+  registry_t *Reg
+  )
+{
+  Reg->NumProfiles = 0;
+  Reg->NumKeys = 0;
+  for (int b = 0; b < AIRCRAFT_INDEX_SIZE; b++) Reg->Index[b] = AIRCRAFT_NO_KEY;
+}
+
+// adds a profile with the default limits and handles
+// returns the new profile or NULL if the registry is full
+static aircraft_profile_t *AddProfile
+  (
+  registry_t *Reg,
+  const char *Name
+  )
+{
+  if (Reg->NumProfiles >= AIRCRAFT_MAX_PROFILES) return NULL;
+
+  aircraft_profile_t *Profile = &Reg->Profiles[Reg->NumProfiles];
+  Profile->Index = Reg->NumProfiles++;
+  snprintf(Profile->Name, AIRCRAFT_NAME_SIZE, "%s", Name);
+  Profile->Limits.MinSpeedReverseThrust = MIN_SPEED_REVERSE_THRUST;
+  Profile->Limits.MaxAirspeed           = MAX_AIRSPEED;
+  Profile->Limits.MinFlapAngle          = MIN_FLAP_ANGLE;
+  Profile->Limits.MaxAltitude           = MAX_ALTITUDE;
+  Profile->Limits.GearDownRatio         = GEAR_DOWN_RATIO;
+  Profile->Limits.ExecutionInterval     = STATE_MACHINE_EXECUTION_INTERVAL;
+  Profile->ThrottleMode                 = THROTTLE_MODE_COMMAND;
+  Profile->ThrottleRetardTime           = THROTTLE_RETARD_TIME;
+  Profile->NumGears                     = 3;
+  Profile->NoseGear                     = 0;
+  for (int h = 0; h < AIRCRAFT_NUM_HANDLES; h++)
+  {
+    snprintf(Profile->HandleNames[h], AIRCRAFT_HANDLE_NAME_SIZE, "%s", DefaultHandleNames[h]);
+  }
+
+  return Profile;
+}
+
+// adds a match key for the last profile added and indexes it by its first word
+// returns false if the registry is full or the key is empty
+static bool AddMatchKey
+  (
+  registry_t *Reg,
+  const char *Text
+  )
+{
+  if (Reg->NumKeys >= AIRCRAFT_MAX_MATCH_KEYS) return false;
+
+  int k = Reg->NumKeys;
+  match_key_t *Key = &Reg->Keys[k];
+  Key->Length = Normalize(Text, AIRCRAFT_LINE_SIZE, Key->Text, AIRCRAFT_MATCH_KEY_SIZE);
+  if (Key->Length == 0) return false;
+
+  Reg->NumKeys++;
+  Key->FirstWordHash = HashWord(Key->Text);
+  Key->Profile       = Reg->NumProfiles - 1;
+
+  int Bucket = Key->FirstWordHash & (AIRCRAFT_INDEX_SIZE - 1);
+  Key->Next = Reg->Index[Bucket];
+  Reg->Index[Bucket] = k;
+
+  return true;
+}
+
+// reads a number from a setting
+// returns false if the value isn't a number
+static bool ParseFloat
+  (
+  const char *Value,
+  float *Number
+  )
+{
+  char *End;
+  double Parsed = strtod(Value, &End);
+  if ((End == Value) || (*End != '\0')) return false;
+
+  *Number = (float)Parsed;
+  return true;
+}
+
+// reads a number from a setting that must be in a range
+// returns false if the value isn't a number from Minimum to Maximum
+static bool ParseFloatInRange
+  (
+  const char *Value,
+  float Minimum,
+  float Maximum,
+  float *Number
+  )
+{
+  float Parsed;
+  if (!ParseFloat(Value, &Parsed) || (Parsed < Minimum) || (Parsed > Maximum)) return false;
+
+  *Number = Parsed;
+  return true;
+}
+
+// reads a whole number from a setting
+// returns false if the value isn't a whole number from Minimum to Maximum
+static bool ParseInt
+  (
+  const char *Value,
+  int Minimum,
+  int Maximum,
+  int *Number
+  )
+{
+  char *End;
+  long Parsed = strtol(Value, &End, 10);
+  if ((End == Value) || (*End != '\0') || (Parsed < Minimum) || (Parsed > Maximum)) return false;
+
+  *Number = (int)Parsed;
+  return true;
+}
+
+// applies one setting from the profiles file to the last profile added
+// returns false if the setting isn't known or the value is wrong
+static bool ApplySetting
+  (
+  registry_t *Reg,
+  const char *Key,
+  const char *Value
+  )
+{
+  aircraft_profile_t *Profile = &Reg->Profiles[Reg->NumProfiles - 1];
+
+  if (strcmp(Key, "match") == 0)                    return AddMatchKey(Reg, Value);
+  if (strcmp(Key, "min_speed_reverse_thrust") == 0) return ParseFloat(Value, &Profile->Limits.MinSpeedReverseThrust);
+  if (strcmp(Key, "max_airspeed") == 0)             return ParseFloat(Value, &Profile->Limits.MaxAirspeed);
+  if (strcmp(Key, "min_flap_angle") == 0)           return ParseFloat(Value, &Profile->Limits.MinFlapAngle);
+  if (strcmp(Key, "max_altitude") == 0)             return ParseFloat(Value, &Profile->Limits.MaxAltitude);
+  if (strcmp(Key, "gear_down_ratio") == 0)          return ParseFloatInRange(Value, 0.0f, 1.0f, &Profile->Limits.GearDownRatio);
+  if (strcmp(Key, "execution_interval") == 0)       return ParseFloatInRange(Value, 0.01f, STATE_MACHINE_MAX_EXECUTION_INTERVAL, &Profile->Limits.ExecutionInterval);
+  if (strcmp(Key, "throttle_retard_time") == 0)     return ParseFloat(Value, &Profile->ThrottleRetardTime);
+  if (strcmp(Key, "num_gears") == 0)                return ParseInt(Value, 1, SIM_MAX_GEARS, &Profile->NumGears);
+  if (strcmp(Key, "nose_gear") == 0)                return ParseInt(Value, 0, SIM_MAX_GEARS - 1, &Profile->NoseGear);
+
+  if (strcmp(Key, "throttle_mode") == 0)
+  {
+    if (strcmp(Value, "command") == 0)     Profile->ThrottleMode = THROTTLE_MODE_COMMAND;
+    else if (strcmp(Value, "direct") == 0) Profile->ThrottleMode = THROTTLE_MODE_DIRECT;
+    else return false;
+    return true;
+  }
+
+  for (int h = 0; h < AIRCRAFT_NUM_HANDLES; h++)
+  {
+    if (strcmp(Key, HandleKeys[h]) == 0)
+    {
+      if ((Value[0] == '\0') || (strlen(Value) >= AIRCRAFT_HANDLE_NAME_SIZE)) return false;
+      strcpy(Profile->HandleNames[h], Value);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// adds a problem with the profiles file to a report
+static void AddProblem
+  (
+  load_report_t *Report,
+  const char *Format,
+  ...
+  )
+{
+  if (Report->NumProblems < AIRCRAFT_MAX_PROBLEMS)
+  {
+    va_list Args;
+    va_start(Args, Format);
+    vsnprintf(Report->Problems[Report->NumProblems], AIRCRAFT_PROBLEM_SIZE, Format, Args);
+    va_end(Args);
+  }
+  Report->NumProblems++;
+}
+
+// reads the profiles in the file at Path into Loading, nothing is logged so it can
+// run on any thread. the problems found are added to Report
+static void ReadProfiles
+  (
+  const char *Path,
+  load_report_t *Report
+  )
+{
+  std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+  memset(Report, 0, sizeof(load_report_t));
+  ClearRegistry(&Loading);
+
+  FILE *File = fopen(Path, "r");
+  if (File == NULL) return;
+  Report->FileFound = true;
+
+  char Line[AIRCRAFT_LINE_SIZE];
+  int LineNumber = 0;
+  while (fgets(Line, AIRCRAFT_LINE_SIZE, File) != NULL)
+  {
+    LineNumber++;
+    char *Text = Trim(Line);
+
+    // blank lines and comments
+    if ((Text[0] == '\0') || (Text[0] == '#') || (Text[0] == ';')) continue;
+
+    // start of a profile
+    if (Text[0] == '[')
+    {
+      char *End = strchr(Text, ']');
+      if (End == NULL)
+      {
+        AddProblem(Report, "Aircraft profiles line %d: missing ]", LineNumber);
+        continue;
+      }
+      *End = '\0';
+      if (AddProfile(&Loading, Trim(Text + 1)) == NULL)
+      {
+        AddProblem(Report, "Aircraft profiles line %d: more than %d profiles", LineNumber, AIRCRAFT_MAX_PROFILES);
+        break;
+      }
+      continue;
+    }
+
+    // a setting
+    char *Equals = strchr(Text, '=');
+    if (Equals == NULL)
+    {
+      AddProblem(Report, "Aircraft profiles line %d: expected setting = value", LineNumber);
+      continue;
+    }
+    *Equals = '\0';
+    char *Key = Trim(Text);
+    char *Value = Trim(Equals + 1);
+
+    if (Loading.NumProfiles == 0)
+    {
+      AddProblem(Report, "Aircraft profiles line %d: %s is not in a profile", LineNumber, Key);
+    }
+    else if (!ApplySetting(&Loading, Key, Value))
+    {
+      AddProblem(Report, "Aircraft profiles line %d: unknown setting or bad value for %s", LineNumber, Key);
+    }
+  }
+
+  fclose(File);
+
+  // a profile without a key can never be used
+  for (int p = 0; p < Loading.NumProfiles; p++)
+  {
+    int k = 0;
+    while ((k < Loading.NumKeys) && (Loading.Keys[k].Profile != p)) k++;
+    if (k == Loading.NumKeys) AddProblem(Report, "Aircraft profile %s has no match keys", Loading.Profiles[p].Name);
+  }
+
+  Report->DurationNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Start).count();
+}
+
+// logs what was found reading a profiles file and puts the profiles in the registry
+// returns the number of profiles loaded, if none were loaded the registry is unchanged
+static int UseProfiles
+  (
+  const load_report_t *Report
+  )
+{
+  if (!Report->FileFound)
+  {
+    LOG_INFO("No aircraft profiles file, using the %d built in profiles\n", Registry.NumProfiles);
+    return 0;
+  }
+
+  int NumKept = (Report->NumProblems < AIRCRAFT_MAX_PROBLEMS) ? Report->NumProblems : AIRCRAFT_MAX_PROBLEMS;
+  for (int p = 0; p < NumKept; p++) LOG_ERROR("%s\n", Report->Problems[p]);
+  if (Report->NumProblems > NumKept) LOG_ERROR("%d more problems with the aircraft profiles\n", Report->NumProblems - NumKept);
+
+  if (Loading.NumProfiles == 0)
+  {
+    LOG_ERROR("No aircraft profiles found in the profiles file, using the %d built in profiles\n", Registry.NumProfiles);
+    return 0;
+  }
+
+  Registry = Loading;
+  LOG_INFO("Loaded %d aircraft profiles in %d us\n", Registry.NumProfiles, (int)(Report->DurationNs / 1000));
+
+  return Registry.NumProfiles;
+}
+
+// reads the profiles file, run on the worker thread
+static void LoaderThread
+  (
+  void
+  )
+{
+  ReadProfiles(LoaderPath, &LoadReport);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// AIRCRAFT API
+
+// clears the registry and adds the built in profiles
+void Aircraft_Init
+  (
+  void
+  )
+{
+  ClearRegistry(&Registry);
+
+  int NumBuiltIn = sizeof(BuiltInProfiles) / sizeof(BuiltInProfiles[0]);
+  for (int p = 0; p < NumBuiltIn; p++)
+  {
+    AddProfile(&Registry, BuiltInProfiles[p][0]);
+    AddMatchKey(&Registry, BuiltInProfiles[p][1]);
+  }
+}
+
+// replaces the profiles in the registry with the profiles in the file at Path
+// returns the number of profiles loaded, if none were loaded the registry is unchanged
+int Aircraft_LoadProfiles
+  (
+  const char *Path
+  )
+{
+  // a load on the worker thread would be overwritten, let it finish first
+  Aircraft_FinishLoading(NULL);
+
+  load_report_t Report;
+  ReadProfiles(Path, &Report);
+  return UseProfiles(&Report);
+}
+
+// starts reading the profiles file at Path on a worker thread, the profiles are put in the
+// registry and any problems with the file logged by Aircraft_FinishLoading. until then
+// the registry keeps the profiles it had and can be used as normal
+void Aircraft_StartLoading
+  (
+  const char *Path
+  )
+{
+  Aircraft_FinishLoading(NULL);
+
+  snprintf(LoaderPath, AIRCRAFT_PATH_SIZE, "%s", Path);
+  Loader = std::thread(LoaderThread);
+}
+
+// returns true if a load started by Aircraft_StartLoading hasn't been finished
+bool Aircraft_IsLoading
+  (
+  void
+  )
+{
+  return Loader.joinable();
+}
+
+// waits for a load started by Aircraft_StartLoading and replaces the profiles in the
+// registry with the profiles read. DurationNs, if not NULL, is set to the time the
+// worker took to read the file in nanoseconds
+// returns the number of profiles loaded, if none were loaded or no load was started
+// the registry is unchanged
+int Aircraft_FinishLoading
+  (
+  uint64_t *DurationNs
+  )
+{
+  if (DurationNs != NULL) *DurationNs = 0;
+  if (!Loader.joinable()) return 0;
+
+  Loader.join();
+  if (DurationNs != NULL) *DurationNs = LoadReport.DurationNs;
+  return UseProfiles(&LoadReport);
+}
+
+// returns the number of profiles in the registry
+int Aircraft_GetNumProfiles
+  (
+  void
+  )
+{
+  return Registry.NumProfiles;
+}
+
+// returns the config file name of a handle, e.g. "reverse_thrust_command"
+const char *Aircraft_GetHandleKey
+  (
+  aircraft_handle_t Handle
+  )
+{
+  return HandleKeys[Handle];
+}
+
+// finds the profile that matches an aircraft description of up to Size bytes, which
+// doesn't have to be terminated
+// returns NULL if no profile matches
+const aircraft_profile_t *Aircraft_Match
+  (
+  const char *Description,
+  int Size
+  )
+{
+  Normalize(Description, Size, Normalized, AIRCRAFT_DESCRIPTION_SIZE);
+
+  LOG_INFO("Aircraft loaded = '%s'\n", Normalized);
+  LOG_TRACE("We know about %d different aircraft, searching for match\n", Registry.NumProfiles);
+
+  // look up each word of the description in the index, if more than one key
+  // matches the one that was defined first wins. the words are separated by single spaces
+  int Match = AIRCRAFT_NO_KEY;
+  const char *Word = Normalized;
+  while (*Word != '\0')
+  {
+    uint32_t Hash = HashWord(Word);
+    for (int k = Registry.Index[Hash & (AIRCRAFT_INDEX_SIZE - 1)]; k != AIRCRAFT_NO_KEY; k = Registry.Keys[k].Next)
+    {
+      const match_key_t *Key = &Registry.Keys[k];
+      if ((Key->FirstWordHash == Hash) && ((Match == AIRCRAFT_NO_KEY) || (k < Match)) && (strncmp(Word, Key->Text, Key->Length) == 0))
+      {
+        Match = k;
+      }
+    }
+
+    while ((*Word != '\0') && (*Word != ' ')) Word++;
+    if (*Word == ' ') Word++;
+  }
+
+  if (Match == AIRCRAFT_NO_KEY) return NULL;
+
+  const aircraft_profile_t *Profile = &Registry.Profiles[Registry.Keys[Match].Profile];
+  LOG_INFO("Found match for aircraft: %s\n", Profile->Name);
+  return Profile;
+}
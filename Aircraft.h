@@ -0,0 +1,112 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Aircraft profile registry
+// the aircraft the manager knows how to fly are described by profiles: the keys that
+// match the aircraft description, the landing limits and the names of the commands
+// and datarefs to use. profiles are loaded from a file so new aircraft don't need a
+// rebuild, if there is no file the built in profiles are used.
+// it doesn't use the XPLM so it can be run by offline tools. the profiles file can be
+// read on a worker thread so starting the plugin doesn't wait for it, everything else
+// must only be used from the sim thread
+//
+// the file has a section for each aircraft, settings that are left out use the defaults:
+//
+//   [X-Crafts ERJ Family]
+//   match = x-crafts erj
+//   min_speed_reverse_thrust = 60
+//   max_airspeed = 160
+//   min_flap_angle = 18
+//   max_altitude = 152.4
+//   gear_down_ratio = 1.0
+//   execution_interval = 0.25
+//   throttle_mode = command
+//   throttle_retard_time = 1.0
+//   num_gears = 3
+//   nose_gear = 0
+//   reverse_thrust_command = sim/engines/thrust_reverse_hold
+//   reverser_mode = sim/cockpit2/engine/actuators/prop_mode
+//
+// match can be given more than once. descriptions and keys are normalized the same way
+// in one pass: lower case, words separated by single spaces with punctuation dropped
+// apart from '-' and '.' inside a word, and a group in brackets at the end removed as
+// it is usually the livery. a key matches if it appears in the normalized description
+// starting at the beginning of a word, the first word of the key has to be a whole word
+// in the description. keys are indexed by a hash of their first word
+// so the cost of matching depends on the length of the description, not the number
+// of profiles
+
+#ifndef _AIRCRAFT_H_
+#define _AIRCRAFT_H_
+
+#include <stdint.h>
+#include "StateMachine.h"
+
+// maximum number of profiles
+#define AIRCRAFT_MAX_PROFILES 128
+// longest profile name
+#define AIRCRAFT_NAME_SIZE 64
+// longest command or dataref name
+#define AIRCRAFT_HANDLE_NAME_SIZE 128
+// longest aircraft description, the size of sim/aircraft/view/acf_descrip
+#define AIRCRAFT_DESCRIPTION_SIZE 260
+
+// the commands and datarefs that a profile names
+typedef enum _aircraft_handle_t
+{
+  AIRCRAFT_HANDLE_REVERSE_THRUST_COMMAND,
+  AIRCRAFT_HANDLE_THROTTLE_DOWN_COMMAND,
+  AIRCRAFT_HANDLE_THROTTLE_RATIO,
+  AIRCRAFT_HANDLE_INDICATED_AIRSPEED,
+  AIRCRAFT_HANDLE_GEAR_ON_GROUND,
+  AIRCRAFT_HANDLE_FLAP_ANGLE,
+  AIRCRAFT_HANDLE_GEAR_DEPLOY_RATIO,
+  AIRCRAFT_HANDLE_ALTITUDE_ABOVE_GROUND,
+  AIRCRAFT_HANDLE_ENGINE_THROTTLE_RATIO,
+  AIRCRAFT_HANDLE_NUM_ENGINES,
+  AIRCRAFT_HANDLE_GROUND_SPEED,
+  AIRCRAFT_HANDLE_REVERSER_MODE,
+  AIRCRAFT_HANDLE_MAINS_DOWN_COMMAND,       // optional, not used if the profile doesn't name it
+  AIRCRAFT_NUM_HANDLES
+} aircraft_handle_t;
+
+// describes a known aircraft
+typedef struct _aircraft_profile_t
+{
+  int              Index;                         // position in the registry, 0 to AIRCRAFT_MAX_PROFILES - 1
+  char             Name[AIRCRAFT_NAME_SIZE];      // user friendly name
+  landing_limits_t Limits;
+  throttle_mode_t  ThrottleMode;                  // "command" or "direct" in the profiles file
+  float            ThrottleRetardTime;            // seconds to idle in THROTTLE_MODE_DIRECT
+  int              NumGears;                      // number of gears, up to SIM_MAX_GEARS
+  int              NoseGear;                      // index of the gear that isn't a main gear
+  char             HandleNames[AIRCRAFT_NUM_HANDLES][AIRCRAFT_HANDLE_NAME_SIZE];   // indexed by aircraft_handle_t
+} aircraft_profile_t;
+
+// clears the registry and adds the built in profiles
+extern void Aircraft_Init(void);
+// replaces the profiles in the registry with the profiles in the file at Path
+// returns the number of profiles loaded, if none were loaded the registry is unchanged
+extern int Aircraft_LoadProfiles(const char *Path);
+// starts reading the profiles file at Path on a worker thread, the profiles are put in the
+// registry and any problems with the file logged by Aircraft_FinishLoading. until then
+// the registry keeps the profiles it had and can be used as normal
+extern void Aircraft_StartLoading(const char *Path);
+// returns true if a load started by Aircraft_StartLoading hasn't been finished
+extern bool Aircraft_IsLoading(void);
+// waits for a load started by Aircraft_StartLoading and replaces the profiles in the
+// registry with the profiles read. DurationNs, if not NULL, is set to the time the
+// worker took to read the file in nanoseconds
+// returns the number of profiles loaded, if none were loaded or no load was started
+// the registry is unchanged
+extern int Aircraft_FinishLoading(uint64_t *DurationNs);
+// returns the number of profiles in the registry
+extern int Aircraft_GetNumProfiles(void);
+// returns the config file name of a handle, e.g. "reverse_thrust_command"
+extern const char *Aircraft_GetHandleKey(aircraft_handle_t Handle);
+// finds the profile that matches an aircraft description of up to Size bytes, which
+// doesn't have to be terminated
+// returns NULL if no profile matches
+extern const aircraft_profile_t *Aircraft_Match(const char *Description, int Size);
+
+#endif // _AIRCRAFT_H_
@@ -0,0 +1,232 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Arming monitor, see ArmingMonitor.h
+
+#include <stdio.h>
+#include "XPLMDataAccess.h"
+#include "XPLMProcessing.h"
+#include "ArmingMonitor.h"
+#include "DatarefBrowser.h"
+#include "Logger.h"
+#include "Perf.h"
+#include "SharedStatus.h"
+
+// names of the published datarefs
+#define ARMING_MONITOR_FAILURES_DATAREF "landingthrottlemanager/arming/failures"
+#define ARMING_MONITOR_READY_DATAREF    "landingthrottlemanager/arming/ready"
+
+// the state machine being checked and the sim the landing conditions are read from
+static state_machine_t *Manager = NULL;
+static const sim_interface_t *Sim = NULL;
+static void *SimRefcon = NULL;
+// enables the manager when auto arming
+static void (*ArmManager)(void) = NULL;
+// flight loop that runs the checks
+static XPLMFlightLoopID MonitorFlightLoop = NULL;
+static XPLMDataRef FailuresRef = NULL;
+static XPLMDataRef ReadyRef = NULL;
+// options chosen by the user
+static bool MonitorEnabled = false;
+static bool AutoArmEnabled = false;
+// set when the landing conditions can be read
+static bool ConditionsAvailable = false;
+// the latest check, only valid if HaveResult is set
+static bool HaveResult = false;
+static int Failures = 0;
+static float CheckTime = 0;
+// number of checks in a row the conditions have been met for
+static int MetCount = 0;
+// set once the manager has been enabled on this approach, cleared when the conditions
+// stop being met
+static bool ArmedThisApproach = false;
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// INTERNAL FUNCTIONS
+
+// runs the monitor if it is wanted and the conditions can be read, otherwise parks it
+static void Reschedule
+  (
+  void
+  )
+{
+  HaveResult = false;
+  MetCount = 0;
+  SharedStatus_PublishArming(false, 0);
+
+  if (MonitorFlightLoop == NULL) return;
+  XPLMScheduleFlightLoop(MonitorFlightLoop, (MonitorEnabled && ConditionsAvailable) ? ARMING_MONITOR_INTERVAL : DORMANT_INTERVAL, 1);
+}
+
+// checks the landing conditions, called periodically by x-plane
+static float Monitor
+  (
+  float inElapsedSinceLastCall,
+  float inElapsedTimeSinceLastFlightLoop,
+  int inCounter,
+  void *inRefcon
+  )
+{
+  PERF_SCOPE(PERF_PROBE_ARMING_MONITOR);
+
+  // the manager is already running, once it stops the conditions may have changed
+  if (StateMachine_GetState(Manager) != WAIT_FOR_USER)
+  {
+    if (HaveResult) SharedStatus_PublishArming(false, 0);
+    HaveResult = false;
+    MetCount = 0;
+    ArmedThisApproach = true;
+    return ARMING_MONITOR_INTERVAL;
+  }
+
+  sim_snapshot_t Arming;
+  Sim->ReadSnapshot(SimRefcon, &Arming, SNAPSHOT_ARMING | SNAPSHOT_SIM_TIME);
+  Failures = StateMachine_CheckArming(Manager, &Arming);
+  CheckTime = Arming.SimTime;
+  HaveResult = true;
+  SharedStatus_PublishArming(true, Failures);
+
+  if (Failures != 0)
+  {
+    MetCount = 0;
+    ArmedThisApproach = false;
+  }
+  else if (AutoArmEnabled && !ArmedThisApproach && (Arming.AltitudeAboveGround >= ARMING_MONITOR_AUTO_ARM_MIN_ALTITUDE))
+  {
+    MetCount++;
+    if (MetCount >= ARMING_MONITOR_AUTO_ARM_CHECKS)
+    {
+      LOG_INFO("Conditions met for %d checks, enabling automatically\n", MetCount);
+      MetCount = 0;
+      ArmedThisApproach = true;
+      ArmManager();
+    }
+  }
+
+  return ARMING_MONITOR_INTERVAL;
+}
+
+// reads the latest failed conditions
+static int ReadFailures
+  (
+  void *inRefcon
+  )
+{
+  return HaveResult ? Failures : 0;
+}
+
+// reads whether the manager can be enabled now
+static int ReadReady
+  (
+  void *inRefcon
+  )
+{
+  return (HaveResult && (Failures == 0) && (StateMachine_GetState(Manager) == WAIT_FOR_USER)) ? 1 : 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ARMING MONITOR API
+
+// publishes the datarefs and creates the monitor for a state machine, which starts parked
+// the conditions are read through the sim interface with Refcon, Arm is called to enable
+// the manager when auto arming
+void ArmingMonitor_Start
+  (
+  state_machine_t *Machine,
+  const sim_interface_t *Interface,
+  void *Refcon,
+  void (*Arm)(void)
+  )
+{
+  Manager = Machine;
+  Sim = Interface;
+  SimRefcon = Refcon;
+  ArmManager = Arm;
+  HaveResult = false;
+  MetCount = 0;
+  ArmedThisApproach = false;
+
+  FailuresRef = XPLMRegisterDataAccessor(ARMING_MONITOR_FAILURES_DATAREF, xplmType_Int, 0,
+    ReadFailures, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL);
+  ReadyRef = XPLMRegisterDataAccessor(ARMING_MONITOR_READY_DATAREF, xplmType_Int, 0,
+    ReadReady, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL);
+
+  XPLMCreateFlightLoop_t FlightLoopParams;
+  FlightLoopParams.structSize   = sizeof(XPLMCreateFlightLoop_t);
+  FlightLoopParams.phase        = xplm_FlightLoop_Phase_BeforeFlightModel;
+  FlightLoopParams.callbackFunc = Monitor;
+  FlightLoopParams.refcon       = NULL;
+  MonitorFlightLoop = XPLMCreateFlightLoop(&FlightLoopParams);
+}
+
+// tells dataref browsers such as DataRefTool about the datarefs, call once all plugins are loaded
+void ArmingMonitor_Announce
+  (
+  void
+  )
+{
+  XPLMPluginID Browser = DatarefBrowser_Find();
+  DatarefBrowser_Show(Browser, ARMING_MONITOR_FAILURES_DATAREF);
+  DatarefBrowser_Show(Browser, ARMING_MONITOR_READY_DATAREF);
+}
+
+// turns the monitor and auto arming on or off
+void ArmingMonitor_SetOptions
+  (
+  bool Monitor,
+  bool AutoArm
+  )
+{
+  MonitorEnabled = Monitor;
+  AutoArmEnabled = AutoArm;
+  Reschedule();
+}
+
+// tells the monitor if the landing conditions can be read, e.g. false while an aircraft is loading
+void ArmingMonitor_SetAvailable
+  (
+  bool Available
+  )
+{
+  ConditionsAvailable = Available;
+  ArmedThisApproach = false;
+  Reschedule();
+}
+
+// gets the latest result of the monitor
+// returns false if there isn't one that is still valid
+bool ArmingMonitor_GetResult
+  (
+  int *LatestFailures,
+  float *LatestCheckTime
+  )
+{
+  if (!HaveResult) return false;
+
+  *LatestFailures = Failures;
+  *LatestCheckTime = CheckTime;
+  return true;
+}
+
+// removes the datarefs and the monitor
+void ArmingMonitor_Stop
+  (
+  void
+  )
+{
+  if (MonitorFlightLoop != NULL)
+  {
+    XPLMDestroyFlightLoop(MonitorFlightLoop);
+    MonitorFlightLoop = NULL;
+  }
+
+  if (FailuresRef != NULL) XPLMUnregisterDataAccessor(FailuresRef);
+  if (ReadyRef != NULL) XPLMUnregisterDataAccessor(ReadyRef);
+  FailuresRef = NULL;
+  ReadyRef = NULL;
+  HaveResult = false;
+}
@@ -0,0 +1,44 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Arming monitor
+// optionally checks the landing conditions in the background a few times a second so
+// the result is ready when the user presses enable, and publishes it as datarefs so
+// e.g. a cockpit light can show when the manager can be enabled:
+//   landingthrottlemanager/arming/failures  ARMING_* flags of the conditions not met
+//   landingthrottlemanager/arming/ready     1 if the manager can be enabled now
+// with auto arm the manager is enabled once the conditions have been met for
+// ARMING_MONITOR_AUTO_ARM_CHECKS checks in a row. it is only enabled once for each
+// approach, the conditions have to stop being met before it is enabled again
+// must only be used from the sim thread
+
+#ifndef _ARMING_MONITOR_H_
+#define _ARMING_MONITOR_H_
+
+#include "StateMachine.h"
+
+// time between checks in seconds
+#define ARMING_MONITOR_INTERVAL 0.5f
+// number of checks in a row the conditions must be met for before auto arming
+#define ARMING_MONITOR_AUTO_ARM_CHECKS 4
+// minimum height above ground in meters for auto arming, so a landed aircraft
+// with the flaps still down isn't armed
+#define ARMING_MONITOR_AUTO_ARM_MIN_ALTITUDE 30.0f
+
+// publishes the datarefs and creates the monitor for a state machine, which starts parked
+// the conditions are read through the sim interface with Refcon, Arm is called to enable
+// the manager when auto arming
+extern void ArmingMonitor_Start(state_machine_t *Machine, const sim_interface_t *Interface, void *Refcon, void (*Arm)(void));
+// tells dataref browsers such as DataRefTool about the datarefs, call once all plugins are loaded
+extern void ArmingMonitor_Announce(void);
+// turns the monitor and auto arming on or off
+extern void ArmingMonitor_SetOptions(bool Monitor, bool AutoArm);
+// tells the monitor if the landing conditions can be read, e.g. false while an aircraft is loading
+extern void ArmingMonitor_SetAvailable(bool Available);
+// gets the latest result of the monitor
+// returns false if there isn't one that is still valid
+extern bool ArmingMonitor_GetResult(int *Failures, float *SimTime);
+// removes the datarefs and the monitor
+extern void ArmingMonitor_Stop(void);
+
+#endif // _ARMING_MONITOR_H_
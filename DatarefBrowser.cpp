@@ -0,0 +1,41 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Dataref browsers, see DatarefBrowser.h
+
+#include "XPLMPlugin.h"
+#include "DatarefBrowser.h"
+
+// signatures of the browsers, in the order they are looked for
+#define DATAREF_EDITOR_SIGNATURE "xplanesdk.examples.DataRefEditor"
+#define DATAREF_TOOL_SIGNATURE   "com.leecbaker.datareftool"
+// message that asks a browser to list a dataref, the parameter is its name
+#define DATAREF_BROWSER_MSG_ADD_DATAREF 0x01000000
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// DATAREF BROWSER API
+
+// finds a dataref browser, call once all plugins are loaded
+// returns XPLM_NO_PLUGIN_ID if there isn't one
+XPLMPluginID DatarefBrowser_Find
+  (
+  void
+  )
+{
+  XPLMPluginID Browser = XPLMFindPluginBySignature(DATAREF_EDITOR_SIGNATURE);
+  if (Browser == XPLM_NO_PLUGIN_ID) Browser = XPLMFindPluginBySignature(DATAREF_TOOL_SIGNATURE);
+  return Browser;
+}
+
+// asks a browser found by DatarefBrowser_Find to list a dataref, nothing is sent
+// if there is no browser
+void DatarefBrowser_Show
+  (
+  XPLMPluginID Browser,
+  const char *Name
+  )
+{
+  if (Browser == XPLM_NO_PLUGIN_ID) return;
+  XPLMSendMessageToPlugin(Browser, DATAREF_BROWSER_MSG_ADD_DATAREF, (void *)Name);
+}
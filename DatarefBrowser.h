@@ -0,0 +1,22 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Dataref browsers
+// a browser such as DataRefEditor or DataRefTool only lists the datarefs of other
+// plugins that it is told about. the modules that publish datarefs use this to tell
+// it, DataRefTool also listens for the DataRefEditor message
+// must only be used from the sim thread
+
+#ifndef _DATAREF_BROWSER_H_
+#define _DATAREF_BROWSER_H_
+
+#include "XPLMDefs.h"
+
+// finds a dataref browser, call once all plugins are loaded
+// returns XPLM_NO_PLUGIN_ID if there isn't one
+extern XPLMPluginID DatarefBrowser_Find(void);
+// asks a browser found by DatarefBrowser_Find to list a dataref, nothing is sent
+// if there is no browser
+extern void DatarefBrowser_Show(XPLMPluginID Browser, const char *Name);
+
+#endif // _DATAREF_BROWSER_H_
@@ -0,0 +1,185 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Signal filters, see Filters.h
+
+#include "Filters.h"
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// INTERNAL FUNCTIONS
+
+// returns the number of bits that are set
+static int CountBits
+  (
+  uint32_t Bits
+  )
+{
+  Bits = Bits - ((Bits >> 1) & 0x55555555u);
+  Bits = (Bits & 0x33333333u) + ((Bits >> 2) & 0x33333333u);
+  return (int)((((Bits + (Bits >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// FILTERS API
+
+// sets up a debouncer that needs Required of the last Samples samples to agree, up
+// to FILTERS_MAX_DEBOUNCE_SAMPLES, and resets it
+void Filters_InitDebouncer
+  (
+  debouncer_t *Debouncer,
+  int Required,
+  int Samples
+  )
+{
+  if (Samples < 1) Samples = 1;
+  if (Samples > FILTERS_MAX_DEBOUNCE_SAMPLES) Samples = FILTERS_MAX_DEBOUNCE_SAMPLES;
+  if (Required < 1) Required = 1;
+  if (Required > Samples) Required = Samples;
+
+  Debouncer->Required = Required;
+  Debouncer->Samples  = Samples;
+  Filters_ResetDebouncer(Debouncer);
+}
+
+// forgets the samples of a debouncer
+void Filters_ResetDebouncer
+  (
+  debouncer_t *Debouncer
+  )
+{
+  Debouncer->History = 0;
+  Debouncer->Primed  = false;
+  Debouncer->Output  = false;
+}
+
+// adds a sample to a debouncer
+// returns the output
+bool Filters_Debounce
+  (
+  debouncer_t *Debouncer,
+  bool Sample
+  )
+{
+  uint32_t Mask = (Debouncer->Samples >= 32) ? 0xFFFFFFFFu : ((1u << Debouncer->Samples) - 1);
+
+  // with no history every earlier sample is taken to be the same as this one
+  if (!Debouncer->Primed)
+  {
+    Debouncer->History = Sample ? Mask : 0;
+    Debouncer->Primed  = true;
+    Debouncer->Output  = Sample;
+    return Sample;
+  }
+
+  Debouncer->History = ((Debouncer->History << 1) | (Sample ? 1u : 0u)) & Mask;
+
+  // only change to agree with the latest sample
+  if (Sample != Debouncer->Output)
+  {
+    int Agreeing = Sample ? CountBits(Debouncer->History) : Debouncer->Samples - CountBits(Debouncer->History);
+    if (Agreeing >= Debouncer->Required) Debouncer->Output = Sample;
+  }
+
+  return Debouncer->Output;
+}
+
+// sets up a hysteresis band and resets it, High must not be below Low
+void Filters_InitHysteresis
+  (
+  hysteresis_t *Band,
+  float Low,
+  float High
+  )
+{
+  Band->Low  = Low;
+  Band->High = (High < Low) ? Low : High;
+  Filters_ResetHysteresis(Band);
+}
+
+// forgets the samples of a hysteresis band
+void Filters_ResetHysteresis
+  (
+  hysteresis_t *Band
+  )
+{
+  Band->Primed = false;
+  Band->Output = false;
+}
+
+// adds a sample to a hysteresis band
+// returns true while the value is low
+bool Filters_IsLow
+  (
+  hysteresis_t *Band,
+  float Value
+  )
+{
+  if (!Band->Primed)
+  {
+    Band->Primed = true;
+    Band->Output = (Value <= Band->Low);
+  }
+  else if (Band->Output)
+  {
+    if (Value > Band->High) Band->Output = false;
+  }
+  else
+  {
+    if (Value <= Band->Low) Band->Output = true;
+  }
+
+  return Band->Output;
+}
+
+// sets up an exponential moving average with a time constant in seconds and resets it
+void Filters_InitEma
+  (
+  ema_t *Average,
+  float TimeConstant
+  )
+{
+  Average->TimeConstant = (TimeConstant < 0) ? 0 : TimeConstant;
+  Filters_ResetEma(Average);
+}
+
+// forgets the samples of an exponential moving average
+void Filters_ResetEma
+  (
+  ema_t *Average
+  )
+{
+  Average->LastTime = 0;
+  Average->Primed   = false;
+  Average->Output   = 0;
+}
+
+// adds a sample at a sim time to an exponential moving average
+// returns the average
+float Filters_Average
+  (
+  ema_t *Average,
+  float SimTime,
+  float Sample
+  )
+{
+  float Elapsed = SimTime - Average->LastTime;
+
+  // start again if time went backwards, e.g. a replay
+  if (!Average->Primed || (Elapsed < 0))
+  {
+    Average->Primed   = true;
+    Average->LastTime = SimTime;
+    Average->Output   = Sample;
+    return Sample;
+  }
+
+  // paused or read again in the same frame
+  if (Elapsed == 0) return Average->Output;
+
+  float Weight = Elapsed / (Average->TimeConstant + Elapsed);
+  Average->Output  += Weight * (Sample - Average->Output);
+  Average->LastTime = SimTime;
+  return Average->Output;
+}
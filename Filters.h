@@ -0,0 +1,75 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Signal filters
+// small filters for the noisy values in a sim snapshot, each one is a plain struct
+// that is updated with one sample per execution and nothing is allocated.
+// a debouncer only changes its output once at least Required of the last Samples
+// samples agree with the latest one, so a wheel touching for a frame in a bounce
+// isn't taken as a touch down. a hysteresis band tells if a value is low with
+// separate thresholds for becoming low and for no longer being low, so a value
+// wandering around a threshold doesn't flip the result on every sample. the
+// exponential moving average smooths a value with a time constant so it works at
+// whatever rate the state machine is executed.
+// a filter that has been reset takes its output from the next sample as it is
+
+#ifndef _FILTERS_H_
+#define _FILTERS_H_
+
+#include <stdint.h>
+
+// most samples a debouncer can look at
+#define FILTERS_MAX_DEBOUNCE_SAMPLES 32
+
+// an N of M debouncer
+typedef struct _debouncer_t
+{
+  int      Required;        // N, the number of samples that must agree to change the output
+  int      Samples;         // M, the number of recent samples looked at
+  uint32_t History;         // the last Samples samples, the latest in bit 0
+  bool     Primed;          // false until the first sample after a reset
+  bool     Output;
+} debouncer_t;
+
+// a hysteresis band
+typedef struct _hysteresis_t
+{
+  float Low;                // at or below this the value becomes low
+  float High;               // above this the value is no longer low
+  bool  Primed;             // false until the first sample after a reset
+  bool  Output;             // true while the value is low
+} hysteresis_t;
+
+// an exponential moving average
+typedef struct _ema_t
+{
+  float TimeConstant;       // seconds
+  float LastTime;           // seconds
+  bool  Primed;             // false until the first sample after a reset
+  float Output;
+} ema_t;
+
+// sets up a debouncer that needs Required of the last Samples samples to agree, up
+// to FILTERS_MAX_DEBOUNCE_SAMPLES, and resets it
+extern void Filters_InitDebouncer(debouncer_t *Debouncer, int Required, int Samples);
+// forgets the samples of a debouncer
+extern void Filters_ResetDebouncer(debouncer_t *Debouncer);
+// adds a sample to a debouncer
+// returns the output
+extern bool Filters_Debounce(debouncer_t *Debouncer, bool Sample);
+// sets up a hysteresis band and resets it, High must not be below Low
+extern void Filters_InitHysteresis(hysteresis_t *Band, float Low, float High);
+// forgets the samples of a hysteresis band
+extern void Filters_ResetHysteresis(hysteresis_t *Band);
+// adds a sample to a hysteresis band
+// returns true while the value is low
+extern bool Filters_IsLow(hysteresis_t *Band, float Value);
+// sets up an exponential moving average with a time constant in seconds and resets it
+extern void Filters_InitEma(ema_t *Average, float TimeConstant);
+// forgets the samples of an exponential moving average
+extern void Filters_ResetEma(ema_t *Average);
+// adds a sample at a sim time to an exponential moving average
+// returns the average
+extern float Filters_Average(ema_t *Average, float SimTime, float Sample);
+
+#endif // _FILTERS_H_
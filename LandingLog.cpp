@@ -0,0 +1,363 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Landing summaries, see LandingLog.h
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include "LandingLog.h"
+#include "Logger.h"
+#include "MappedFile.h"
+
+// the recent measurements of one profile
+typedef struct _profile_stats_t
+{
+  char  Name[LANDING_LOG_PROFILE_SIZE];
+  int   NumSamples[LANDING_NUM_METRICS];                    // total ever added
+  float Samples[LANDING_NUM_METRICS][LANDING_LOG_WINDOW];   // ring of the latest
+} profile_stats_t;
+
+// names of the measurements in the log, indexed by landing_metric_t
+static const char *MetricNames[] =
+{
+  "touchdown_airspeed",
+  "touchdown_vertical_speed",
+  "reverse_delay",
+  "reverse_duration",
+  "distance",
+  "enable_to_idle"
+};
+
+// the mapped landing log
+static mapped_file_t File;
+// start of the file and of the ring of records, NULL if not open
+static landing_log_header_t *Header = NULL;
+static landing_record_t *Records = NULL;
+// statistics of the profiles that have landed
+static profile_stats_t Profiles[LANDING_LOG_MAX_PROFILES];
+static int NumProfiles = 0;
+// the landing being followed, only valid while Following is set
+static bool Following = false;
+static landing_record_t Landing;
+static bool TouchedDown = false;
+static float ReverseBeginTime = 0;
+static float LastTime = 0;
+static float LastGroundSpeed = 0;
+// what was seen last, to spot the events
+static states_t LastState = WAIT_FOR_USER;
+static int LastCommands = 0;
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// INTERNAL FUNCTIONS
+
+// gets one measurement of a landing
+static float GetMetric
+  (
+  const landing_record_t *Record,
+  landing_metric_t Metric
+  )
+{
+  switch (Metric)
+  {
+    case LANDING_METRIC_TOUCHDOWN_AIRSPEED:       return Record->TouchdownAirspeed;
+    case LANDING_METRIC_TOUCHDOWN_VERTICAL_SPEED: return Record->TouchdownVerticalSpeed;
+    case LANDING_METRIC_REVERSE_DELAY:            return Record->ReverseDelay;
+    case LANDING_METRIC_REVERSE_DURATION:         return Record->ReverseDuration;
+    case LANDING_METRIC_DISTANCE:                 return Record->Distance;
+    case LANDING_METRIC_ENABLE_TO_IDLE:           return Record->EnableToIdle;
+    default:                                      return 0;
+  }
+}
+
+// notes that a measurement of the landing being followed has been made
+static void SetMeasured
+  (
+  landing_metric_t Metric
+  )
+{
+  Landing.Flags |= LANDING_LOG_MEASURED(Metric);
+}
+
+// returns true if a measurement of the landing being followed has been made
+static bool IsMeasured
+  (
+  landing_metric_t Metric
+  )
+{
+  return (Landing.Flags & LANDING_LOG_MEASURED(Metric)) != 0;
+}
+
+// finds the statistics of a profile, optionally adding them if they are not there
+// returns NULL if not found or there is no room
+static profile_stats_t *FindProfile
+  (
+  const char *Name,
+  bool Add
+  )
+{
+  for (int p = 0; p < NumProfiles; p++)
+  {
+    if (strncmp(Profiles[p].Name, Name, LANDING_LOG_PROFILE_SIZE - 1) == 0) return &Profiles[p];
+  }
+
+  if (!Add || (NumProfiles >= LANDING_LOG_MAX_PROFILES)) return NULL;
+
+  profile_stats_t *Profile = &Profiles[NumProfiles++];
+  snprintf(Profile->Name, LANDING_LOG_PROFILE_SIZE, "%s", Name);
+  for (int m = 0; m < LANDING_NUM_METRICS; m++) Profile->NumSamples[m] = 0;
+  return Profile;
+}
+
+// adds the measurements of a landing to the statistics of its profile, a landing that
+// was enabled on the ground only adds the profile
+// returns the statistics or NULL if there is no room for the profile
+static profile_stats_t *AddToStats
+  (
+  const landing_record_t *Record
+  )
+{
+  profile_stats_t *Profile = FindProfile(Record->Profile, true);
+  if (Profile == NULL) return NULL;
+  if (Record->Flags & LANDING_LOG_ENABLED_ON_GROUND) return Profile;
+
+  for (int m = 0; m < LANDING_NUM_METRICS; m++)
+  {
+    if (!(Record->Flags & LANDING_LOG_MEASURED(m))) continue;
+    Profile->Samples[m][Profile->NumSamples[m] % LANDING_LOG_WINDOW] = GetMetric(Record, (landing_metric_t)m);
+    Profile->NumSamples[m]++;
+  }
+
+  return Profile;
+}
+
+// calculates the statistics of one measurement of a profile
+// returns false if there are no measurements
+static bool Summarize
+  (
+  const profile_stats_t *Profile,
+  landing_metric_t Metric,
+  landing_stats_t *Stats
+  )
+{
+  int NumSamples = (Profile->NumSamples[Metric] < LANDING_LOG_WINDOW) ? Profile->NumSamples[Metric] : LANDING_LOG_WINDOW;
+  if (NumSamples == 0) return false;
+
+  float Sorted[LANDING_LOG_WINDOW];
+  memcpy(Sorted, Profile->Samples[Metric], NumSamples * sizeof(float));
+  std::sort(Sorted, Sorted + NumSamples);
+
+  double Total = 0;
+  for (int s = 0; s < NumSamples; s++) Total += Sorted[s];
+
+  Stats->NumLandings = NumSamples;
+  Stats->Mean        = (float)(Total / NumSamples);
+  Stats->P95         = Sorted[(int)(0.95f * (NumSamples - 1))];
+  return true;
+}
+
+// starts following a landing
+static void BeginLanding
+  (
+  const sim_snapshot_t *Snapshot,
+  const char *Profile
+  )
+{
+  memset(&Landing, 0, sizeof(Landing));
+  Landing.EnableTime = Snapshot->SimTime;
+  snprintf(Landing.Profile, LANDING_LOG_PROFILE_SIZE, "%s", Profile);
+  TouchedDown = false;
+  Following = true;
+}
+
+// writes the landing to the log and the statistics, if there was a touch down
+static void EndLanding
+  (
+  void
+  )
+{
+  Following = false;
+  if (!TouchedDown) return;
+
+  if (Header != NULL)
+  {
+    Records[Header->RecordsWritten % LANDING_LOG_CAPACITY] = Landing;
+    Header->RecordsWritten++;
+    MappedFile_Flush(&File);
+  }
+
+  if (Landing.Flags & LANDING_LOG_ENABLED_ON_GROUND)
+  {
+    LOG_INFO("Landing summary: enabled on the ground, reverse thrust for %.1f s, rolled %.0f m, not added to the statistics\n",
+      Landing.ReverseDuration, Landing.Distance);
+  }
+  else
+  {
+    LOG_INFO("Landing summary: touch down at %.0f knots %.2f m/s, reverse thrust after %.2f s for %.1f s, rolled %.0f m, idle %.2f s after enabling\n",
+      Landing.TouchdownAirspeed, Landing.TouchdownVerticalSpeed, Landing.ReverseDelay, Landing.ReverseDuration, Landing.Distance, Landing.EnableToIdle);
+  }
+
+  const profile_stats_t *Profile = AddToStats(&Landing);
+  if (Profile == NULL) return;
+
+  for (int m = 0; m < LANDING_NUM_METRICS; m++)
+  {
+    landing_stats_t Stats;
+    if (!Summarize(Profile, (landing_metric_t)m, &Stats)) continue;
+    LOG_INFO("%s %s over %d landings: mean=%.2f p95=%.2f\n", Profile->Name, MetricNames[m], Stats.NumLandings, Stats.Mean, Stats.P95);
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// LANDING LOG API
+
+// opens or creates the landing log at Path and picks up the statistics of the landings in it
+// returns true for success, without a file the statistics are still kept for this session
+bool LandingLog_Open
+  (
+  const char *Path
+  )
+{
+  if (Header != NULL) return true;
+
+  if (!MappedFile_Open(&File, Path, sizeof(landing_log_header_t) + LANDING_LOG_CAPACITY * sizeof(landing_record_t)))
+  {
+    return false;
+  }
+
+  Header = (landing_log_header_t *)File.Data;
+  Records = (landing_record_t *)(Header + 1);
+
+  // start again if the file is new or has a different layout, otherwise
+  // carry on from where the last session stopped
+  if ((Header->Magic != LANDING_LOG_MAGIC) || (Header->Version != LANDING_LOG_VERSION) ||
+      (Header->RecordSize != sizeof(landing_record_t)) || (Header->Capacity != LANDING_LOG_CAPACITY))
+  {
+    memset(Header, 0, sizeof(landing_log_header_t));
+    Header->Magic      = LANDING_LOG_MAGIC;
+    Header->Version    = LANDING_LOG_VERSION;
+    Header->RecordSize = sizeof(landing_record_t);
+    Header->Capacity   = LANDING_LOG_CAPACITY;
+  }
+
+  // oldest first so each profile ends up with its latest landings
+  uint64_t First = (Header->RecordsWritten > LANDING_LOG_CAPACITY) ? (Header->RecordsWritten - LANDING_LOG_CAPACITY) : 0;
+  for (uint64_t r = First; r < Header->RecordsWritten; r++)
+  {
+    landing_record_t *Record = &Records[r % LANDING_LOG_CAPACITY];
+    Record->Profile[LANDING_LOG_PROFILE_SIZE - 1] = '\0';
+    AddToStats(Record);
+  }
+  LOG_INFO("Landing log has %llu landings\n", (unsigned long long)Header->RecordsWritten);
+
+  return true;
+}
+
+// follows the landing after an execution of a state machine, Profile is the name of
+// the aircraft profile in use
+void LandingLog_Update
+  (
+  const state_machine_t *Machine,
+  const char *Profile
+  )
+{
+  const sim_snapshot_t *Snapshot = StateMachine_GetSnapshot(Machine);
+  states_t State = StateMachine_GetState(Machine);
+  int Commands = StateMachine_GetActiveCommands(Machine);
+  float Time = Snapshot->SimTime;
+
+  // the manager has just been enabled
+  bool Enabled = (LastState == WAIT_FOR_USER) && (State != WAIT_FOR_USER);
+  if (Enabled) BeginLanding(Snapshot, Profile);
+
+  if (Following)
+  {
+    if (!IsMeasured(LANDING_METRIC_ENABLE_TO_IDLE) &&
+        ((State == WAIT_FOR_TOUCHDOWN) || (State == APPLY_REVERSE) || (State == WAIT_FOR_END_OF_REVERSE)))
+    {
+      Landing.EnableToIdle = Time - Landing.EnableTime;
+      SetMeasured(LANDING_METRIC_ENABLE_TO_IDLE);
+    }
+
+    if (!TouchedDown && (Snapshot->Fields & SNAPSHOT_ALL_WHEELS_ON_GROUND) && (Snapshot->MainGearOnGround != 0))
+    {
+      TouchedDown            = true;
+      Landing.TouchdownTime  = Time;
+      Landing.Distance       = 0;
+      LastTime               = Time;
+      LastGroundSpeed        = Snapshot->GroundSpeed;
+      SetMeasured(LANDING_METRIC_DISTANCE);
+
+      // on the ground already when enabled, there was no approach to take the touch down from
+      if (Enabled)
+      {
+        Landing.Flags |= LANDING_LOG_ENABLED_ON_GROUND;
+      }
+      else
+      {
+        Landing.TouchdownAirspeed      = Snapshot->IndicatedAirSpeed;
+        Landing.TouchdownVerticalSpeed = StateMachine_GetVerticalSpeed(Machine);
+        SetMeasured(LANDING_METRIC_TOUCHDOWN_AIRSPEED);
+        SetMeasured(LANDING_METRIC_TOUCHDOWN_VERTICAL_SPEED);
+      }
+    }
+    else if (TouchedDown && (Snapshot->Fields & SNAPSHOT_GROUND_SPEED) && (Time > LastTime))
+    {
+      Landing.Distance += 0.5f * (LastGroundSpeed + Snapshot->GroundSpeed) * (Time - LastTime);
+      LastTime        = Time;
+      LastGroundSpeed = Snapshot->GroundSpeed;
+    }
+
+    if (!(LastCommands & REVERSE_COMMANDS) && (Commands & REVERSE_COMMANDS))
+    {
+      if (TouchedDown && !(Landing.Flags & LANDING_LOG_ENABLED_ON_GROUND))
+      {
+        Landing.ReverseDelay = Time - Landing.TouchdownTime;
+        SetMeasured(LANDING_METRIC_REVERSE_DELAY);
+      }
+      ReverseBeginTime = Time;
+      Landing.Flags |= LANDING_LOG_REVERSE_USED;
+    }
+    if ((LastCommands & REVERSE_COMMANDS) && !(Commands & REVERSE_COMMANDS))
+    {
+      Landing.ReverseDuration = Time - ReverseBeginTime;
+      SetMeasured(LANDING_METRIC_REVERSE_DURATION);
+    }
+
+    if (State == WAIT_FOR_USER) EndLanding();
+  }
+
+  LastState = State;
+  LastCommands = Commands;
+}
+
+// gets the statistics of a measurement over the recent landings of a profile
+// returns false if there are none
+bool LandingLog_GetStats
+  (
+  const char *Profile,
+  landing_metric_t Metric,
+  landing_stats_t *Stats
+  )
+{
+  const profile_stats_t *Found = FindProfile(Profile, false);
+  if (Found == NULL) return false;
+
+  return Summarize(Found, Metric, Stats);
+}
+
+// closes the landing log
+void LandingLog_Close
+  (
+  void
+  )
+{
+  if (Header == NULL) return;
+
+  MappedFile_Flush(&File);
+  MappedFile_Close(&File);
+  Header = NULL;
+  Records = NULL;
+}
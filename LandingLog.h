@@ -0,0 +1,102 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Landing summaries
+// once the manager stops after a touch down a summary of the landing is appended to a
+// ring of records in a memory mapped file, which other programs can map and read back.
+// the plugin also keeps the mean and 95th percentile of each measurement over the
+// last LANDING_LOG_WINDOW landings of each aircraft profile and logs them, so the
+// effect of changes to the scheduling and the touch down predictor can be seen in
+// real flying. the statistics are carried over from earlier sessions in the file
+// must only be used from the sim thread
+
+#ifndef _LANDING_LOG_H_
+#define _LANDING_LOG_H_
+
+#include <stdint.h>
+#include "StateMachine.h"
+
+// identifies a landing log file, "LTML"
+#define LANDING_LOG_MAGIC   0x4C4D544C
+// version of the file layout
+#define LANDING_LOG_VERSION 2
+// number of records in the ring
+#define LANDING_LOG_CAPACITY 4096
+// number of recent landings of each profile the statistics are taken over
+#define LANDING_LOG_WINDOW 32
+// number of profiles statistics are kept for
+#define LANDING_LOG_MAX_PROFILES 32
+// longest profile name kept in a record, longer names are truncated
+#define LANDING_LOG_PROFILE_SIZE 32
+// flags for landing_record_t Flags
+#define LANDING_LOG_REVERSE_USED      0x01
+// the wheels were already down on the execution that enabled the manager, so the touch
+// down wasn't seen. the touch down measurements aren't made and the landing is left out
+// of the statistics
+#define LANDING_LOG_ENABLED_ON_GROUND 0x02
+// set for each landing_metric_t that was measured, e.g. the reverse delay isn't when
+// reverse thrust wasn't used. a measurement that wasn't made is 0
+#define LANDING_LOG_MEASURED(Metric)  (0x100u << (Metric))
+
+// the measurements of a landing
+typedef enum _landing_metric_t
+{
+  LANDING_METRIC_TOUCHDOWN_AIRSPEED,
+  LANDING_METRIC_TOUCHDOWN_VERTICAL_SPEED,
+  LANDING_METRIC_REVERSE_DELAY,
+  LANDING_METRIC_REVERSE_DURATION,
+  LANDING_METRIC_DISTANCE,
+  LANDING_METRIC_ENABLE_TO_IDLE,
+  LANDING_NUM_METRICS
+} landing_metric_t;
+
+// start of the file
+typedef struct _landing_log_header_t
+{
+  uint32_t Magic;           // LANDING_LOG_MAGIC
+  uint32_t Version;         // LANDING_LOG_VERSION
+  uint32_t RecordSize;      // sizeof(landing_record_t)
+  uint32_t Capacity;        // number of records in the ring
+  uint64_t RecordsWritten;  // total records ever written, the next one goes in slot RecordsWritten % Capacity
+  uint64_t Reserved;
+} landing_log_header_t;
+
+// one landing, times are sim times in seconds. touch down is the main gear reaching the ground
+typedef struct _landing_record_t
+{
+  float    EnableTime;              // when the manager was enabled
+  float    TouchdownTime;
+  float    TouchdownAirspeed;       // knots
+  float    TouchdownVerticalSpeed;  // meters per second, negative when descending
+  float    ReverseDelay;            // seconds from touch down to reverse thrust
+  float    ReverseDuration;         // seconds reverse thrust was held for
+  float    Distance;                // meters rolled from touch down until the manager stopped
+  float    EnableToIdle;            // seconds from enabling to the throttle being at idle
+  uint32_t Flags;                   // LANDING_LOG_* flags, including which measurements were made
+  char     Profile[LANDING_LOG_PROFILE_SIZE];   // name of the aircraft profile, terminated
+} landing_record_t;
+
+// statistics of one measurement
+typedef struct _landing_stats_t
+{
+  int   NumLandings;        // number of landings the statistics are over, up to LANDING_LOG_WINDOW
+  float Mean;
+  float P95;                // 95th percentile
+} landing_stats_t;
+
+// the sim values each execution needs to read for the summary
+#define LANDING_LOG_SNAPSHOT_FIELDS (SNAPSHOT_SIM_TIME | SNAPSHOT_INDICATED_AIRSPEED | SNAPSHOT_ALL_WHEELS_ON_GROUND | SNAPSHOT_GROUND_SPEED)
+
+// opens or creates the landing log at Path and picks up the statistics of the landings in it
+// returns true for success, without a file the statistics are still kept for this session
+extern bool LandingLog_Open(const char *Path);
+// follows the landing after an execution of a state machine, Profile is the name of
+// the aircraft profile in use
+extern void LandingLog_Update(const state_machine_t *Machine, const char *Profile);
+// gets the statistics of a measurement over the recent landings of a profile
+// returns false if there are none
+extern bool LandingLog_GetStats(const char *Profile, landing_metric_t Metric, landing_stats_t *Stats);
+// closes the landing log
+extern void LandingLog_Close(void);
+
+#endif // _LANDING_LOG_H_
@@ -0,0 +1,365 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Asynchronous diagnostic logger, see Logger.h
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "Logger.h"
+
+// number of records in the ring, must be a power of two
+#define LOGGER_RING_SIZE 1024
+// time the background thread waits between batches, in milliseconds
+#define LOGGER_FLUSH_INTERVAL_MS 100
+// size of the buffer the background thread formats a batch into
+#define LOGGER_BATCH_SIZE 16384
+// longest formatted line
+#define LOGGER_LINE_SIZE 512
+
+// the ring. Head is only written by the sim thread and Tail only by the background thread
+static logger_record_t Ring[LOGGER_RING_SIZE];
+static std::atomic<uint32_t> Head(0);
+static std::atomic<uint32_t> Tail(0);
+// number of records dropped since the background thread last reported it, and in total
+static std::atomic<uint32_t> Dropped(0);
+static std::atomic<uint32_t> TotalDropped(0);
+
+// the background thread and the file it writes to
+static std::thread Writer;
+static std::atomic<bool> Running(false);
+// wakes the background thread early when stopping, only taken by the background thread
+// and Logger_Stop so logging never waits for it
+static std::mutex WakeLock;
+static std::condition_variable Wake;
+static FILE *LogFile = NULL;
+static std::chrono::steady_clock::time_point StartTime;
+
+// the least severe level that is written
+log_level_t LoggerLevel = (log_level_t)LOG_LEVEL_FLOOR;
+
+// user friendly names of the levels, indexed by log_level_t
+static const char *LevelNames[] =
+{
+  "Errors only",
+  "Information",
+  "Trace"
+};
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// INTERNAL FUNCTIONS
+
+// appends one argument to a line using a single printf conversion specification
+// the length modifiers of the specification are ignored as the type of the argument
+// is known from the record. returns the number of characters added
+static int FormatArg
+  (
+  const logger_record_t *Record,
+  const logger_arg_t *Arg,  // the argument or NULL if there are too few arguments
+  char *Spec,               // specification without length modifiers, room for three more characters
+  int SpecLength,
+  char Conversion,
+  char *Out,
+  int Size
+  )
+{
+  int Written = 0;
+
+  if (Arg == NULL) return snprintf(Out, Size, "?");
+
+  long long IntValue = (Arg->Type == LOGGER_ARG_DOUBLE) ? (long long)Arg->Value.Double : (long long)Arg->Value.Int;
+  double DoubleValue = (Arg->Type == LOGGER_ARG_DOUBLE) ? Arg->Value.Double : (double)Arg->Value.Int;
+
+  switch (Conversion)
+  {
+    case 'd':
+    case 'i':
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+      Spec[SpecLength++] = 'l';
+      Spec[SpecLength++] = 'l';
+      Spec[SpecLength++] = Conversion;
+      Spec[SpecLength] = '\0';
+      Written = snprintf(Out, Size, Spec, IntValue);
+      break;
+
+    case 'c':
+      Spec[SpecLength++] = Conversion;
+      Spec[SpecLength] = '\0';
+      Written = snprintf(Out, Size, Spec, (int)IntValue);
+      break;
+
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+      Spec[SpecLength++] = Conversion;
+      Spec[SpecLength] = '\0';
+      Written = snprintf(Out, Size, Spec, DoubleValue);
+      break;
+
+    case 's':
+      Spec[SpecLength++] = Conversion;
+      Spec[SpecLength] = '\0';
+      Written = snprintf(Out, Size, Spec, (Arg->Type == LOGGER_ARG_TEXT) ? &Record->Text[Arg->Value.TextOffset] : "?");
+      break;
+
+    default:
+      break;
+  }
+
+  if (Written < 0) return 0;
+  if (Written >= Size) return Size - 1;
+  return Written;
+}
+
+// formats a record into a line of text
+// returns the length of the line
+static int FormatRecord
+  (
+  const logger_record_t *Record,
+  char *Out,
+  int Size
+  )
+{
+  int Used = snprintf(Out, Size, "[%10.3f] ", Record->Timestamp / 1000000000.0);
+  int NextArg = 0;
+  const char *f = Record->Format;
+
+  while ((*f != '\0') && (Used < Size - 1))
+  {
+    if (*f != '%')
+    {
+      Out[Used++] = *f++;
+      continue;
+    }
+
+    f++;
+    if (*f == '%')
+    {
+      Out[Used++] = *f++;
+      continue;
+    }
+
+    // flags, width and precision
+    char Spec[32];
+    int SpecLength = 0;
+    Spec[SpecLength++] = '%';
+    while ((*f != '\0') && (strchr("-+ #0123456789.", *f) != NULL) && (SpecLength < 24)) Spec[SpecLength++] = *f++;
+    // length modifiers
+    while ((*f != '\0') && (strchr("hlLjzt", *f) != NULL)) f++;
+    if (*f == '\0') break;
+    char Conversion = *f++;
+
+    const logger_arg_t *Arg = (NextArg < Record->NumArgs) ? &Record->Args[NextArg] : NULL;
+    NextArg++;
+    Used += FormatArg(Record, Arg, Spec, SpecLength, Conversion, &Out[Used], Size - Used);
+  }
+
+  Out[Used] = '\0';
+  return Used;
+}
+
+// formats and writes out everything in the ring
+static void Drain
+  (
+  void
+  )
+{
+  static char Batch[LOGGER_BATCH_SIZE];
+  char Line[LOGGER_LINE_SIZE];
+  int BatchUsed = 0;
+
+  uint32_t t = Tail.load(std::memory_order_relaxed);
+  uint32_t h = Head.load(std::memory_order_acquire);
+
+  while (t != h)
+  {
+    int Length = FormatRecord(&Ring[t & (LOGGER_RING_SIZE - 1)], Line, LOGGER_LINE_SIZE);
+    // the record has been copied out so the sim thread can have it back
+    Tail.store(++t, std::memory_order_release);
+
+    if (BatchUsed + Length > LOGGER_BATCH_SIZE)
+    {
+      fwrite(Batch, 1, BatchUsed, LogFile);
+      BatchUsed = 0;
+    }
+    memcpy(&Batch[BatchUsed], Line, Length);
+    BatchUsed += Length;
+
+    if (t == h) h = Head.load(std::memory_order_acquire);
+  }
+
+  uint32_t NewlyDropped = Dropped.exchange(0, std::memory_order_relaxed);
+  if (NewlyDropped > 0)
+  {
+    int Length = snprintf(Line, LOGGER_LINE_SIZE, "Log ring full, %u records dropped\n", NewlyDropped);
+    if (BatchUsed + Length > LOGGER_BATCH_SIZE)
+    {
+      fwrite(Batch, 1, BatchUsed, LogFile);
+      BatchUsed = 0;
+    }
+    memcpy(&Batch[BatchUsed], Line, Length);
+    BatchUsed += Length;
+  }
+
+  if (BatchUsed > 0)
+  {
+    fwrite(Batch, 1, BatchUsed, LogFile);
+    fflush(LogFile);
+  }
+}
+
+// body of the background thread
+static void WriterThread
+  (
+  void
+  )
+{
+  std::unique_lock<std::mutex> Lock(WakeLock);
+  while (Running.load(std::memory_order_acquire))
+  {
+    Drain();
+    Wake.wait_for(Lock, std::chrono::milliseconds(LOGGER_FLUSH_INTERVAL_MS), []{ return !Running.load(std::memory_order_acquire); });
+  }
+
+  // pick up anything queued while stopping
+  Drain();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// LOGGER API
+
+// starts the background thread writing to the log file at Path
+// returns true for success
+bool Logger_Start
+  (
+  const char *Path
+  )
+{
+  if (Running.load()) return true;
+
+  LogFile = fopen(Path, "w");
+  if (LogFile == NULL) return false;
+
+  StartTime = std::chrono::steady_clock::now();
+  Head.store(0);
+  Tail.store(0);
+  Dropped.store(0);
+  TotalDropped.store(0);
+
+  Running.store(true);
+  Writer = std::thread(WriterThread);
+
+  return true;
+}
+
+// writes out everything still in the ring and stops the background thread
+void Logger_Stop
+  (
+  void
+  )
+{
+  if (!Running.load()) return;
+
+  {
+    std::lock_guard<std::mutex> Lock(WakeLock);
+    Running.store(false, std::memory_order_release);
+  }
+  Wake.notify_one();
+  if (Writer.joinable()) Writer.join();
+
+  fclose(LogFile);
+  LogFile = NULL;
+}
+
+// returns the total number of records dropped because the ring was full
+uint32_t Logger_GetDroppedCount
+  (
+  void
+  )
+{
+  return TotalDropped.load(std::memory_order_relaxed);
+}
+
+// returns the number of records waiting for the background thread
+uint32_t Logger_GetPendingCount
+  (
+  void
+  )
+{
+  return Head.load(std::memory_order_acquire) - Tail.load(std::memory_order_acquire);
+}
+
+// sets the least severe level that is written, limited to LOG_LEVEL_FLOOR
+void Logger_SetLevel
+  (
+  log_level_t Level
+  )
+{
+  if (Level > LOG_LEVEL_FLOOR) Level = (log_level_t)LOG_LEVEL_FLOOR;
+  LoggerLevel = Level;
+}
+
+// returns the least severe level that is written
+log_level_t Logger_GetLevel
+  (
+  void
+  )
+{
+  return LoggerLevel;
+}
+
+// returns a user friendly name for a level
+const char *Logger_GetLevelName
+  (
+  log_level_t Level
+  )
+{
+  return LevelNames[Level];
+}
+
+// claims the next free record in the ring
+// returns NULL if the logger isn't running or the ring is full
+logger_record_t *Logger_BeginRecord
+  (
+  const char *Format
+  )
+{
+  if (!Running.load(std::memory_order_relaxed)) return NULL;
+
+  uint32_t h = Head.load(std::memory_order_relaxed);
+  if (h - Tail.load(std::memory_order_acquire) >= LOGGER_RING_SIZE)
+  {
+    Dropped.fetch_add(1, std::memory_order_relaxed);
+    TotalDropped.fetch_add(1, std::memory_order_relaxed);
+    return NULL;
+  }
+
+  logger_record_t *Record = &Ring[h & (LOGGER_RING_SIZE - 1)];
+  Record->Timestamp = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - StartTime).count();
+  Record->Format = Format;
+  Record->NumArgs = 0;
+  Record->TextUsed = 0;
+
+  return Record;
+}
+
+// hands the record claimed by Logger_BeginRecord to the background thread
+void Logger_CommitRecord
+  (
+  void
+  )
+{
+  Head.store(Head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
@@ -0,0 +1,236 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Asynchronous diagnostic logger
+// the sim thread only copies a small binary record (timestamp, format, arguments)
+// into a lock-free single producer, single consumer ring. a background thread
+// formats the records and writes them to the log file in batches.
+// if the ring is full the record is dropped and counted, the sim never waits
+//
+// use LOG_ERROR, LOG_INFO and LOG_TRACE to write messages. messages less severe than
+// LOG_LEVEL_FLOOR are compiled out entirely, the rest are filtered by a level that
+// can be changed at runtime
+
+#ifndef _LOGGER_H_
+#define _LOGGER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// maximum number of arguments in one record
+#define LOGGER_MAX_ARGS 6
+// space in each record for copies of string arguments
+#define LOGGER_TEXT_SIZE 96
+
+// log levels, most severe first
+typedef enum _log_level_t
+{
+  LOG_LEVEL_ERROR,
+  LOG_LEVEL_INFO,
+  LOG_LEVEL_TRACE
+} log_level_t;
+
+// the least severe level that is compiled in, define it in the build to override
+#ifndef LOG_LEVEL_FLOOR
+#ifdef NDEBUG
+#define LOG_LEVEL_FLOOR LOG_LEVEL_INFO
+#else
+#define LOG_LEVEL_FLOOR LOG_LEVEL_TRACE
+#endif
+#endif // LOG_LEVEL_FLOOR
+
+// types of argument that can be stored in a record
+typedef enum _logger_arg_type_t
+{
+  LOGGER_ARG_INT,
+  LOGGER_ARG_DOUBLE,
+  LOGGER_ARG_TEXT
+} logger_arg_type_t;
+
+// one argument of a record
+typedef struct _logger_arg_t
+{
+  logger_arg_type_t Type;
+  union
+  {
+    int64_t  Int;
+    double   Double;
+    uint32_t TextOffset;    // offset of the string in the record text
+  } Value;
+} logger_arg_t;
+
+// one entry in the ring
+typedef struct _logger_record_t
+{
+  uint64_t     Timestamp;   // nanoseconds since the logger was started
+  const char  *Format;      // printf style format, must be a string literal as it identifies the message
+  int          NumArgs;
+  int          TextUsed;
+  logger_arg_t Args[LOGGER_MAX_ARGS];
+  char         Text[LOGGER_TEXT_SIZE];
+} logger_record_t;
+
+// starts the background thread writing to the log file at Path
+// returns true for success
+extern bool Logger_Start(const char *Path);
+// writes out everything still in the ring and stops the background thread
+extern void Logger_Stop(void);
+// returns the total number of records dropped because the ring was full
+extern uint32_t Logger_GetDroppedCount(void);
+// returns the number of records waiting for the background thread
+extern uint32_t Logger_GetPendingCount(void);
+// sets the least severe level that is written, limited to LOG_LEVEL_FLOOR
+extern void Logger_SetLevel(log_level_t Level);
+// returns the least severe level that is written
+extern log_level_t Logger_GetLevel(void);
+// returns a user friendly name for a level
+extern const char *Logger_GetLevelName(log_level_t Level);
+
+// the least severe level that is written, only used by the sim thread
+extern log_level_t LoggerLevel;
+
+// claims the next free record in the ring
+// returns NULL if the logger isn't running or the ring is full
+extern logger_record_t *Logger_BeginRecord(const char *Format);
+// hands the record claimed by Logger_BeginRecord to the background thread
+extern void Logger_CommitRecord(void);
+
+// stores one argument in a record, arguments that don't fit are ignored
+static inline void Logger_AddInt(logger_record_t *Record, int64_t Value)
+{
+  if (Record->NumArgs >= LOGGER_MAX_ARGS) return;
+  Record->Args[Record->NumArgs].Type = LOGGER_ARG_INT;
+  Record->Args[Record->NumArgs++].Value.Int = Value;
+}
+
+static inline void Logger_AddDouble(logger_record_t *Record, double Value)
+{
+  if (Record->NumArgs >= LOGGER_MAX_ARGS) return;
+  Record->Args[Record->NumArgs].Type = LOGGER_ARG_DOUBLE;
+  Record->Args[Record->NumArgs++].Value.Double = Value;
+}
+
+// strings are copied as the caller's buffer may not live until the record is formatted.
+// TextArgs is the number of strings still to be added to the record including this one,
+// each string is truncated to its share of the space left so a long string can't leave
+// the ones after it empty. space a short string doesn't use is shared by the ones after
+static inline void Logger_AddText(logger_record_t *Record, const char *Value, int TextArgs)
+{
+  if (Record->NumArgs >= LOGGER_MAX_ARGS) return;
+  Record->Args[Record->NumArgs].Type = LOGGER_ARG_TEXT;
+  if (Record->TextUsed >= LOGGER_TEXT_SIZE)
+  {
+    // the last byte is the terminator of the string that filled the space
+    Record->Args[Record->NumArgs++].Value.TextOffset = LOGGER_TEXT_SIZE - 1;
+    return;
+  }
+  Record->Args[Record->NumArgs++].Value.TextOffset = Record->TextUsed;
+  int Share = (LOGGER_TEXT_SIZE - Record->TextUsed) / ((TextArgs > 1) ? TextArgs : 1);
+  // the share always has room for the terminator
+  int End = Record->TextUsed + ((Share > 1) ? Share : 1) - 1;
+  while ((Record->TextUsed < End) && (Value != NULL) && (*Value != '\0'))
+  {
+    Record->Text[Record->TextUsed++] = *Value++;
+  }
+  Record->Text[Record->TextUsed++] = '\0';
+}
+
+// counts the strings in a list of argument types
+template <typename... Args>
+struct Logger_TextCount
+{
+  enum { Value = 0 };
+};
+
+template <typename T, typename... Rest>
+struct Logger_TextCount<T, Rest...>
+{
+  enum { Value = Logger_TextCount<Rest...>::Value };
+};
+
+template <typename... Rest>
+struct Logger_TextCount<const char *, Rest...>
+{
+  enum { Value = 1 + Logger_TextCount<Rest...>::Value };
+};
+
+template <typename... Rest>
+struct Logger_TextCount<char *, Rest...>
+{
+  enum { Value = 1 + Logger_TextCount<Rest...>::Value };
+};
+
+static inline void Logger_AddArg(logger_record_t *Record, int Value)                { Logger_AddInt(Record, Value); }
+static inline void Logger_AddArg(logger_record_t *Record, unsigned int Value)       { Logger_AddInt(Record, Value); }
+static inline void Logger_AddArg(logger_record_t *Record, long Value)               { Logger_AddInt(Record, Value); }
+static inline void Logger_AddArg(logger_record_t *Record, unsigned long Value)      { Logger_AddInt(Record, (int64_t)Value); }
+static inline void Logger_AddArg(logger_record_t *Record, long long Value)          { Logger_AddInt(Record, Value); }
+static inline void Logger_AddArg(logger_record_t *Record, unsigned long long Value) { Logger_AddInt(Record, (int64_t)Value); }
+static inline void Logger_AddArg(logger_record_t *Record, double Value)             { Logger_AddDouble(Record, Value); }
+
+static inline void Logger_AddArgs(logger_record_t *Record)
+{
+}
+
+template <typename T, typename... Rest>
+static inline void Logger_AddArgs(logger_record_t *Record, T First, Rest... Others)
+{
+  Logger_AddArg(Record, First);
+  Logger_AddArgs(Record, Others...);
+}
+
+// strings are told how many strings come after them to work out their share of the text
+template <typename... Rest>
+static inline void Logger_AddArgs(logger_record_t *Record, const char *First, Rest... Others)
+{
+  Logger_AddText(Record, First, 1 + Logger_TextCount<Rest...>::Value);
+  Logger_AddArgs(Record, Others...);
+}
+
+template <typename... Rest>
+static inline void Logger_AddArgs(logger_record_t *Record, char *First, Rest... Others)
+{
+  Logger_AddText(Record, First, 1 + Logger_TextCount<Rest...>::Value);
+  Logger_AddArgs(Record, Others...);
+}
+
+// queues a diagnostic line for the log file
+// accepts the same arguments as printf, the format must be a string literal
+// must only be called from the sim thread
+template <typename... Args>
+static inline void Logger_Write(const char *Format, Args... Arguments)
+{
+  logger_record_t *Record = Logger_BeginRecord(Format);
+  if (Record == NULL) return;
+
+  Logger_AddArgs(Record, Arguments...);
+  Logger_CommitRecord();
+}
+
+// writes messages at a level that is compiled in, filtered by the runtime level
+template <log_level_t Level, bool CompiledIn = (Level <= LOG_LEVEL_FLOOR)>
+struct Logger_Facade
+{
+  template <typename... Args>
+  static inline void Write(const char *Format, Args... Arguments)
+  {
+    if (Level > LoggerLevel) return;
+    Logger_Write(Format, Arguments...);
+  }
+};
+
+// messages at a level that isn't compiled in generate no code at all
+template <log_level_t Level>
+struct Logger_Facade<Level, false>
+{
+  template <typename... Args>
+  static inline void Write(const char *Format, Args... Arguments)
+  {
+  }
+};
+
+#define LOG_ERROR(...) Logger_Facade<LOG_LEVEL_ERROR>::Write(__VA_ARGS__)
+#define LOG_INFO(...)  Logger_Facade<LOG_LEVEL_INFO>::Write(__VA_ARGS__)
+#define LOG_TRACE(...) Logger_Facade<LOG_LEVEL_TRACE>::Write(__VA_ARGS__)
+
+#endif // _LOGGER_H_
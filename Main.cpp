@@ -21,11 +21,24 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <sys/stat.h>
 #include "XPLMDataAccess.h"
 #include "XPLMMenus.h"
 #include "XPLMProcessing.h"
 #include "XPLMUtilities.h"
 #include "XPLMPlugin.h"
+#include "XPLMPlanes.h"
+#include "Aircraft.h"
+#include "ArmingMonitor.h"
+#include "Logger.h"
+#include "Perf.h"
+#include "SharedStatus.h"
+#include "LandingLog.h"
+#include "StateMachine.h"
+#include "StatusDatarefs.h"
+#include "Telemetry.h"
+#include "Traffic.h"
+#include "Voice.h"
 
 // basic plugin information
 #define PLUGIN_NAME "Landing Throttle Manager"
@@ -33,108 +46,521 @@
 #define PLUGIN_VERSION_MINOR 1
 #define PLUGIN_VERSION_DOT   0
 #define PLUGIN_COPYRIGHT "(C) andy@britishideas.com 2022"
+#define PLUGIN_SIGNATURE "britishideas.assistants.landingthrottlemanager"
 
-// configuration section
-// minimum speed in knots at which the reverse thrust can be enabled
-#define MIN_SPEED_REVERSE_THRUST 60.0f
-// maximum speed in knots at which the manager can be enabled
-#define MAX_AIRSPEED 160.0f
-// minimum flap angle at which the manager can be enabled
-#define MIN_FLAP_ANGLE 18.0f
-// maximum height above ground in meters at which the manager can be enabled
-#define MAX_ALTITUDE 152.4f
-
-// time between executions of the state machine, in seconds
-#define STATE_MACHINE_EXECUTION_INTERVAL 0.25f
-// the ratio of the gears when they are down
-#define GEAR_DOWN_RATIO 1.0f
-// set to 1 to enable diagnostic output to Log.txt
-#define DIAGNOSTIC 1
+// name of the diagnostic log file in the plugin folder
+#define LOG_FILE_NAME "LandingThrottleManager.log"
+// name of the telemetry recording in the plugin folder
+#define TELEMETRY_FILE_NAME "LandingThrottleManager.telemetry"
+// name of the status file shared with external programs, in the plugin folder
+#define SHARED_STATUS_FILE_NAME "LandingThrottleManager.status"
+// summaries of the landings
+#define LANDING_LOG_FILE_NAME "LandingThrottleManager.landings"
+// name of the aircraft profiles file in the plugin folder
+#define PROFILES_FILE_NAME "LandingThrottleManager.profiles"
+// time between checks of the profiles file for changes, in seconds
+#define PROFILES_CHECK_INTERVAL 2.0f
+// values of the reverser mode dataref, sim/cockpit2/engine/actuators/prop_mode
+#define REVERSER_MODE_NORMAL  1
+#define REVERSER_MODE_REVERSE 3
 
 // menu item IDs
-#define MENU_ITEM_ID_ENABLE 1
-#define MENU_ITEM_ID_STOP   2
-
-// state machine states
-typedef enum _states_t
-{
-  WAIT_FOR_USER,
-  START,
-  THROTTLE_DOWN,
-  WAIT_FOR_IDLE_THROTTLE,
-  WAIT_FOR_TOUCHDOWN,
-  APPLY_REVERSE,
-  WAIT_FOR_END_OF_REVERSE
-} states_t;
-
-// identifiers of known aircraft
-typedef enum _aircraft_id_t
-{
-  AIRCRAFT_UNKNOWN,
-  AIRCRAFT_XCRAFTS_ERJ_FAMILY
-} aircraft_id_t;
-
-// describes a know aircraft
-typedef struct _known_aircraft_t
-{
-  aircraft_id_t Id;
-  char *DescriptionMatch;
-  char *UserFriendlyName;
-} known_aircraft_t;
+#define MENU_ITEM_ID_ENABLE    1
+#define MENU_ITEM_ID_STOP      2
+// log level menu item IDs are this plus the log_level_t
+#define MENU_ITEM_ID_LOG_LEVEL 100
+// reverse thrust menu item IDs are this plus the reverse_target_t
+#define MENU_ITEM_ID_REVERSE_TARGET 200
+#define MENU_ITEM_ID_ARMING_MONITOR 300
+#define MENU_ITEM_ID_AUTO_ARM       301
+#define MENU_ITEM_ID_TRAFFIC        400
 
 // commands and data references that we need
 static XPLMCommandRef ReverseThrustCmd       = NULL;
 static XPLMCommandRef ThrottleDownCmd        = NULL;
 static XPLMDataRef    ThrottleRatioRef       = NULL;
 static XPLMDataRef    IndicatedAirSpeedRef   = NULL;
-static XPLMDataRef    AllWheelsOnGroundRef   = NULL;
+static XPLMDataRef    GearOnGroundRef        = NULL;
 static XPLMDataRef    FlapsAngleRef          = NULL;
 static XPLMDataRef    GearDeployRatioRef     = NULL;
 static XPLMDataRef    AltitudeAboveGroundRef = NULL;
+static XPLMDataRef    EngineThrottleRatioRef = NULL;
+static XPLMDataRef    NumEnginesRef          = NULL;
+static XPLMDataRef    GroundSpeedRef         = NULL;
+static XPLMDataRef    ReverserModeRef        = NULL;
+static XPLMCommandRef MainsDownCmd           = NULL;
+static XPLMDataRef    SimTimeRef             = NULL;
+static XPLMDataRef    AircraftDescriptionRef = NULL;
+
+// gear layout of the loaded aircraft
+static int NumGears = 0;
+static int NoseGear = 0;
+
+// kinds of handle that a profile names
+typedef enum _handle_kind_t
+{
+  HANDLE_KIND_COMMAND,
+  HANDLE_KIND_DATAREF
+} handle_kind_t;
+
+// where a handle named by a profile is bound to
+typedef struct _handle_binding_t
+{
+  handle_kind_t Kind;
+  void **Handle;
+  bool NeededToArm;     // bound when the aircraft is loaded, the rest are bound later
+  bool Optional;        // left NULL if the profile doesn't name it
+} handle_binding_t;
+
+// the handles named by a profile, indexed by aircraft_handle_t
+// the ones needed to arm are those read for SNAPSHOT_ARMING
+static const handle_binding_t HandleBindings[] =
+{
+  {HANDLE_KIND_COMMAND, &ReverseThrustCmd,       false, false},
+  {HANDLE_KIND_COMMAND, &ThrottleDownCmd,        false, false},
+  {HANDLE_KIND_DATAREF, &ThrottleRatioRef,       false, false},
+  {HANDLE_KIND_DATAREF, &IndicatedAirSpeedRef,   true,  false},
+  {HANDLE_KIND_DATAREF, &GearOnGroundRef,        false, false},
+  {HANDLE_KIND_DATAREF, &FlapsAngleRef,          true,  false},
+  {HANDLE_KIND_DATAREF, &GearDeployRatioRef,     true,  false},
+  {HANDLE_KIND_DATAREF, &AltitudeAboveGroundRef, true,  false},
+  {HANDLE_KIND_DATAREF, &EngineThrottleRatioRef, false, false},
+  {HANDLE_KIND_DATAREF, &NumEnginesRef,          false, false},
+  {HANDLE_KIND_DATAREF, &GroundSpeedRef,         false, false},
+  {HANDLE_KIND_DATAREF, &ReverserModeRef,        false, false},
+  {HANDLE_KIND_COMMAND, &MainsDownCmd,           false, true}
+};
+
+// handles found for each profile, kept for the next time the aircraft is loaded
+// NULL if not found yet. indexed by the profile index and aircraft_handle_t
+static void *HandleCache[AIRCRAFT_MAX_PROFILES][AIRCRAFT_NUM_HANDLES];
 
 // custom commands
 static XPLMCommandRef EnableCmd = NULL;
+// our custom command to stop the manager
+static XPLMCommandRef StopCmd = NULL;
+
+// flight loop that executes the state machine
+static XPLMFlightLoopID StateMachineFlightLoop = NULL;
+// manages the user aircraft
+static state_machine_t *UserManager = NULL;
+// flight loop that reloads the profiles file when it changes
+static XPLMFlightLoopID ProfilesFlightLoop = NULL;
+// the profiles file and when it was last modified
+static char ProfilesPath[256];
+static time_t ProfilesModified = 0;
+// set once the user aircraft has been loaded
+static bool UserAircraftLoaded = false;
+// the profile of the user aircraft, NULL if it isn't known
+static const aircraft_profile_t *UserProfile = NULL;
 
-// the current state of the state machine
-static states_t CurrentState = WAIT_FOR_USER;
-// flag to indicate if the user has requested deactivation of the manager
-static bool DeactivationRequested = FALSE;
 // prototype for the function that handles menu choices
 static void	MenuHandlerCallback(void *inMenuRef, void *inItemRef);    
 // flag to indicate if we are ready for use
-static bool Ready = FALSE;
-
-// all the known aircraft
-static _known_aircraft_t KnownAircrafts[] =
+static bool Ready = false;
+// profile of the loaded aircraft until the handles not needed to arm have been bound, otherwise NULL
+static const aircraft_profile_t *DeferredProfile = NULL;
+// submenu for choosing the log level, items are in log_level_t order
+static XPLMMenuID LogLevelMenu = NULL;
+// the plugin menu and the positions in it of the arming monitor options
+static XPLMMenuID PluginMenu = NULL;
+static int ArmingMonitorItem = 0;
+static int AutoArmItem = 0;
+// arming monitor options chosen by the user
+static bool ArmingMonitorEnabled = false;
+static bool AutoArmEnabled = false;
+// the position in the plugin menu of following the multiplayer traffic and if the user chose it
+static int TrafficItem = 0;
+static bool TrafficEnabled = false;
+// submenu for choosing how much reverse thrust to use, items are in reverse_target_t order
+static XPLMMenuID ReverseTargetMenu = NULL;
+// names of the reverse thrust settings, indexed by reverse_target_t
+static const char *ReverseTargetNames[] =
 {
-  {AIRCRAFT_XCRAFTS_ERJ_FAMILY, "x-crafts erj", "X-Crafts ERJ Family"},
+  "Full",
+  "Low",
+  "Medium",
+  "High"
 };
 
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////
 // INTERNAL FUNCTIONS
 
-// prints a diagnostic line to Log.txt
-// accepts the same arguments as printf
-static void Diagnostic_printf
+// determines the currently loaded aircraft
+// returns its profile or NULL if it isn't known
+static const aircraft_profile_t *DetectAircraft
+  (
+  void
+  )
+{
+  PERF_STARTUP_SCOPE(PERF_STARTUP_AIRCRAFT_DETECTION);
+
+  // is a description for the aircraft defined? if not then we can't tell what it is
+  if (AircraftDescriptionRef != NULL)
+  {
+    // get aircraft description, it isn't terminated if it fills the dataref
+    char Description[AIRCRAFT_DESCRIPTION_SIZE];
+    int Size = XPLMGetDatab(AircraftDescriptionRef, (void *)Description, 0, AIRCRAFT_DESCRIPTION_SIZE);
+    return Aircraft_Match(Description, Size);
+  }
+
+  return NULL;
+}
+
+// binds either the commands and datarefs named by a profile that are needed to arm or the
+// rest of them, reusing the handles found the last time the profile was used if they are still good
+// returns true for success, otherwise logs which handle could not be found
+static bool BindHandles
+  (
+  const aircraft_profile_t *Profile,
+  bool NeededToArm
+  )
+{
+  PERF_STARTUP_SCOPE(PERF_STARTUP_HANDLE_RESOLUTION);
+
+  void **Cache = HandleCache[Profile->Index];
+  int Bound = 0;
+  int Lookups = 0;
+
+  for (int h = 0; h < AIRCRAFT_NUM_HANDLES; h++)
+  {
+    const handle_binding_t *Binding = &HandleBindings[h];
+    if (Binding->NeededToArm != NeededToArm) continue;
+
+    if (Binding->Optional && (Profile->HandleNames[h][0] == '\0'))
+    {
+      *Binding->Handle = NULL;
+      continue;
+    }
+
+    // a dataref goes bad when the plugin that provides it is unloaded, e.g. with
+    // the aircraft. commands stay valid for the whole session
+    if ((Cache[h] != NULL) && (Binding->Kind == HANDLE_KIND_DATAREF) && !XPLMIsDataRefGood(Cache[h]))
+    {
+      Cache[h] = NULL;
+    }
+
+    if (Cache[h] == NULL)
+    {
+      Cache[h] = (Binding->Kind == HANDLE_KIND_COMMAND) ? XPLMFindCommand(Profile->HandleNames[h]) : XPLMFindDataRef(Profile->HandleNames[h]);
+      Lookups++;
+    }
+
+    *Binding->Handle = Cache[h];
+    if (Cache[h] == NULL)
+    {
+      LOG_ERROR("Unable to find %s, the %s for %s\n", Profile->HandleNames[h], Aircraft_GetHandleKey((aircraft_handle_t)h), Profile->Name);
+      return false;
+    }
+    Bound++;
+  }
+
+  LOG_INFO("Bound %d commands and datarefs, %d looked up and %d from the cache\n", Bound, Lookups, Bound - Lookups);
+  return true;
+}
+
+// binds the handles that were not needed to arm, if that hasn't been done yet
+// returns true if all the handles of the aircraft are bound
+static bool BindDeferredHandles
+  (
+  void
+  )
+{
+  if (DeferredProfile == NULL) return Ready;
+
+  const aircraft_profile_t *Profile = DeferredProfile;
+  DeferredProfile = NULL;
+
+  if (!BindHandles(Profile, false))
+  {
+    Ready = false;
+    return false;
+  }
+
+  LOG_INFO("Ready to go\n");
+  return true;
+}
+
+// changes the diagnostic log level and shows it in the menu
+static void SetLogLevel
+  (
+  log_level_t Level
+  )
+{
+  Logger_SetLevel(Level);
+
+  for (int Item = LOG_LEVEL_ERROR; Item <= LOG_LEVEL_FLOOR; Item++)
+  {
+    XPLMCheckMenuItem(LogLevelMenu, Item, (Item == Level) ? xplm_Menu_Checked : xplm_Menu_Unchecked);
+  }
+
+  LOG_INFO("Log level is now %s\n", Logger_GetLevelName(Level));
+}
+
+// changes how much reverse thrust is used and shows it in the menu
+static void SetReverseTarget
+  (
+  reverse_target_t Target
+  )
+{
+  StateMachine_SetReverseTarget(UserManager, Target);
+
+  for (int Item = REVERSE_TARGET_FULL; Item < REVERSE_NUM_TARGETS; Item++)
+  {
+    XPLMCheckMenuItem(ReverseTargetMenu, Item, (Item == Target) ? xplm_Menu_Checked : xplm_Menu_Unchecked);
+  }
+
+  LOG_INFO("Reverse thrust is now %s\n", ReverseTargetNames[Target]);
+}
+
+// turns the background check of the landing conditions and auto arming on or off
+// and shows them in the menu, auto arming needs the background check
+static void SetArmingMonitorOptions
+  (
+  bool Monitor,
+  bool AutoArm
+  )
+{
+  ArmingMonitorEnabled = Monitor || AutoArm;
+  AutoArmEnabled = AutoArm;
+  ArmingMonitor_SetOptions(ArmingMonitorEnabled, AutoArmEnabled);
+
+  XPLMCheckMenuItem(PluginMenu, ArmingMonitorItem, ArmingMonitorEnabled ? xplm_Menu_Checked : xplm_Menu_Unchecked);
+  XPLMCheckMenuItem(PluginMenu, AutoArmItem, AutoArmEnabled ? xplm_Menu_Checked : xplm_Menu_Unchecked);
+
+  LOG_INFO("Background check of the landing conditions is %s, auto arm is %s\n", ArmingMonitorEnabled ? "on" : "off", AutoArmEnabled ? "on" : "off");
+}
+
+// turns following the multiplayer traffic on or off and shows it in the menu, it
+// stays off if x-plane doesn't have the datarefs for it
+static void SetTrafficEnabled
+  (
+  bool Enabled
+  )
+{
+  TrafficEnabled = Enabled;
+  Traffic_SetEnabled(Enabled);
+
+  XPLMCheckMenuItem(PluginMenu, TrafficItem, Traffic_IsEnabled() ? xplm_Menu_Checked : xplm_Menu_Unchecked);
+
+  LOG_INFO("Following the multiplayer traffic is %s\n", Traffic_IsEnabled() ? "on" : "off");
+}
+
+// gets the folder that the plugin is installed in, with a trailing directory separator
+static void GetPluginFolder
+  (
+  char *Folder    // on return filled with the path, must be at least 256 characters
+  )
+{
+  XPLMGetPluginInfo(XPLMGetMyID(), NULL, Folder, NULL, NULL);
+
+  // remove the file name and the 64 folder
+  const char *Separator = XPLMGetDirectorySeparator();
+  for (int Level = 0; Level < 2; Level++)
+  {
+    char *End = strrchr(Folder, Separator[0]);
+    if (End != NULL) *End = '\0';
+  }
+  strncat(Folder, Separator, 256 - strlen(Folder) - 1);
+}
+
+// gets when a file was last modified
+// returns 0 if the file doesn't exist
+static time_t GetFileTime
+  (
+  const char *Path
+  )
+{
+  struct stat Info;
+  if (stat(Path, &Info) != 0) return 0;
+  return Info.st_mtime;
+}
+
+// reads the requested values from the sim into a snapshot
+// this is the only place the state machine and arming check read sim data
+static void ReadSimSnapshot
+  (
+  void *Refcon,           // not used, this is only for the user aircraft
+  sim_snapshot_t *Snap,   // snapshot to fill in
+  int Fields              // SNAPSHOT_* flags of the values to read
+  )
+{
+  Snap->Fields = Fields;
+
+  if (Fields & SNAPSHOT_INDICATED_AIRSPEED)    Snap->IndicatedAirSpeed   = XPLMGetDataf(IndicatedAirSpeedRef);
+  if (Fields & SNAPSHOT_THROTTLE_RATIO)        Snap->ThrottleRatio       = XPLMGetDataf(ThrottleRatioRef);
+  if (Fields & SNAPSHOT_FLAP_ANGLE)            XPLMGetDatavf(FlapsAngleRef, &Snap->FlapAngle, 0, 1);
+  if (Fields & SNAPSHOT_GEAR_DEPLOY_RATIO)     XPLMGetDatavf(GearDeployRatioRef, &Snap->GearDeployRatio, 0, 1);
+  if (Fields & SNAPSHOT_ALTITUDE_ABOVE_GROUND) Snap->AltitudeAboveGround = XPLMGetDataf(AltitudeAboveGroundRef);
+  if (Fields & SNAPSHOT_SIM_TIME)              Snap->SimTime             = XPLMGetDataf(SimTimeRef);
+  if (Fields & SNAPSHOT_GROUND_SPEED)          Snap->GroundSpeed         = XPLMGetDataf(GroundSpeedRef);
+
+  // every gear in one read
+  if (Fields & SNAPSHOT_ALL_WHEELS_ON_GROUND)
+  {
+    int OnGround[SIM_MAX_GEARS];
+    int Read = XPLMGetDatavi(GearOnGroundRef, OnGround, 0, NumGears);
+
+    Snap->MainGearOnGround = (Read == NumGears) ? 1 : 0;
+    for (int g = 0; g < Read; g++)
+    {
+      if ((g != NoseGear) && (OnGround[g] == 0)) Snap->MainGearOnGround = 0;
+    }
+    Snap->AllWheelsOnGround = ((Snap->MainGearOnGround != 0) && ((NoseGear >= Read) || (OnGround[NoseGear] != 0))) ? 1 : 0;
+  }
+
+  // every engine in one read
+  if (Fields & SNAPSHOT_ENGINE_THROTTLE_RATIO)
+  {
+    int NumEngines = XPLMGetDatai(NumEnginesRef);
+    if (NumEngines > SIM_MAX_ENGINES) NumEngines = SIM_MAX_ENGINES;
+    if (NumEngines < 0) NumEngines = 0;
+    Snap->NumEngines = XPLMGetDatavf(EngineThrottleRatioRef, Snap->EngineThrottleRatio, 0, NumEngines);
+  }
+}
+
+// sets the reverser mode of every engine, in one write
+static void SetReverserModes
+  (
+  int Mode
+  )
+{
+  int NumEngines = XPLMGetDatai(NumEnginesRef);
+  if (NumEngines > SIM_MAX_ENGINES) NumEngines = SIM_MAX_ENGINES;
+  if (NumEngines < 0) NumEngines = 0;
+
+  int Modes[SIM_MAX_ENGINES];
+  for (int e = 0; e < NumEngines; e++) Modes[e] = Mode;
+  XPLMSetDatavi(ReverserModeRef, Modes, 0, NumEngines);
+}
+
+// starts holding a command, deploying the reversers is done by writing their mode
+static void SimCommandBegin
+  (
+  void *Refcon,
+  manager_command_t Command
+  )
+{
+  if (Command == COMMAND_REVERSE_DEPLOY)
+  {
+    SetReverserModes(REVERSER_MODE_REVERSE);
+    return;
+  }
+  XPLMCommandBegin((Command == COMMAND_THROTTLE_DOWN) ? ThrottleDownCmd : ReverseThrustCmd);
+}
+
+// stops holding a command, the reversers are stowed by writing their mode
+static void SimCommandEnd
+  (
+  void *Refcon,
+  manager_command_t Command
+  )
+{
+  if (Command == COMMAND_REVERSE_DEPLOY)
+  {
+    SetReverserModes(REVERSER_MODE_NORMAL);
+    return;
+  }
+  XPLMCommandEnd((Command == COMMAND_THROTTLE_DOWN) ? ThrottleDownCmd : ReverseThrustCmd);
+}
+
+// issues a command once, commands the profile doesn't name are ignored
+static void SimCommandOnce
+  (
+  void *Refcon,
+  manager_command_t Command
+  )
+{
+  if ((Command == COMMAND_MAINS_DOWN) && (MainsDownCmd != NULL)) XPLMCommandOnce(MainsDownCmd);
+}
+
+// gives voice guidance to the user, it is said from the voice flight loop
+static void SimSpeak
+  (
+  void *Refcon,
+  const char *Message,
+  speech_priority_t Priority
+  )
+{
+  Voice_Say(Message, Priority);
+}
+
+// sets the throttle of the first NumEngines engines, in one write
+static void SimSetEngineThrottles
+  (
+  void *Refcon,
+  const float *Ratios,
+  int NumEngines
+  )
+{
+  XPLMSetDatavf(EngineThrottleRatioRef, (float *)Ratios, 0, NumEngines);
+}
+
+// connects the state machine to x-plane
+static const sim_interface_t XPlaneSim =
+{
+  ReadSimSnapshot,
+  SimCommandBegin,
+  SimCommandEnd,
+  SimCommandOnce,
+  SimSpeak,
+  SimSetEngineThrottles
+};
+
+// adds the current execution of the state machine to the telemetry recording
+static void RecordTelemetry
+  (
+  void
+  )
+{
+  const sim_snapshot_t *Snapshot = StateMachine_GetSnapshot(UserManager);
+  int Commands = StateMachine_GetActiveCommands(UserManager);
+  telemetry_frame_t Frame;
+
+  Frame.SimTime             = Snapshot->SimTime;
+  Frame.IndicatedAirSpeed   = Snapshot->IndicatedAirSpeed;
+  Frame.ThrottleRatio       = Snapshot->ThrottleRatio;
+  Frame.AltitudeAboveGround = Snapshot->AltitudeAboveGround;
+  Frame.FlapAngle           = Snapshot->FlapAngle;
+  Frame.GearDeployRatio     = Snapshot->GearDeployRatio;
+  Frame.AllWheelsOnGround   = (Snapshot->AllWheelsOnGround != 0) ? 1 : 0;
+  Frame.MainGearOnGround    = (Snapshot->MainGearOnGround != 0) ? 1 : 0;
+  Frame.Fields              = (uint16_t)Snapshot->Fields;
+  Frame.NumEngines          = (uint8_t)((Snapshot->NumEngines < TELEMETRY_MAX_ENGINES) ? Snapshot->NumEngines : TELEMETRY_MAX_ENGINES);
+  Frame.Reserved            = 0;
+  Frame.GroundSpeed         = Snapshot->GroundSpeed;
+  for (int e = 0; e < TELEMETRY_MAX_ENGINES; e++)
+  {
+    Frame.EngineThrottleRatio[e] = (e < Frame.NumEngines) ? Snapshot->EngineThrottleRatio[e] : 0;
+  }
+  Frame.State               = (uint8_t)StateMachine_GetState(UserManager);
+  Frame.Commands            = 0;
+  if (Commands & COMMAND_THROTTLE_DOWN)  Frame.Commands |= TELEMETRY_COMMAND_THROTTLE_DOWN;
+  if (Commands & REVERSE_COMMANDS)      Frame.Commands |= TELEMETRY_COMMAND_REVERSE_THRUST;
+
+  Telemetry_Record(&Frame);
+}
+
+// called after each execution of a state machine
+static void ManagerExecuted
   (
-  char *str,
-  ...
+  state_machine_t *Machine
   )
 {
-  va_list lst;
-  char line[256];
+  // the traffic is only published as datarefs, which are read from the state machines
+  if (Machine != UserManager) return;
 
-  va_start(lst, str);
-  vsprintf_s(line, 256, str, lst);
-  XPLMDebugString(PLUGIN_NAME);
-  XPLMDebugString(": ");
-  XPLMDebugString(line);
-  va_end(lst);
+  RecordTelemetry();
+  SharedStatus_Publish(UserManager);
+  StatusDatarefs_Update();
+  if (UserProfile != NULL) LandingLog_Update(UserManager, UserProfile->Name);
+  // the landing is over so get the recording onto disk
+  if (StateMachine_GetState(UserManager) == WAIT_FOR_USER) Telemetry_Flush();
 }
 
-// execute the state machine, called periodically by x-plane
-// returns the number of seconds to the next execution
+// execute the state machines that are due, called periodically by x-plane
+// returns the number of seconds to the next execution, or a negative number of frames
 static float StateMachine
   (
   float elapsedMe,
@@ -143,150 +569,23 @@ static float StateMachine
   void *refcon
   )
 {
-  if (Ready == FALSE) return STATE_MACHINE_EXECUTION_INTERVAL;
-
-  switch (CurrentState)
-  {
-    // the current state needs to be set to START to exit
-    // this state
-    case WAIT_FOR_USER:
-      break;
-
-    // start the manager
-    case START:
-      {
-        float ThrottleRatio = XPLMGetDataf(ThrottleRatioRef);
-
-        if (ThrottleRatio > 0)
-        {
-          CurrentState = THROTTLE_DOWN;
-  #if DIAGNOSTIC == 1
-          Diagnostic_printf("Going to throttle down as we are not at idle throttle\n");
-  #endif // DIAGNOSTIC
-        }
-        else
-        {
-          CurrentState = WAIT_FOR_TOUCHDOWN;
-  #if DIAGNOSTIC == 1
-          Diagnostic_printf("Already at idle throttle, waiting for touch down of all three wheels\n");
-  #endif // DIAGNOSTIC
-        }
-      }
-      break;
-
-    // start throttling down
-    case THROTTLE_DOWN:
-      {
-#if DIAGNOSTIC == 1
-      Diagnostic_printf("Throttling down, waiting for idle throttle\n");
-#endif // DIAGNOSTIC
-        XPLMCommandBegin(ThrottleDownCmd);
-        CurrentState = WAIT_FOR_IDLE_THROTTLE;
-      }
-      break;
-
-    // waiting for the throttle to reach idle
-    case WAIT_FOR_IDLE_THROTTLE:
-      {
-        if (DeactivationRequested == TRUE)
-        {
-          XPLMCommandEnd(ThrottleDownCmd);
-          DeactivationRequested = FALSE;
-          CurrentState = WAIT_FOR_USER;
-#if DIAGNOSTIC == 1
-          Diagnostic_printf("Deactivation while waiting for idle throttle\n");
-#endif // DIAGNOSTIC
-        }
-        else
-        {
-          float ThrottleRatio = XPLMGetDataf(ThrottleRatioRef);
-          if (ThrottleRatio == 0)
-          {
-            XPLMCommandEnd(ThrottleDownCmd);
-#if DIAGNOSTIC == 1
-            Diagnostic_printf("Throttle now at idle, waiting for touch down of all three wheels\n");
-#endif // DIAGNOSTIC
-            CurrentState = WAIT_FOR_TOUCHDOWN;
-          }
-        }
-      }
-      break;
-
-    // wait for all of the wheels to touch the ground so we don't slam
-    // the aircraft into the ground with reverse thrust
-    case WAIT_FOR_TOUCHDOWN:
-      {
-        if (DeactivationRequested == TRUE)
-        {
-          XPLMCommandEnd(ReverseThrustCmd);
-          DeactivationRequested = FALSE;
-          CurrentState = WAIT_FOR_USER;
-#if DIAGNOSTIC == 1
-          Diagnostic_printf("Deactivation while waiting for touch down\n");
-#endif // DIAGNOSTIC
-        }
-        else
-        {
-          int AllWheelsOnGround = XPLMGetDatai(AllWheelsOnGroundRef);
-          if (AllWheelsOnGround == TRUE)
-          {
-#if DIAGNOSTIC == 1
-            Diagnostic_printf("All wheels on ground, applying reverse thrust\n");
-#endif // DIAGNOSTIC
-            CurrentState = APPLY_REVERSE;
-          }
-        }
-      }
-      break;
-
-      // apply the reverse thrust
-      case APPLY_REVERSE:
-        {
-          float IndicatedAirSpeed = XPLMGetDataf(IndicatedAirSpeedRef);
-          if (IndicatedAirSpeed > MIN_SPEED_REVERSE_THRUST)
-          {
-            XPLMCommandBegin(ReverseThrustCmd);
-#if DIAGNOSTIC == 1
-            Diagnostic_printf("Indicated air speed=%f which is above the minimum of %f, waiting for end condition\n", IndicatedAirSpeed, MIN_SPEED_REVERSE_THRUST);
-#endif // DIAGNOSTIC
-            CurrentState = WAIT_FOR_END_OF_REVERSE;
-          }
-          else
-          {
-            CurrentState = WAIT_FOR_USER;
-          }
-        }
-        break;
-
-    // wait for the right conditions to terminate the reverse thrust
-    case WAIT_FOR_END_OF_REVERSE:
-      {
-        if (DeactivationRequested == TRUE)
-        {
-          XPLMCommandEnd(ReverseThrustCmd);
-          DeactivationRequested = FALSE;
-          CurrentState = WAIT_FOR_USER;
-#if DIAGNOSTIC == 1
-          Diagnostic_printf("Deactivation while waiting for end of reverse thrust\n");
-#endif // DIAGNOSTIC
-        }
-        else
-        {
-          float IndicatedAirSpeed = XPLMGetDataf(IndicatedAirSpeedRef);
-          if (IndicatedAirSpeed <= MIN_SPEED_REVERSE_THRUST)
-          {
-            XPLMCommandEnd(ReverseThrustCmd);
-#if DIAGNOSTIC == 1
-            Diagnostic_printf("Indicated air speed is %f, which is less than %f, end of reverse thrust\n", IndicatedAirSpeed, MIN_SPEED_REVERSE_THRUST);
-#endif // DIAGNOSTIC
-            CurrentState = WAIT_FOR_USER;
-          }
-        }
-      }
-      break;
-  }
-
-  return STATE_MACHINE_EXECUTION_INTERVAL;
+  PERF_SCOPE(PERF_PROBE_TICK);
+
+  // first execution after the aircraft was loaded, finish binding
+  if (DeferredProfile != NULL) BindDeferredHandles();
+
+  // the user aircraft can only be enabled once it is ready and is stopped when it stops
+  // being ready, so this only runs it when it can be. the traffic runs either way
+  return StateMachine_ExecuteDue(XPLMGetDataf(SimTimeRef), ManagerExecuted);
+}
+
+// schedules the state machines, they park themselves again when none are running
+static void WakeStateMachines
+  (
+  void
+  )
+{
+  XPLMScheduleFlightLoop(StateMachineFlightLoop, EVERY_FRAME_INTERVAL, 1);
 }
 
 // enables the manager
@@ -295,48 +594,123 @@ static void Enable
   void
   )
 {
-  if (Ready == FALSE) return;
+  if (!Ready) return;
+  if (!BindDeferredHandles()) return;
 
-  // trigger the state machine
-  if (CurrentState == WAIT_FOR_USER)
+  // use the background check if there is one so nothing needs reading now
+  int Failures;
+  float CheckTime;
+  bool Started;
+  if (ArmingMonitor_GetResult(&Failures, &CheckTime))
   {
-    float IndicatedAirSpeed = XPLMGetDataf(IndicatedAirSpeedRef);
-    float FlapAngles[1];
-    XPLMGetDatavf(FlapsAngleRef, FlapAngles, 0, 1);
-    float GearDeployRatio[1];
-    XPLMGetDatavf(GearDeployRatioRef, GearDeployRatio, 0, 1);
-    float AltitudeAboveGround = XPLMGetDataf(AltitudeAboveGroundRef);
-
-#if DIAGNOSTIC == 1
-    Diagnostic_printf("Enable requested by user\n");
-    Diagnostic_printf("Current IAS=%f (require %f or below)\n", IndicatedAirSpeed, MAX_AIRSPEED);
-    Diagnostic_printf("Current flap angle=%f (require %f or above)\n", FlapAngles[0], MIN_FLAP_ANGLE);
-    Diagnostic_printf("Current gears are down=%s (require yes)\n", GearDeployRatio[0] == GEAR_DOWN_RATIO ? "yes" : "no");
-    Diagnostic_printf("Current altitude=%fm (require %fm or below)\n", AltitudeAboveGround, MAX_ALTITUDE);
-#endif // DIAGNOSTIC
-
-    if ((IndicatedAirSpeed <= MAX_AIRSPEED) && (FlapAngles[0] >= MIN_FLAP_ANGLE) && (GearDeployRatio[0] == GEAR_DOWN_RATIO) && (AltitudeAboveGround <= MAX_ALTITUDE))
-    {
-      DeactivationRequested = FALSE;
-      CurrentState = START;
-#if DIAGNOSTIC == 1
-      Diagnostic_printf("Conditions met, now enabled\n");
-#endif // DIAGNOSTIC
-    }
-    else
-    {
-      char Errors[256] = "";
-      if (IndicatedAirSpeed > MAX_AIRSPEED) strcat_s(Errors, 256, " Airspeed too high");
-      if (FlapAngles[0] < MIN_FLAP_ANGLE) strcat_s(Errors, 256, " Flaps too low");
-      if (GearDeployRatio[0] != GEAR_DOWN_RATIO) strcat_s(Errors, 256, " Gear not down");
-      if (AltitudeAboveGround > MAX_ALTITUDE) strcat_s(Errors, 256, " Altitude too high");
-      if (strlen(Errors) > 0) XPLMSpeakString(Errors);
-    }
+    Started = StateMachine_EnableChecked(UserManager, Failures, CheckTime);
   }
   else
   {
-    XPLMSpeakString("Already enabled");
+    Started = StateMachine_Enable(UserManager);
   }
+  StatusDatarefs_Update();
+
+  if (Started)
+  {
+    // wake up the state machine, it parks itself again when back in WAIT_FOR_USER
+    WakeStateMachines();
+  }
+}
+
+// stops the manager immediately, releasing any commands it is holding, and
+// parks the state machine
+static void Park
+  (
+  void
+  )
+{
+  StateMachine_Stop(UserManager);
+  SharedStatus_Publish(UserManager);
+  StatusDatarefs_Update();
+  if (UserProfile != NULL) LandingLog_Update(UserManager, UserProfile->Name);
+  Telemetry_Flush();
+
+  // the traffic may still be landing, the flight loop parks itself if it isn't
+  XPLMScheduleFlightLoop(StateMachineFlightLoop, Traffic_IsEnabled() ? EVERY_FRAME_INTERVAL : DORMANT_INTERVAL, 1);
+}
+
+// puts the profiles read on the worker thread at startup in the registry, waiting for
+// the worker if it hasn't finished
+static void FinishLoadingProfiles
+  (
+  void
+  )
+{
+  if (!Aircraft_IsLoading()) return;
+
+  PERF_STARTUP_SCOPE(PERF_STARTUP_PROFILES_WAIT);
+  uint64_t ParsingNs;
+  Aircraft_FinishLoading(&ParsingNs);
+  Perf_RecordStartup(PERF_STARTUP_PROFILE_PARSING, ParsingNs);
+}
+
+// checks if we know the user aircraft and if so accesses the data refs and commands we need
+static void UseUserAircraft
+  (
+  void
+  )
+{
+  FinishLoadingProfiles();
+
+  // the handles are about to change so stop using them
+  Park();
+  Ready = false;
+  DeferredProfile = NULL;
+  UserProfile = NULL;
+  ArmingMonitor_SetAvailable(false);
+
+  const aircraft_profile_t *Profile = DetectAircraft();
+  if (Profile == NULL) return;
+
+  // only bind what is needed to arm now so the aircraft loads sooner, the rest
+  // is bound on the next frame or when the manager is enabled, whichever is first
+  if (!BindHandles(Profile, true)) return;
+
+  StateMachine_SetLimits(UserManager, &Profile->Limits);
+  StateMachine_SetThrottleMode(UserManager, Profile->ThrottleMode, Profile->ThrottleRetardTime);
+  NumGears = Profile->NumGears;
+  NoseGear = Profile->NoseGear;
+  Ready = true;
+  DeferredProfile = Profile;
+  UserProfile = Profile;
+  ArmingMonitor_SetAvailable(true);
+  XPLMScheduleFlightLoop(StateMachineFlightLoop, EVERY_FRAME_INTERVAL, 1);
+}
+
+// reloads the profiles file if it has changed so settings can be tried without
+// restarting x-plane, called periodically by x-plane
+static float WatchProfiles
+  (
+  float elapsedMe,
+  float elapsedSim,
+  int counter,
+  void *refcon
+  )
+{
+  PERF_SCOPE(PERF_PROBE_PROFILES_WATCHER);
+
+  // never change the settings half way through a landing, look again once it is over
+  if (StateMachine_GetState(UserManager) != WAIT_FOR_USER) return PROFILES_CHECK_INTERVAL;
+
+  time_t Modified = GetFileTime(ProfilesPath);
+  if (Modified == ProfilesModified) return PROFILES_CHECK_INTERVAL;
+  ProfilesModified = Modified;
+
+  // the registry is only replaced if the new file has profiles in it
+  LOG_INFO("Aircraft profiles file has changed, reloading\n");
+  if (Aircraft_LoadProfiles(ProfilesPath) == 0) return PROFILES_CHECK_INTERVAL;
+
+  // the profiles may be in a different order or name different handles
+  memset(HandleCache, 0, sizeof(HandleCache));
+  if (UserAircraftLoaded) UseUserAircraft();
+
+  return PROFILES_CHECK_INTERVAL;
 }
 
 // handles the enable command
@@ -347,12 +721,14 @@ static int EnableCmdHandler
   void *inRefcon
   )
 {
+  PERF_SCOPE(PERF_PROBE_ENABLE_COMMAND);
+
   // If inPhase == 0 the command is executed once on button down.
   if (inPhase == 0)
   {
-    if (Ready == FALSE)
+    if (!Ready)
     {
-      XPLMSpeakString("Plugin failed to load, check the aircraft is known");
+      Voice_Say("Plugin failed to load, check the aircraft is known", SPEECH_PRIORITY_GUIDANCE);
       return 0;
     }
 
@@ -363,6 +739,26 @@ static int EnableCmdHandler
   return 0;
 }
 
+// handles the stop command
+static int StopCmdHandler
+  (
+  XPLMCommandRef inCommand,
+  XPLMCommandPhase inPhase,
+  void *inRefcon
+  )
+{
+  PERF_SCOPE(PERF_PROBE_STOP_COMMAND);
+
+  // If inPhase == 0 the command is executed once on button down.
+  if ((inPhase == 0) && Ready)
+  {
+    StateMachine_RequestDeactivation(UserManager);
+  }
+
+  // disable further processing of this command
+  return 0;
+}
+
 // called when the user chooses a menu item
 static void MenuHandlerCallback
   (
@@ -370,67 +766,57 @@ static void MenuHandlerCallback
   void *inItemRef
   )
 {
-  if (Ready == FALSE)
+  PERF_SCOPE(PERF_PROBE_MENU);
+
+  // user chose a log level, this works even without a known aircraft
+  if (((intptr_t)inItemRef >= MENU_ITEM_ID_LOG_LEVEL + LOG_LEVEL_ERROR) && ((intptr_t)inItemRef <= MENU_ITEM_ID_LOG_LEVEL + LOG_LEVEL_FLOOR))
   {
-    XPLMSpeakString("Plugin failed to load, check the aircraft is known");
+    SetLogLevel((log_level_t)((intptr_t)inItemRef - MENU_ITEM_ID_LOG_LEVEL));
     return;
   }
 
-  // user chose to arm the manager
-  if ((int)inItemRef == MENU_ITEM_ID_ENABLE)
+  // user chose how much reverse thrust to use, this also works without a known aircraft
+  if (((intptr_t)inItemRef >= MENU_ITEM_ID_REVERSE_TARGET + REVERSE_TARGET_FULL) && ((intptr_t)inItemRef < MENU_ITEM_ID_REVERSE_TARGET + REVERSE_NUM_TARGETS))
   {
-    Enable();
+    SetReverseTarget((reverse_target_t)((intptr_t)inItemRef - MENU_ITEM_ID_REVERSE_TARGET));
+    return;
   }
-  // user choose to stop the manager
-  else if ((int)inItemRef == MENU_ITEM_ID_STOP)
+
+  // user changed the arming monitor options, these also work without a known aircraft
+  if ((intptr_t)inItemRef == MENU_ITEM_ID_ARMING_MONITOR)
   {
-    if (CurrentState != WAIT_FOR_USER)
-    {
-      DeactivationRequested = TRUE;
-#if DIAGNOSTIC == 1
-      Diagnostic_printf("User requested deactivation\n");
-#endif // DIAGNOSTIC
-    }
+    SetArmingMonitorOptions(!ArmingMonitorEnabled, false);
+    return;
   }
-}
-
-// determines the currently loaded aircraft
-static aircraft_id_t DetectAircraft
-  (
-  void
-  )
-{
-  // is a description for the aircraft defined? if not then we can't tell what it is
-  XPLMDataRef AircraftDescriptionRef = XPLMFindDataRef("sim/aircraft/view/acf_descrip");
-  if (AircraftDescriptionRef != NULL)
+  else if ((intptr_t)inItemRef == MENU_ITEM_ID_AUTO_ARM)
   {
-    // get aircraft description and convert to lower case
-    char Description[256];
-    XPLMGetDatab(AircraftDescriptionRef, (void *)Description, 0, 256);
-    for (int c = 0; c < strlen(Description); c++) Description[c] = tolower(Description[c]);
-
-#if DIAGNOSTIC == 1
-    Diagnostic_printf("Aircraft loaded = '%s'\n", Description);
-#endif // DIAGNOSTIC
+    SetArmingMonitorOptions(ArmingMonitorEnabled, !AutoArmEnabled);
+    return;
+  }
 
-    int NumKnownAircraft = sizeof(KnownAircrafts) / sizeof(known_aircraft_t);
-#if DIAGNOSTIC == 1
-    Diagnostic_printf("We know about %d different aircraft, searching for match\n", NumKnownAircraft);
-#endif // DIAGNOSTIC
+  // user changed following the multiplayer traffic, which doesn't need the user aircraft
+  if ((intptr_t)inItemRef == MENU_ITEM_ID_TRAFFIC)
+  {
+    SetTrafficEnabled(!TrafficEnabled);
+    return;
+  }
 
-    for (int a = 0; a < NumKnownAircraft; a++)
-    {
-      if (strstr(Description, KnownAircrafts[a].DescriptionMatch) != NULL)
-      {
-#if DIAGNOSTIC == 1
-        Diagnostic_printf("Found match for aircraft: %s\n", KnownAircrafts[a].UserFriendlyName);
-#endif // DIAGNOSTIC
-        return KnownAircrafts[a].Id;
-      }
-    }
+  if (!Ready)
+  {
+    Voice_Say("Plugin failed to load, check the aircraft is known", SPEECH_PRIORITY_GUIDANCE);
+    return;
   }
 
-  return AIRCRAFT_UNKNOWN;
+  // user chose to arm the manager
+  if ((intptr_t)inItemRef == MENU_ITEM_ID_ENABLE)
+  {
+    Enable();
+  }
+  // user choose to stop the manager
+  else if ((intptr_t)inItemRef == MENU_ITEM_ID_STOP)
+  {
+    StateMachine_RequestDeactivation(UserManager);
+  }
 }
 
 
@@ -438,7 +824,7 @@ static aircraft_id_t DetectAircraft
 // PLUGIN API
 
 // called from x-plane to initialize the plugin
-// returns TRUE for success, FALSE for error
+// returns 1 for success, 0 for error
 PLUGIN_API int XPluginStart
   (
   char *outName,  // on return filled with user-friendly plugin name
@@ -449,16 +835,95 @@ PLUGIN_API int XPluginStart
   XPLMMenuID myMenu;
   int	mySubMenuItem;
 
-  Diagnostic_printf("%s version %d.%d.%d\n", PLUGIN_NAME, PLUGIN_VERSION_MAJOR, PLUGIN_VERSION_MINOR, PLUGIN_VERSION_DOT);
-  Diagnostic_printf("%s\n", PLUGIN_COPYRIGHT);
+  // each phase is timed and the times logged once the user aircraft has loaded
+  uint64_t PhaseStart = Perf_Now();
+
+  // the state machine for the user aircraft is created before anything is started.
+  // x-plane doesn't call XPluginStop if starting fails, so nothing can be left running
+  UserManager = StateMachine_Create(&XPlaneSim, NULL);
+  if (UserManager == NULL)
+  {
+    snprintf(outName, 256, "%s", PLUGIN_NAME);
+    snprintf(outSig, 256, "%s", PLUGIN_SIGNATURE);
+    snprintf(outDesc, 256, "%s", "Unable to create the state machine for the user aircraft");
+    XPLMDebugString(PLUGIN_NAME ": unable to create the state machine for the user aircraft\n");
+    return 0;
+  }
+
+  // we only use native paths for files
+  XPLMEnableFeature("XPLM_USE_NATIVE_PATHS", 1);
+
+  // start the diagnostic log and tell the user in Log.txt where to find it
+  char LogPath[256];
+  GetPluginFolder(LogPath);
+  strncat(LogPath, LOG_FILE_NAME, 256 - strlen(LogPath) - 1);
+  Logger_Start(LogPath);
+
+  char Banner[512];
+  snprintf(Banner, 512, "%s: version %d.%d.%d, diagnostics are written to %s\n", PLUGIN_NAME, PLUGIN_VERSION_MAJOR, PLUGIN_VERSION_MINOR, PLUGIN_VERSION_DOT, LogPath);
+  XPLMDebugString(Banner);
+
+  LOG_INFO("%s version %d.%d.%d\n", PLUGIN_NAME, PLUGIN_VERSION_MAJOR, PLUGIN_VERSION_MINOR, PLUGIN_VERSION_DOT);
+  LOG_INFO("%s\n", PLUGIN_COPYRIGHT);
+
+  // open the telemetry recording, the manager works without it
+  char TelemetryPath[256];
+  GetPluginFolder(TelemetryPath);
+  strncat(TelemetryPath, TELEMETRY_FILE_NAME, 256 - strlen(TelemetryPath) - 1);
+  if (!Telemetry_Open(TelemetryPath))
+  {
+    LOG_ERROR("Unable to open telemetry recording %s\n", TelemetryPath);
+  }
+
+  // publish the state for external programs, the manager works without it
+  char StatusPath[256];
+  GetPluginFolder(StatusPath);
+  strncat(StatusPath, SHARED_STATUS_FILE_NAME, 256 - strlen(StatusPath) - 1);
+  if (!SharedStatus_Open(StatusPath))
+  {
+    LOG_ERROR("Unable to open shared status %s\n", StatusPath);
+  }
+
+  // record a summary of each landing, the statistics are kept without it
+  char LandingLogPath[256];
+  GetPluginFolder(LandingLogPath);
+  strncat(LandingLogPath, LANDING_LOG_FILE_NAME, 256 - strlen(LandingLogPath) - 1);
+  if (!LandingLog_Open(LandingLogPath))
+  {
+    LOG_ERROR("Unable to open landing log %s\n", LandingLogPath);
+  }
+  Perf_RecordStartup(PERF_STARTUP_FILES, Perf_Now() - PhaseStart);
+  PhaseStart = Perf_Now();
+
+  // publish the overhead of our callbacks
+  Perf_Start();
+
+  // voice guidance is queued and said from its own flight loop
+  Voice_Start();
+  Perf_RecordStartup(PERF_STARTUP_SERVICES, Perf_Now() - PhaseStart);
+  PhaseStart = Perf_Now();
+
+  // load the aircraft we know about. the profiles file is read on a worker thread while
+  // x-plane carries on starting, it only has to be finished when the user aircraft loads
+  GetPluginFolder(ProfilesPath);
+  strncat(ProfilesPath, PROFILES_FILE_NAME, 256 - strlen(ProfilesPath) - 1);
+  Aircraft_Init();
+  Aircraft_StartLoading(ProfilesPath);
+  ProfilesModified = GetFileTime(ProfilesPath);
+
+  // sim time and the aircraft description are the same for every aircraft
+  SimTimeRef = XPLMFindDataRef("sim/time/total_running_time_sec");
+  AircraftDescriptionRef = XPLMFindDataRef("sim/aircraft/view/acf_descrip");
 
   // Provide our plugin's profile to the plugin system
-  strcpy_s(outName, 256, PLUGIN_NAME);
-  strcpy_s(outSig, 256, "britishideas.assistants.landingthrottlemanager");
-  strcpy_s(outDesc, 256, "Handles the throttle and reverse thrust on landing for VR users");
+  snprintf(outName, 256, "%s", PLUGIN_NAME);
+  snprintf(outSig, 256, "%s", PLUGIN_SIGNATURE);
+  snprintf(outDesc, 256, "%s", "Handles the throttle and reverse thrust on landing for VR users");
 
   // not ready until we know what aircraft will be used
-  Ready = FALSE;
+  Ready = false;
+  Perf_RecordStartup(PERF_STARTUP_PROFILES, Perf_Now() - PhaseStart);
+  PhaseStart = Perf_Now();
 
 	// First we put a new menu item into the plugin menu.
 	// This menu item will contain a submenu for us
@@ -488,11 +953,76 @@ PLUGIN_API int XPluginStart
     (void *)MENU_ITEM_ID_STOP,
     1);
 
-  // create custom command
+  // submenu for the log level, only offering the levels this build was compiled with
+  int LogLevelItem = XPLMAppendMenuItem(
+    myMenu,
+    "Log level",
+    0,
+    1);
+  LogLevelMenu = XPLMCreateMenu(
+    "Log level",
+    myMenu,
+    LogLevelItem,
+    MenuHandlerCallback,
+    0);
+  for (int Level = LOG_LEVEL_ERROR; Level <= LOG_LEVEL_FLOOR; Level++)
+  {
+    XPLMAppendMenuItem(
+      LogLevelMenu,
+      Logger_GetLevelName((log_level_t)Level),
+      (void *)(intptr_t)(MENU_ITEM_ID_LOG_LEVEL + Level),
+      1);
+  }
+  SetLogLevel(Logger_GetLevel());
+
+  // options for checking the landing conditions in the background
+  PluginMenu = myMenu;
+  ArmingMonitorItem = XPLMAppendMenuItem(
+    myMenu,
+    "Check conditions in background",
+    (void *)MENU_ITEM_ID_ARMING_MONITOR,
+    1);
+  AutoArmItem = XPLMAppendMenuItem(
+    myMenu,
+    "Enable automatically",
+    (void *)MENU_ITEM_ID_AUTO_ARM,
+    1);
+
+  // following the landings of the multiplayer traffic
+  TrafficItem = XPLMAppendMenuItem(
+    myMenu,
+    "Follow multiplayer traffic",
+    (void *)MENU_ITEM_ID_TRAFFIC,
+    1);
+
+  // submenu for how much reverse thrust to use, full or modulated to a deceleration
+  int ReverseTargetItem = XPLMAppendMenuItem(
+    myMenu,
+    "Reverse thrust",
+    0,
+    1);
+  ReverseTargetMenu = XPLMCreateMenu(
+    "Reverse thrust",
+    myMenu,
+    ReverseTargetItem,
+    MenuHandlerCallback,
+    0);
+  for (int Target = REVERSE_TARGET_FULL; Target < REVERSE_NUM_TARGETS; Target++)
+  {
+    XPLMAppendMenuItem(
+      ReverseTargetMenu,
+      ReverseTargetNames[Target],
+      (void *)(intptr_t)(MENU_ITEM_ID_REVERSE_TARGET + Target),
+      1);
+  }
+  Perf_RecordStartup(PERF_STARTUP_MENUS, Perf_Now() - PhaseStart);
+  PhaseStart = Perf_Now();
+
+  // create custom commands
   char CmdName[100];
-  sprintf_s(CmdName, 100, "%s//Enable", PLUGIN_NAME);
+  snprintf(CmdName, 100, "%s//Enable", PLUGIN_NAME);
   char CmdDesc[100];
-  sprintf_s(CmdDesc, 100, "Enable the %s", PLUGIN_NAME);
+  snprintf(CmdDesc, 100, "Enable the %s", PLUGIN_NAME);
   EnableCmd = XPLMCreateCommand(CmdName, CmdDesc);
   XPLMRegisterCommandHandler(
     EnableCmd,         // in Command name
@@ -500,13 +1030,54 @@ PLUGIN_API int XPluginStart
     1,                 // Receive input before plugin windows.
     (void *)0);        // inRefcon.
 
-  // initialize state machine
-  CurrentState = WAIT_FOR_USER;
+  snprintf(CmdName, 100, "%s//Stop", PLUGIN_NAME);
+  snprintf(CmdDesc, 100, "Stop and disable the %s", PLUGIN_NAME);
+  StopCmd = XPLMCreateCommand(CmdName, CmdDesc);
+  XPLMRegisterCommandHandler(
+    StopCmd,           // in Command name
+    StopCmdHandler,    // in Handler
+    1,                 // Receive input before plugin windows.
+    (void *)0);        // inRefcon.
+  Perf_RecordStartup(PERF_STARTUP_COMMANDS, Perf_Now() - PhaseStart);
+  PhaseStart = Perf_Now();
+
+  // the shared status and the landing log need a few values on every execution of the
+  // state machine for the user aircraft. recording only keeps what was read
+  int ExtraSnapshotFields = 0;
+  if (SharedStatus_IsOpen()) ExtraSnapshotFields |= SHARED_STATUS_SNAPSHOT_FIELDS;
+  ExtraSnapshotFields |= LANDING_LOG_SNAPSHOT_FIELDS;
+  StateMachine_SetExtraSnapshotFields(UserManager, ExtraSnapshotFields);
+  SetReverseTarget(REVERSE_TARGET_FULL);
 
-  // register the state machine callback
-  XPLMRegisterFlightLoopCallback(StateMachine, STATE_MACHINE_EXECUTION_INTERVAL, NULL);
+  // check the landing conditions in the background if the user wants it
+  ArmingMonitor_Start(UserManager, &XPlaneSim, NULL, Enable);
+  SetArmingMonitorOptions(false, false);
 
-  return TRUE;
+  // let other plugins see what the manager is doing
+  StatusDatarefs_Start(UserManager);
+
+  // follow the landings of the multiplayer traffic if the user wants it
+  Traffic_Start(WakeStateMachines);
+
+  // create the state machine flight loop, running after the flight model so that
+  // touch down is seen on the frame it happens. it is created unscheduled and
+  // stays parked until the manager is enabled
+  XPLMCreateFlightLoop_t FlightLoopParams;
+  FlightLoopParams.structSize   = sizeof(XPLMCreateFlightLoop_t);
+  FlightLoopParams.phase        = xplm_FlightLoop_Phase_AfterFlightModel;
+  FlightLoopParams.callbackFunc = StateMachine;
+  FlightLoopParams.refcon       = NULL;
+  StateMachineFlightLoop = XPLMCreateFlightLoop(&FlightLoopParams);
+
+  // watch the profiles file for changes
+  FlightLoopParams.phase        = xplm_FlightLoop_Phase_BeforeFlightModel;
+  FlightLoopParams.callbackFunc = WatchProfiles;
+  ProfilesFlightLoop = XPLMCreateFlightLoop(&FlightLoopParams);
+  XPLMScheduleFlightLoop(ProfilesFlightLoop, PROFILES_CHECK_INTERVAL, 1);
+  SetTrafficEnabled(false);
+  Perf_RecordStartup(PERF_STARTUP_FLIGHT_LOOPS, Perf_Now() - PhaseStart);
+
+  return 1;
 }
 
 PLUGIN_API void	XPluginStop
@@ -514,6 +1085,36 @@ PLUGIN_API void	XPluginStop
   void
   )
 {
+  if (StateMachineFlightLoop != NULL)
+  {
+    XPLMDestroyFlightLoop(StateMachineFlightLoop);
+    StateMachineFlightLoop = NULL;
+  }
+  if (ProfilesFlightLoop != NULL)
+  {
+    XPLMDestroyFlightLoop(ProfilesFlightLoop);
+    ProfilesFlightLoop = NULL;
+  }
+
+  ArmingMonitor_Stop();
+  StatusDatarefs_Stop();
+  Traffic_Stop();
+  Voice_Stop();
+
+  // the profiles may still be being read if no aircraft was loaded
+  Aircraft_FinishLoading(NULL);
+
+  if (UserManager != NULL)
+  {
+    StateMachine_Destroy(UserManager);
+    UserManager = NULL;
+  }
+
+  Perf_Stop();
+  Telemetry_Close();
+  SharedStatus_Close();
+  LandingLog_Close();
+  Logger_Stop();
 }
 
 PLUGIN_API void XPluginDisable
@@ -521,6 +1122,11 @@ PLUGIN_API void XPluginDisable
   void
   )
 {
+  // the user's choice of following the traffic is kept for when the plugin is enabled again
+  Traffic_SetEnabled(false);
+  Park();
+  ArmingMonitor_SetAvailable(false);
+  Voice_Clear();
 }
 
 PLUGIN_API int XPluginEnable
@@ -528,6 +1134,16 @@ PLUGIN_API int XPluginEnable
   void
   )
 {
+  // every plugin has started by now so a dataref browser can be found
+  Perf_Announce();
+  ArmingMonitor_Announce();
+  StatusDatarefs_Announce();
+  Traffic_Announce();
+
+  // carry on checking the landing conditions if an aircraft we know is loaded
+  ArmingMonitor_SetAvailable(Ready);
+  if (TrafficEnabled) SetTrafficEnabled(true);
+
   return 1;
 }
 
@@ -539,71 +1155,16 @@ PLUGIN_API void XPluginReceiveMessage
   void *inParam
   )
 {
+  PERF_SCOPE(PERF_PROBE_RECEIVE_MESSAGE);
+
   // a new aircraft has been loaded, check if we know it and if so access the data refs and commands we need
-  if (inMessage == XPLM_MSG_PLANE_LOADED)
+  // other aircraft loading don't affect us
+  if ((inMessage == XPLM_MSG_PLANE_LOADED) && ((intptr_t)inParam == XPLM_USER_AIRCRAFT))
   {
-    Ready = FALSE;
-
-    aircraft_id_t AircraftId = DetectAircraft();
+    UserAircraftLoaded = true;
+    UseUserAircraft();
 
-    switch (AircraftId)
-    {
-      case AIRCRAFT_XCRAFTS_ERJ_FAMILY:
-        {
-          // get commands
-          ReverseThrustCmd = XPLMFindCommand("sim/engines/thrust_reverse_hold");
-          if (ReverseThrustCmd == NULL)
-          {
-            return;
-          }
-          ThrottleDownCmd = XPLMFindCommand("sim/engines/throttle_down");
-          if (ThrottleDownCmd == NULL)
-          {
-            return;
-          }
-
-          // get datarefs
-          ThrottleRatioRef = XPLMFindDataRef("sim/cockpit2/engine/actuators/throttle_ratio_all");
-          if (ThrottleRatioRef == NULL)
-          {
-            return;
-          }
-          IndicatedAirSpeedRef = XPLMFindDataRef("sim/flightmodel/position/indicated_airspeed2");
-          if (IndicatedAirSpeedRef == NULL)
-          {
-            return;
-          }
-          AllWheelsOnGroundRef = XPLMFindDataRef("sim/flightmodel/failures/onground_all");
-          if (AllWheelsOnGroundRef == NULL)
-          {
-            return;
-          }
-          FlapsAngleRef = XPLMFindDataRef("sim/flightmodel2/wing/flap1_deg");
-          if (FlapsAngleRef == NULL)
-          {
-            return;
-          }
-
-          GearDeployRatioRef = XPLMFindDataRef("sim/flightmodel2/gear/deploy_ratio");
-          if (GearDeployRatioRef == NULL)
-          {
-            return;
-          }
-
-          AltitudeAboveGroundRef = XPLMFindDataRef("sim/flightmodel2/position/y_agl");
-          if (AltitudeAboveGroundRef == NULL)
-          {
-            return;
-          }
-        }
-#if DIAGNOSTIC == 1
-        Diagnostic_printf("Ready to go\n");
-#endif // DIAGNOSTIC
-        Ready = TRUE;
-        break;
-
-      case AIRCRAFT_UNKNOWN:
-        break;
-    }
+    // the handles not needed to arm are bound later so aren't part of the startup
+    Perf_ReportStartup();
   }
 }
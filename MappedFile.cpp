@@ -0,0 +1,106 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Memory mapped files, see MappedFile.h
+
+#include "MappedFile.h"
+
+#if !IBM
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+// opens or creates the file at Path, sets it to Size bytes and maps all of it for reading and writing
+// returns true for success
+bool MappedFile_Open
+  (
+  mapped_file_t *File,
+  const char *Path,
+  size_t Size
+  )
+{
+  File->Data = NULL;
+  File->Size = Size;
+
+#if IBM
+  File->File = CreateFileA(Path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (File->File == INVALID_HANDLE_VALUE)
+  {
+    return false;
+  }
+
+  // the mapping extends the file to the requested size
+  File->Mapping = CreateFileMappingA(File->File, NULL, PAGE_READWRITE, (DWORD)((unsigned long long)Size >> 32), (DWORD)(Size & 0xFFFFFFFF), NULL);
+  if (File->Mapping == NULL)
+  {
+    CloseHandle(File->File);
+    return false;
+  }
+
+  File->Data = MapViewOfFile(File->Mapping, FILE_MAP_WRITE, 0, 0, Size);
+  if (File->Data == NULL)
+  {
+    CloseHandle(File->Mapping);
+    CloseHandle(File->File);
+    return false;
+  }
+#else
+  File->File = open(Path, O_RDWR | O_CREAT, 0644);
+  if (File->File < 0)
+  {
+    return false;
+  }
+
+  if (ftruncate(File->File, (off_t)Size) != 0)
+  {
+    close(File->File);
+    return false;
+  }
+
+  void *Data = mmap(NULL, Size, PROT_READ | PROT_WRITE, MAP_SHARED, File->File, 0);
+  if (Data == MAP_FAILED)
+  {
+    close(File->File);
+    return false;
+  }
+  File->Data = Data;
+#endif
+
+  return true;
+}
+
+// starts writing the modified pages of the mapping back to disk without waiting for them
+void MappedFile_Flush
+  (
+  mapped_file_t *File
+  )
+{
+  if (File->Data == NULL) return;
+
+#if IBM
+  FlushViewOfFile(File->Data, 0);
+#else
+  msync(File->Data, File->Size, MS_ASYNC);
+#endif
+}
+
+// unmaps and closes the file
+void MappedFile_Close
+  (
+  mapped_file_t *File
+  )
+{
+  if (File->Data == NULL) return;
+
+#if IBM
+  UnmapViewOfFile(File->Data);
+  CloseHandle(File->Mapping);
+  CloseHandle(File->File);
+#else
+  munmap(File->Data, File->Size);
+  close(File->File);
+#endif
+
+  File->Data = NULL;
+}
@@ -0,0 +1,38 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Memory mapped files
+// a file of a fixed size is mapped into memory so it can be written with plain
+// stores, the operating system writes the dirty pages back to disk
+
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include <stddef.h>
+
+#if IBM
+#include <windows.h>
+#endif
+
+// a file mapped into memory
+typedef struct _mapped_file_t
+{
+  void  *Data;        // start of the mapped file, NULL if not open
+  size_t Size;        // size of the mapping in bytes
+#if IBM
+  HANDLE File;
+  HANDLE Mapping;
+#else
+  int    File;
+#endif
+} mapped_file_t;
+
+// opens or creates the file at Path, sets it to Size bytes and maps all of it for reading and writing
+// returns true for success
+extern bool MappedFile_Open(mapped_file_t *File, const char *Path, size_t Size);
+// starts writing the modified pages of the mapping back to disk without waiting for them
+extern void MappedFile_Flush(mapped_file_t *File);
+// unmaps and closes the file
+extern void MappedFile_Close(mapped_file_t *File);
+
+#endif // _MAPPED_FILE_H_
@@ -0,0 +1,236 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Plugin overhead instrumentation, see Perf.h
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include "XPLMDataAccess.h"
+#include "DatarefBrowser.h"
+#include "Logger.h"
+#include "Perf.h"
+
+// prefix of the published datarefs
+#define PERF_DATAREF_PREFIX "landingthrottlemanager/perf/"
+// longest dataref name
+#define PERF_DATAREF_NAME_SIZE 64
+
+// statistics published for each probe
+typedef enum _perf_statistic_t
+{
+  PERF_STATISTIC_MIN,
+  PERF_STATISTIC_MEAN,
+  PERF_STATISTIC_MAX,
+  PERF_STATISTIC_P99,
+  PERF_NUM_STATISTICS
+} perf_statistic_t;
+
+// recent calls of one probe
+typedef struct _perf_probe_stats_t
+{
+  float    Samples[PERF_WINDOW_SIZE];       // microseconds, a ring indexed by Count
+  uint32_t Count;                           // total number of calls
+  uint32_t SummarizedCount;                 // Count when Summary was calculated
+  float    Summary[PERF_NUM_STATISTICS];    // microseconds, indexed by perf_statistic_t
+} perf_probe_stats_t;
+
+// names used in the datarefs, indexed by perf_probe_t and perf_statistic_t
+static const char *ProbeNames[] =
+{
+  "tick",
+  "enable_command",
+  "menu",
+  "receive_message",
+  "arming_monitor",
+  "stop_command",
+  "profiles_watcher",
+  "voice",
+  "traffic"
+};
+static const char *StatisticNames[] =
+{
+  "us_min",
+  "us_mean",
+  "us_max",
+  "us_p99"
+};
+
+// statistics of every probe
+static perf_probe_stats_t Stats[PERF_NUM_PROBES];
+// the published datarefs, the statistics of each probe followed by its count
+static XPLMDataRef Datarefs[PERF_NUM_PROBES][PERF_NUM_STATISTICS + 1];
+static char DatarefNames[PERF_NUM_PROBES][PERF_NUM_STATISTICS + 1][PERF_DATAREF_NAME_SIZE];
+// nanoseconds taken by each phase of starting up, indexed by perf_startup_phase_t
+static uint64_t StartupTimes[PERF_NUM_STARTUP_PHASES];
+static bool StartupReported = false;
+// time the clock is measured from
+static std::chrono::steady_clock::time_point Epoch = std::chrono::steady_clock::now();
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// INTERNAL FUNCTIONS
+
+// calculates the statistics of a probe from the calls in its window
+static void Summarize
+  (
+  perf_probe_stats_t *Probe
+  )
+{
+  if (Probe->SummarizedCount == Probe->Count) return;
+  Probe->SummarizedCount = Probe->Count;
+
+  uint32_t NumSamples = (Probe->Count < PERF_WINDOW_SIZE) ? Probe->Count : PERF_WINDOW_SIZE;
+  float Sorted[PERF_WINDOW_SIZE];
+  memcpy(Sorted, Probe->Samples, NumSamples * sizeof(float));
+  std::sort(Sorted, Sorted + NumSamples);
+
+  double Total = 0;
+  for (uint32_t s = 0; s < NumSamples; s++) Total += Sorted[s];
+
+  Probe->Summary[PERF_STATISTIC_MIN]  = Sorted[0];
+  Probe->Summary[PERF_STATISTIC_MEAN] = (float)(Total / NumSamples);
+  Probe->Summary[PERF_STATISTIC_MAX]  = Sorted[NumSamples - 1];
+  Probe->Summary[PERF_STATISTIC_P99]  = Sorted[(uint32_t)(0.99f * (NumSamples - 1))];
+}
+
+// reads one statistic, the refcon is the probe * PERF_NUM_STATISTICS + the statistic
+static float ReadStatistic
+  (
+  void *inRefcon
+  )
+{
+  intptr_t Index = (intptr_t)inRefcon;
+  perf_probe_stats_t *Probe = &Stats[Index / PERF_NUM_STATISTICS];
+
+  Summarize(Probe);
+  return Probe->Summary[Index % PERF_NUM_STATISTICS];
+}
+
+// reads the number of calls, the refcon is the probe
+static int ReadCount
+  (
+  void *inRefcon
+  )
+{
+  return (int)Stats[(intptr_t)inRefcon].Count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// PERF API
+
+// publishes the datarefs
+void Perf_Start
+  (
+  void
+  )
+{
+  memset(Stats, 0, sizeof(Stats));
+
+  for (int p = 0; p < PERF_NUM_PROBES; p++)
+  {
+    for (int s = 0; s < PERF_NUM_STATISTICS; s++)
+    {
+      snprintf(DatarefNames[p][s], PERF_DATAREF_NAME_SIZE, "%s%s_%s", PERF_DATAREF_PREFIX, ProbeNames[p], StatisticNames[s]);
+      Datarefs[p][s] = XPLMRegisterDataAccessor(DatarefNames[p][s], xplmType_Float, 0,
+        NULL, NULL, ReadStatistic, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+        (void *)(intptr_t)(p * PERF_NUM_STATISTICS + s), NULL);
+    }
+
+    snprintf(DatarefNames[p][PERF_NUM_STATISTICS], PERF_DATAREF_NAME_SIZE, "%s%s_count", PERF_DATAREF_PREFIX, ProbeNames[p]);
+    Datarefs[p][PERF_NUM_STATISTICS] = XPLMRegisterDataAccessor(DatarefNames[p][PERF_NUM_STATISTICS], xplmType_Int, 0,
+      ReadCount, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+      (void *)(intptr_t)p, NULL);
+  }
+}
+
+// tells dataref browsers such as DataRefTool about the datarefs, call once all plugins are loaded
+void Perf_Announce
+  (
+  void
+  )
+{
+  XPLMPluginID Browser = DatarefBrowser_Find();
+  if (Browser == XPLM_NO_PLUGIN_ID) return;
+
+  for (int p = 0; p < PERF_NUM_PROBES; p++)
+  {
+    for (int s = 0; s <= PERF_NUM_STATISTICS; s++)
+    {
+      DatarefBrowser_Show(Browser, DatarefNames[p][s]);
+    }
+  }
+}
+
+// removes the datarefs
+void Perf_Stop
+  (
+  void
+  )
+{
+  for (int p = 0; p < PERF_NUM_PROBES; p++)
+  {
+    for (int s = 0; s <= PERF_NUM_STATISTICS; s++)
+    {
+      if (Datarefs[p][s] != NULL) XPLMUnregisterDataAccessor(Datarefs[p][s]);
+      Datarefs[p][s] = NULL;
+    }
+  }
+
+  // the plugin can be started again, e.g. by the fuzzer, and its startup should be logged too
+  memset(StartupTimes, 0, sizeof(StartupTimes));
+  StartupReported = false;
+}
+
+// returns the current time in nanoseconds from the high resolution clock
+uint64_t Perf_Now
+  (
+  void
+  )
+{
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Epoch).count();
+}
+
+// adds one call to the statistics of a probe
+void Perf_Record
+  (
+  perf_probe_t Probe,
+  uint64_t DurationNs
+  )
+{
+  perf_probe_stats_t *Stat = &Stats[Probe];
+
+  Stat->Samples[Stat->Count % PERF_WINDOW_SIZE] = DurationNs / 1000.0f;
+  Stat->Count++;
+}
+
+// adds to the time taken by a phase of starting up, ignored once the times have been logged
+void Perf_RecordStartup
+  (
+  perf_startup_phase_t Phase,
+  uint64_t DurationNs
+  )
+{
+  if (!StartupReported) StartupTimes[Phase] += DurationNs;
+}
+
+// logs the time taken by each phase of starting up, only the first call logs anything
+void Perf_ReportStartup
+  (
+  void
+  )
+{
+  if (StartupReported) return;
+  StartupReported = true;
+
+  int Us[PERF_NUM_STARTUP_PHASES];
+  for (int p = 0; p < PERF_NUM_STARTUP_PHASES; p++) Us[p] = (int)(StartupTimes[p] / 1000);
+
+  // a record holds at most LOGGER_MAX_ARGS values
+  LOG_INFO("Plugin start in us: files %d, services %d, profiles %d, menus %d, commands %d, flight loops %d\n",
+    Us[PERF_STARTUP_FILES], Us[PERF_STARTUP_SERVICES], Us[PERF_STARTUP_PROFILES], Us[PERF_STARTUP_MENUS], Us[PERF_STARTUP_COMMANDS], Us[PERF_STARTUP_FLIGHT_LOOPS]);
+  LOG_INFO("Aircraft load in us: profile parsing %d (worker thread), profiles wait %d, aircraft detection %d, handle resolution %d\n",
+    Us[PERF_STARTUP_PROFILE_PARSING], Us[PERF_STARTUP_PROFILES_WAIT], Us[PERF_STARTUP_AIRCRAFT_DETECTION], Us[PERF_STARTUP_HANDLE_RESOLUTION]);
+}
@@ -0,0 +1,94 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Plugin overhead instrumentation
+// the callbacks x-plane makes into the plugin are timed with a high resolution clock.
+// statistics over the most recent calls are published as read-only datarefs so the
+// overhead can be watched live, e.g. in DataRefTool:
+//   landingthrottlemanager/perf/<probe>_us_min, _us_mean, _us_max, _us_p99  (microseconds)
+//   landingthrottlemanager/perf/<probe>_count                               (total calls)
+// the phases of starting the plugin and loading the user's aircraft are timed as well and
+// logged once, when the first aircraft has loaded
+// must only be used from the sim thread
+
+#ifndef _PERF_H_
+#define _PERF_H_
+
+#include <stdint.h>
+
+// number of recent calls the statistics are calculated over
+#define PERF_WINDOW_SIZE 256
+
+// the callbacks that are timed
+typedef enum _perf_probe_t
+{
+  PERF_PROBE_TICK,              // state machine flight loop
+  PERF_PROBE_ENABLE_COMMAND,    // enable command handler
+  PERF_PROBE_MENU,              // menu handler
+  PERF_PROBE_RECEIVE_MESSAGE,   // XPluginReceiveMessage
+  PERF_PROBE_ARMING_MONITOR,    // arming monitor flight loop
+  PERF_PROBE_STOP_COMMAND,      // stop command handler
+  PERF_PROBE_PROFILES_WATCHER,  // profiles file watcher flight loop
+  PERF_PROBE_VOICE,             // voice guidance flight loop
+  PERF_PROBE_TRAFFIC,           // multiplayer traffic flight loop
+  PERF_NUM_PROBES
+} perf_probe_t;
+
+// the phases of starting the plugin and loading the user's aircraft that are timed
+typedef enum _perf_startup_phase_t
+{
+  PERF_STARTUP_FILES,               // opening the log, telemetry, status and landing log files
+  PERF_STARTUP_SERVICES,            // the overhead datarefs and the voice flight loop
+  PERF_STARTUP_PROFILES,            // starting to read the profiles file on the worker thread
+  PERF_STARTUP_MENUS,               // menu creation
+  PERF_STARTUP_COMMANDS,            // command creation
+  PERF_STARTUP_FLIGHT_LOOPS,        // state machine, datarefs and flight loops
+  PERF_STARTUP_PROFILE_PARSING,     // reading the profiles file, on the worker thread
+  PERF_STARTUP_PROFILES_WAIT,       // waiting for the worker and using its profiles
+  PERF_STARTUP_AIRCRAFT_DETECTION,  // matching the aircraft to a profile
+  PERF_STARTUP_HANDLE_RESOLUTION,   // finding the aircraft's datarefs and commands
+  PERF_NUM_STARTUP_PHASES
+} perf_startup_phase_t;
+
+// publishes the datarefs
+extern void Perf_Start(void);
+// tells dataref browsers such as DataRefTool about the datarefs, call once all plugins are loaded
+extern void Perf_Announce(void);
+// removes the datarefs
+extern void Perf_Stop(void);
+// returns the current time in nanoseconds from the high resolution clock
+extern uint64_t Perf_Now(void);
+// adds one call to the statistics of a probe
+extern void Perf_Record(perf_probe_t Probe, uint64_t DurationNs);
+// adds to the time taken by a phase of starting up, ignored once the times have been logged
+extern void Perf_RecordStartup(perf_startup_phase_t Phase, uint64_t DurationNs);
+// logs the time taken by each phase of starting up, only the first call logs anything
+extern void Perf_ReportStartup(void);
+
+// times from its creation to the end of the enclosing block
+struct perf_scope_t
+{
+  perf_probe_t Probe;
+  uint64_t     Start;
+
+  perf_scope_t(perf_probe_t TimedProbe) : Probe(TimedProbe), Start(Perf_Now()) {}
+  ~perf_scope_t() { Perf_Record(Probe, Perf_Now() - Start); }
+};
+
+// times the rest of the enclosing block for a probe
+#define PERF_SCOPE(Probe) perf_scope_t PerfScope(Probe)
+
+// times from its creation to the end of the enclosing block for a phase of starting up
+struct perf_startup_scope_t
+{
+  perf_startup_phase_t Phase;
+  uint64_t             Start;
+
+  perf_startup_scope_t(perf_startup_phase_t TimedPhase) : Phase(TimedPhase), Start(Perf_Now()) {}
+  ~perf_startup_scope_t() { Perf_RecordStartup(Phase, Perf_Now() - Start); }
+};
+
+// times the rest of the enclosing block for a phase of starting up
+#define PERF_STARTUP_SCOPE(Phase) perf_startup_scope_t PerfStartupScope(Phase)
+
+#endif // _PERF_H_
@@ -0,0 +1,89 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Reverse thrust controller, see ReverseController.h
+
+#include "ReverseController.h"
+
+// forgets the history and starts at a reverse ratio
+void ReverseController_Reset
+  (
+  reverse_controller_t *Controller,
+  float InitialRatio
+  )
+{
+  Controller->NumSamples      = 0;
+  Controller->LastTime        = 0;
+  Controller->LastGroundSpeed = 0;
+  Controller->Deceleration    = 0;
+  Controller->Integral        = InitialRatio;
+  Controller->Ratio           = InitialRatio;
+}
+
+// adds the ground speed at a sim time
+// returns the reverse ratio to use, 0 = idle, 1 = full reverse
+float ReverseController_Update
+  (
+  reverse_controller_t *Controller,
+  float SimTime,
+  float GroundSpeed,
+  float TargetDeceleration
+  )
+{
+  float Elapsed = SimTime - Controller->LastTime;
+
+  // start again if time went backwards, e.g. a replay
+  if (Elapsed < 0) Controller->NumSamples = 0;
+
+  if (Controller->NumSamples == 0)
+  {
+    Controller->LastTime        = SimTime;
+    Controller->LastGroundSpeed = GroundSpeed;
+    Controller->NumSamples      = 1;
+    return Controller->Ratio;
+  }
+
+  // paused
+  if (Elapsed == 0) return Controller->Ratio;
+
+  // smooth with a time constant so the result doesn't depend on the sample rate
+  float Deceleration = (Controller->LastGroundSpeed - GroundSpeed) / Elapsed;
+  if (Controller->NumSamples == 1)
+  {
+    Controller->Deceleration = Deceleration;
+  }
+  else
+  {
+    float Weight = Elapsed / (REVERSE_CONTROLLER_SMOOTHING_TIME + Elapsed);
+    Controller->Deceleration += Weight * (Deceleration - Controller->Deceleration);
+  }
+
+  Controller->LastTime        = SimTime;
+  Controller->LastGroundSpeed = GroundSpeed;
+  Controller->NumSamples++;
+
+  float Error = TargetDeceleration - Controller->Deceleration;
+  float Integral = Controller->Integral + (REVERSE_CONTROLLER_INTEGRAL_GAIN * Error * Elapsed);
+  float Ratio = (REVERSE_CONTROLLER_PROPORTIONAL_GAIN * Error) + Integral;
+
+  // only keep the new integral if it doesn't push further past a limit
+  if (Ratio > 1)
+  {
+    Ratio = 1;
+    if (Integral < Controller->Integral) Controller->Integral = Integral;
+  }
+  else if (Ratio < 0)
+  {
+    Ratio = 0;
+    if (Integral > Controller->Integral) Controller->Integral = Integral;
+  }
+  else
+  {
+    Controller->Integral = Integral;
+  }
+  if (Controller->Integral > 1) Controller->Integral = 1;
+  if (Controller->Integral < 0) Controller->Integral = 0;
+
+  Controller->Ratio = Ratio;
+  return Ratio;
+}
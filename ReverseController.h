@@ -0,0 +1,38 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Reverse thrust controller
+// chooses how much reverse thrust to use so the aircraft slows down at a target rate,
+// like an autobrake. the deceleration is the smoothed rate of change of the ground speed
+// between samples and a proportional plus integral controller turns the difference from
+// the target into a reverse ratio. the integral stops growing while the ratio is at a
+// limit so it doesn't overshoot when the wheel brakes fade in or out
+
+#ifndef _REVERSE_CONTROLLER_H_
+#define _REVERSE_CONTROLLER_H_
+
+// time constant in seconds of the deceleration smoothing
+#define REVERSE_CONTROLLER_SMOOTHING_TIME 0.3f
+// change in reverse ratio for each meter per second squared below the target
+#define REVERSE_CONTROLLER_PROPORTIONAL_GAIN 0.4f
+// change in reverse ratio per second for each meter per second squared below the target
+#define REVERSE_CONTROLLER_INTEGRAL_GAIN 0.8f
+
+// the state of one landing roll
+typedef struct _reverse_controller_t
+{
+  int   NumSamples;
+  float LastTime;           // seconds
+  float LastGroundSpeed;    // meters per second
+  float Deceleration;       // meters per second squared, positive when slowing down
+  float Integral;           // integral part of the reverse ratio
+  float Ratio;              // 0 = idle, 1 = full reverse
+} reverse_controller_t;
+
+// forgets the history and starts at a reverse ratio
+extern void ReverseController_Reset(reverse_controller_t *Controller, float InitialRatio);
+// adds the ground speed at a sim time
+// returns the reverse ratio to use, 0 = idle, 1 = full reverse
+extern float ReverseController_Update(reverse_controller_t *Controller, float SimTime, float GroundSpeed, float TargetDeceleration);
+
+#endif // _REVERSE_CONTROLLER_H_
@@ -0,0 +1,180 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Shared memory status, see SharedStatus.h
+
+#include <atomic>
+#include <stddef.h>
+#include <string.h>
+#include "MappedFile.h"
+#include "SharedStatus.h"
+
+// the mapped status file
+static mapped_file_t File;
+// the block in the file, NULL if not open
+static shared_status_t *Status = NULL;
+// what was published last, to spot the events
+static uint32_t LastState = WAIT_FOR_USER;
+static uint32_t LastCommands = 0;
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// INTERNAL FUNCTIONS
+
+// marks the block as being written, readers retry until EndWrite
+static void BeginWrite
+  (
+  void
+  )
+{
+  Status->Sequence = Status->Sequence + 1;
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+// marks the block as consistent again
+static void EndWrite
+  (
+  void
+  )
+{
+  Status->Updates++;
+  std::atomic_thread_fence(std::memory_order_release);
+  Status->Sequence = Status->Sequence + 1;
+}
+
+// forgets the events of the previous approach
+static void ClearEvents
+  (
+  void
+  )
+{
+  Status->EnableTime           = SHARED_STATUS_NO_TIME;
+  Status->TouchdownTime        = SHARED_STATUS_NO_TIME;
+  Status->ReverseBeginTime     = SHARED_STATUS_NO_TIME;
+  Status->ReverseBeginAirspeed = 0;
+  Status->ReverseEndTime       = SHARED_STATUS_NO_TIME;
+  Status->ReverseEndAirspeed   = 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// SHARED STATUS API
+
+// opens or creates the status file at Path
+// returns true for success
+bool SharedStatus_Open
+  (
+  const char *Path
+  )
+{
+  if (Status != NULL) return true;
+
+  if (!MappedFile_Open(&File, Path, sizeof(shared_status_t)))
+  {
+    return false;
+  }
+
+  // the previous session's block is no use to anyone, readers that still have
+  // the file mapped see an update in progress until it is filled in again
+  Status = (shared_status_t *)File.Data;
+  Status->Sequence = Status->Sequence | 1;
+  std::atomic_thread_fence(std::memory_order_release);
+
+  memset(&Status->Updates, 0, sizeof(shared_status_t) - offsetof(shared_status_t, Updates));
+  Status->Magic   = SHARED_STATUS_MAGIC;
+  Status->Version = SHARED_STATUS_VERSION;
+  Status->Size    = sizeof(shared_status_t);
+  Status->State   = WAIT_FOR_USER;
+  ClearEvents();
+  LastState = WAIT_FOR_USER;
+  LastCommands = 0;
+
+  EndWrite();
+  return true;
+}
+
+// returns true if the status is being published
+bool SharedStatus_IsOpen
+  (
+  void
+  )
+{
+  return Status != NULL;
+}
+
+// publishes the state after an execution of a state machine
+void SharedStatus_Publish
+  (
+  const state_machine_t *Machine
+  )
+{
+  if (Status == NULL) return;
+
+  const sim_snapshot_t *Snapshot = StateMachine_GetSnapshot(Machine);
+  uint32_t State = (uint32_t)StateMachine_GetState(Machine);
+  int ActiveCommands = StateMachine_GetActiveCommands(Machine);
+  uint32_t Commands = 0;
+  if (ActiveCommands & COMMAND_THROTTLE_DOWN)  Commands |= SHARED_STATUS_COMMAND_THROTTLE_DOWN;
+  if (ActiveCommands & REVERSE_COMMANDS)       Commands |= SHARED_STATUS_COMMAND_REVERSE_THRUST;
+
+  BeginWrite();
+
+  if (Snapshot->Fields & SNAPSHOT_SIM_TIME)           Status->SimTime           = Snapshot->SimTime;
+  if (Snapshot->Fields & SNAPSHOT_INDICATED_AIRSPEED) Status->IndicatedAirSpeed = Snapshot->IndicatedAirSpeed;
+  Status->State    = State;
+  Status->Commands = Commands;
+
+  // the manager has just been enabled
+  if ((LastState == WAIT_FOR_USER) && (State != WAIT_FOR_USER))
+  {
+    ClearEvents();
+    Status->EnableTime = Status->SimTime;
+  }
+  if ((Status->EnableTime != SHARED_STATUS_NO_TIME) && (Status->TouchdownTime == SHARED_STATUS_NO_TIME) &&
+      (Snapshot->Fields & SNAPSHOT_ALL_WHEELS_ON_GROUND) && (Snapshot->AllWheelsOnGround != 0))
+  {
+    Status->TouchdownTime = Status->SimTime;
+  }
+  if (!(LastCommands & SHARED_STATUS_COMMAND_REVERSE_THRUST) && (Commands & SHARED_STATUS_COMMAND_REVERSE_THRUST))
+  {
+    Status->ReverseBeginTime     = Status->SimTime;
+    Status->ReverseBeginAirspeed = Status->IndicatedAirSpeed;
+  }
+  if ((LastCommands & SHARED_STATUS_COMMAND_REVERSE_THRUST) && !(Commands & SHARED_STATUS_COMMAND_REVERSE_THRUST))
+  {
+    Status->ReverseEndTime     = Status->SimTime;
+    Status->ReverseEndAirspeed = Status->IndicatedAirSpeed;
+  }
+
+  EndWrite();
+
+  LastState = State;
+  LastCommands = Commands;
+}
+
+// publishes the result of the background check of the landing conditions
+void SharedStatus_PublishArming
+  (
+  bool Valid,
+  int Failures
+  )
+{
+  if (Status == NULL) return;
+
+  BeginWrite();
+  Status->ArmingValid    = Valid ? 1 : 0;
+  Status->ArmingFailures = Valid ? (uint32_t)Failures : 0;
+  EndWrite();
+}
+
+// closes the status file
+void SharedStatus_Close
+  (
+  void
+  )
+{
+  if (Status == NULL) return;
+
+  MappedFile_Close(&File);
+  Status = NULL;
+}
@@ -0,0 +1,68 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Shared memory status
+// the state of the manager is published in a small memory mapped file on every
+// execution of the state machine, so external programs such as the drivers of
+// cockpit annunciators and rollout displays can read it without talking to the sim.
+// readers map the same file so nothing is copied and no lock is taken.
+// the block is protected by a sequence lock, Sequence is odd while it is being
+// written. to read it copy Sequence, try again if it is odd, copy the block, then
+// try again if Sequence has changed. check Magic, Version and Size before using it
+// must only be used from the sim thread
+
+#ifndef _SHARED_STATUS_H_
+#define _SHARED_STATUS_H_
+
+#include <stdint.h>
+#include "StateMachine.h"
+
+// identifies a status file, "LTMS"
+#define SHARED_STATUS_MAGIC   0x534D544C
+// version of the block layout
+#define SHARED_STATUS_VERSION 1
+// time of an event that hasn't happened on this approach
+#define SHARED_STATUS_NO_TIME -1.0f
+
+// commands held by the manager, for shared_status_t Commands
+#define SHARED_STATUS_COMMAND_THROTTLE_DOWN  0x01
+#define SHARED_STATUS_COMMAND_REVERSE_THRUST 0x02     // full or modulated
+
+// the published block, times are sim times in seconds
+typedef struct _shared_status_t
+{
+  uint32_t Magic;                 // SHARED_STATUS_MAGIC
+  uint32_t Version;               // SHARED_STATUS_VERSION
+  uint32_t Size;                  // sizeof(shared_status_t)
+  volatile uint32_t Sequence;     // odd while the block is being written
+  uint64_t Updates;               // number of times the block has been written
+  float    SimTime;               // when the block was last written
+  uint32_t State;                 // states_t, 0 = waiting for the user
+  uint32_t Commands;              // SHARED_STATUS_COMMAND_* flags
+  uint32_t ArmingValid;           // 1 if ArmingFailures is from a recent background check
+  uint32_t ArmingFailures;        // ARMING_* flags of the landing conditions not met
+  float    IndicatedAirSpeed;     // knots
+  float    EnableTime;            // when the manager was enabled for this approach
+  float    TouchdownTime;         // when all the wheels were first on the ground
+  float    ReverseBeginTime;      // when reverse thrust was applied
+  float    ReverseBeginAirspeed;  // knots
+  float    ReverseEndTime;        // when reverse thrust was removed
+  float    ReverseEndAirspeed;    // knots
+} shared_status_t;
+
+// the sim values each execution needs to read for the block
+#define SHARED_STATUS_SNAPSHOT_FIELDS (SNAPSHOT_SIM_TIME | SNAPSHOT_INDICATED_AIRSPEED | SNAPSHOT_ALL_WHEELS_ON_GROUND)
+
+// opens or creates the status file at Path
+// returns true for success
+extern bool SharedStatus_Open(const char *Path);
+// returns true if the status is being published
+extern bool SharedStatus_IsOpen(void);
+// publishes the state after an execution of a state machine
+extern void SharedStatus_Publish(const state_machine_t *Machine);
+// publishes the result of the background check of the landing conditions
+extern void SharedStatus_PublishArming(bool Valid, int Failures);
+// closes the status file
+extern void SharedStatus_Close(void);
+
+#endif // _SHARED_STATUS_H_
@@ -0,0 +1,1119 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Landing state machine, see StateMachine.h
+
+#include <float.h>
+#include <stdio.h>
+#include <string.h>
+#include "Filters.h"
+#include "Logger.h"
+#include "ReverseController.h"
+#include "StateMachine.h"
+#include "TouchdownPredictor.h"
+
+// the state of one managed aircraft
+struct _state_machine_t
+{
+  // position in the state machine arrays, 0 to STATE_MACHINE_MAX_INSTANCES - 1
+  int Index;
+  // the sim that the state machine is connected to and what identifies the aircraft to it
+  const sim_interface_t *Sim;
+  void *Refcon;
+  // the current state of the state machine
+  states_t CurrentState;
+  // flag to indicate if the user has requested deactivation of the manager
+  bool DeactivationRequested;
+  // the sim values used by the current execution of the state machine
+  sim_snapshot_t Snapshot;
+  // values read on every execution regardless of the state
+  int ExtraSnapshotFields;
+  // predicts touch down while waiting for it
+  touchdown_predictor_t Predictor;
+  // set once touch down is close, from then on it is checked on every frame and the airspeed
+  // is read so reverse thrust can be applied on the frame that the last wheel touches down
+  bool ReversePrearmed;
+  // set once the main gear is on the ground
+  bool MainGearDown;
+  // the snapshot values the decisions are made on, filtered so bounces and noise don't trip them
+  debouncer_t AllWheelsFilter;
+  debouncer_t MainGearFilter;
+  ema_t AirspeedFilter;
+  hysteresis_t CutoffTrackingBand;
+  bool AllWheelsOnGround;
+  bool MainGearOnGround;
+  float IndicatedAirSpeed;      // knots
+  bool NearEndOfReverse;
+  // commands we are currently holding in the sim, manager_command_t flags
+  int ActiveCommands;
+  // commands the states want held at the end of this execution, manager_command_t flags
+  int RequestedCommands;
+  // the landing limits of the aircraft
+  landing_limits_t Limits;
+  // how the throttle is brought to idle
+  throttle_mode_t ThrottleMode;
+  float RetardTime;
+  // when the direct throttle mode started bringing the throttles to idle and where they were
+  float RetardStartTime;
+  int RetardNumEngines;
+  float RetardStartRatio[SIM_MAX_ENGINES];
+  bool RetardComplete;
+  // how much reverse thrust to use and the controller that modulates it
+  reverse_target_t ReverseTarget;
+  reverse_controller_t ReverseController;
+  // the last refusal to enable that was spoken and when, so pressing enable again
+  // straight away doesn't queue the same speech again
+  int LastArmingFailures;
+  float LastArmingSpeechTime;
+  // the sim values that each state needs now, indexed by states_t
+  int SnapshotFields[NUM_STATES];
+};
+
+// every state machine, the scheduling is kept in separate arrays so finding the ones
+// that are due doesn't touch the rest of their state
+static state_machine_t Machines[STATE_MACHINE_MAX_INSTANCES];
+static bool Allocated[STATE_MACHINE_MAX_INSTANCES];
+// sim time of the next execution, FLT_MAX while parked
+static float NextExecutionTime[STATE_MACHINE_MAX_INSTANCES];
+// frames to wait before the next execution
+static int FramesToSkip[STATE_MACHINE_MAX_INSTANCES];
+
+// target decelerations in meters per second squared, indexed by reverse_target_t
+static const float ReverseTargetDecelerations[] =
+{
+  0,                                  // REVERSE_TARGET_FULL
+  REVERSE_TARGET_LO_DECELERATION,     // REVERSE_TARGET_LO
+  REVERSE_TARGET_MED_DECELERATION,    // REVERSE_TARGET_MED
+  REVERSE_TARGET_HI_DECELERATION      // REVERSE_TARGET_HI
+};
+
+// what is said when the manager can't be enabled, indexed by the ARMING_* flags
+static const char *ArmingMessages[ARMING_NUM_COMBINATIONS] =
+{
+  "",
+  "Airspeed too high",
+  "Flaps too low",
+  "Airspeed too high, flaps too low",
+  "Gear not down",
+  "Airspeed too high, gear not down",
+  "Flaps too low, gear not down",
+  "Airspeed too high, flaps too low, gear not down",
+  "Altitude too high",
+  "Airspeed too high, altitude too high",
+  "Flaps too low, altitude too high",
+  "Airspeed too high, flaps too low, altitude too high",
+  "Gear not down, altitude too high",
+  "Airspeed too high, gear not down, altitude too high",
+  "Flaps too low, gear not down, altitude too high",
+  "Airspeed too high, flaps too low, gear not down, altitude too high"
+};
+
+// the sim values that each state needs in THROTTLE_MODE_COMMAND with full reverse thrust
+// before touch down is close, indexed by states_t
+static const int StateSnapshotFields[] =
+{
+  0,                                                                // WAIT_FOR_USER
+  SNAPSHOT_THROTTLE_RATIO,                                          // START
+  0,                                                                // THROTTLE_DOWN
+  SNAPSHOT_THROTTLE_RATIO,                                          // WAIT_FOR_IDLE_THROTTLE
+  SNAPSHOT_ALL_WHEELS_ON_GROUND | SNAPSHOT_ALTITUDE_ABOVE_GROUND |
+    SNAPSHOT_SIM_TIME,                                              // WAIT_FOR_TOUCHDOWN
+  SNAPSHOT_INDICATED_AIRSPEED | SNAPSHOT_SIM_TIME,                  // APPLY_REVERSE
+  SNAPSHOT_INDICATED_AIRSPEED | SNAPSHOT_SIM_TIME                   // WAIT_FOR_END_OF_REVERSE
+};
+// the extra sim values needed when the throttles are written directly
+#define DIRECT_THROTTLE_SNAPSHOT_FIELDS (SNAPSHOT_ENGINE_THROTTLE_RATIO | SNAPSHOT_SIM_TIME)
+// the extra sim values needed when the reverse thrust is modulated
+#define MODULATED_REVERSE_SNAPSHOT_FIELDS (SNAPSHOT_GROUND_SPEED | SNAPSHOT_ENGINE_THROTTLE_RATIO | SNAPSHOT_SIM_TIME)
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// INTERNAL FUNCTIONS
+
+// asks for a command to be held, it starts at the end of the execution
+static void BeginCommand
+  (
+  state_machine_t *Machine,
+  manager_command_t Command
+  )
+{
+  Machine->RequestedCommands |= Command;
+}
+
+// asks for a command to be released, it stops at the end of the execution
+// nothing is sent to the sim if the command isn't being held
+static void EndCommand
+  (
+  state_machine_t *Machine,
+  manager_command_t Command
+  )
+{
+  Machine->RequestedCommands &= ~Command;
+}
+
+// sends the sim one begin or end for each command whose requested state is different
+// from what is held, so each command changes at most once per execution and requests
+// that cancel out or repeat what is already held cost nothing. other plugins may be
+// hooking the commands so a call to the sim isn't free
+static void ApplyCommands
+  (
+  state_machine_t *Machine
+  )
+{
+  int Changed = Machine->RequestedCommands ^ Machine->ActiveCommands;
+  if (Changed == 0) return;
+
+  if (Changed & COMMAND_THROTTLE_DOWN)
+  {
+    if (Machine->RequestedCommands & COMMAND_THROTTLE_DOWN) Machine->Sim->CommandBegin(Machine->Refcon, COMMAND_THROTTLE_DOWN); else Machine->Sim->CommandEnd(Machine->Refcon, COMMAND_THROTTLE_DOWN);
+  }
+  if (Changed & COMMAND_REVERSE_THRUST)
+  {
+    if (Machine->RequestedCommands & COMMAND_REVERSE_THRUST) Machine->Sim->CommandBegin(Machine->Refcon, COMMAND_REVERSE_THRUST); else Machine->Sim->CommandEnd(Machine->Refcon, COMMAND_REVERSE_THRUST);
+  }
+  if (Changed & COMMAND_REVERSE_DEPLOY)
+  {
+    if (Machine->RequestedCommands & COMMAND_REVERSE_DEPLOY) Machine->Sim->CommandBegin(Machine->Refcon, COMMAND_REVERSE_DEPLOY); else Machine->Sim->CommandEnd(Machine->Refcon, COMMAND_REVERSE_DEPLOY);
+  }
+
+  Machine->ActiveCommands = Machine->RequestedCommands;
+}
+
+// works out the SNAPSHOT_* values that each state needs from the throttle mode, the
+// reverse target and the touch down prediction, so it isn't done on every execution
+static void UpdateSnapshotFields
+  (
+  state_machine_t *Machine
+  )
+{
+  memcpy(Machine->SnapshotFields, StateSnapshotFields, sizeof(Machine->SnapshotFields));
+
+  if (Machine->ThrottleMode == THROTTLE_MODE_DIRECT)
+  {
+    Machine->SnapshotFields[THROTTLE_DOWN]          = DIRECT_THROTTLE_SNAPSHOT_FIELDS;
+    Machine->SnapshotFields[WAIT_FOR_IDLE_THROTTLE] = DIRECT_THROTTLE_SNAPSHOT_FIELDS;
+  }
+  if (Machine->ReversePrearmed) Machine->SnapshotFields[WAIT_FOR_TOUCHDOWN] |= SNAPSHOT_INDICATED_AIRSPEED;
+  // a reverse that is being modulated carries on if the target is changed to full
+  if ((Machine->ReverseTarget != REVERSE_TARGET_FULL) || (Machine->RequestedCommands & COMMAND_REVERSE_DEPLOY))
+  {
+    Machine->SnapshotFields[WAIT_FOR_END_OF_REVERSE] |= MODULATED_REVERSE_SNAPSHOT_FIELDS;
+  }
+
+  // START runs once a landing, reading what the states after it need lets a landing
+  // that starts with the wheels already down apply reverse thrust on its first execution
+  Machine->SnapshotFields[START] |= Machine->SnapshotFields[WAIT_FOR_TOUCHDOWN] | Machine->SnapshotFields[APPLY_REVERSE];
+}
+
+// moves the throttles of each engine towards idle in a straight line over RetardTime
+// seconds from where they were when throttling down started
+// returns true once they are at idle
+static bool RetardThrottles
+  (
+  state_machine_t *Machine
+  )
+{
+  float Remaining = 0;
+  if (Machine->RetardTime > 0) Remaining = 1.0f - ((Machine->Snapshot.SimTime - Machine->RetardStartTime) / Machine->RetardTime);
+  if (Remaining < 0) Remaining = 0;
+  if (Remaining > 1) Remaining = 1;
+
+  // never push a throttle forward if the pilot has already pulled it back further
+  float Ratios[SIM_MAX_ENGINES];
+  int NumEngines = (Machine->Snapshot.NumEngines < Machine->RetardNumEngines) ? Machine->Snapshot.NumEngines : Machine->RetardNumEngines;
+  for (int e = 0; e < NumEngines; e++)
+  {
+    Ratios[e] = Machine->RetardStartRatio[e] * Remaining;
+    if (Machine->Snapshot.EngineThrottleRatio[e] < Ratios[e]) Ratios[e] = Machine->Snapshot.EngineThrottleRatio[e];
+  }
+  Machine->Sim->SetEngineThrottles(Machine->Refcon, Ratios, NumEngines);
+
+  return Remaining == 0;
+}
+
+// sets the throttle of every engine to the same ratio
+static void SetAllEngineThrottles
+  (
+  state_machine_t *Machine,
+  float Ratio
+  )
+{
+  float Ratios[SIM_MAX_ENGINES];
+  for (int e = 0; e < Machine->Snapshot.NumEngines; e++)
+  {
+    Ratios[e] = Ratio;
+  }
+  Machine->Sim->SetEngineThrottles(Machine->Refcon, Ratios, Machine->Snapshot.NumEngines);
+}
+
+// stops reverse thrust, a modulated reverse leaves the throttles at idle so they
+// don't give forward thrust once the reversers are stowed
+static void EndReverse
+  (
+  state_machine_t *Machine
+  )
+{
+  if ((Machine->RequestedCommands & COMMAND_REVERSE_DEPLOY) && (Machine->Snapshot.Fields & SNAPSHOT_ENGINE_THROTTLE_RATIO)) SetAllEngineThrottles(Machine, 0);
+  EndCommand(Machine, COMMAND_REVERSE_THRUST);
+  EndCommand(Machine, COMMAND_REVERSE_DEPLOY);
+}
+
+// sets the thresholds of the filters that depend on the landing limits
+static void ConfigureFilters
+  (
+  state_machine_t *Machine
+  )
+{
+  float TrackingSpeed = Machine->Limits.MinSpeedReverseThrust + REVERSE_CUTOFF_TRACKING_MARGIN;
+  Filters_InitHysteresis(&Machine->CutoffTrackingBand, TrackingSpeed, TrackingSpeed + REVERSE_CUTOFF_TRACKING_HYSTERESIS);
+}
+
+// forgets the filtered values, each filter starts again from the next snapshot
+static void ResetFilters
+  (
+  state_machine_t *Machine
+  )
+{
+  Filters_ResetDebouncer(&Machine->AllWheelsFilter);
+  Filters_ResetDebouncer(&Machine->MainGearFilter);
+  Filters_ResetEma(&Machine->AirspeedFilter);
+  Filters_ResetHysteresis(&Machine->CutoffTrackingBand);
+  Machine->AllWheelsOnGround = false;
+  Machine->MainGearOnGround = false;
+  Machine->IndicatedAirSpeed = 0;
+  Machine->NearEndOfReverse = false;
+}
+
+// runs the filters on the values read into the snapshot, values that weren't read
+// keep their last filtered value. the airspeed is only smoothed when the sim time
+// was read with it
+static void FilterSnapshot
+  (
+  state_machine_t *Machine
+  )
+{
+  const sim_snapshot_t *Snapshot = &Machine->Snapshot;
+
+  if (Snapshot->Fields & SNAPSHOT_ALL_WHEELS_ON_GROUND)
+  {
+    Machine->AllWheelsOnGround = Filters_Debounce(&Machine->AllWheelsFilter, Snapshot->AllWheelsOnGround != 0);
+    Machine->MainGearOnGround = Filters_Debounce(&Machine->MainGearFilter, Snapshot->MainGearOnGround != 0);
+  }
+
+  if ((Snapshot->Fields & (SNAPSHOT_INDICATED_AIRSPEED | SNAPSHOT_SIM_TIME)) == (SNAPSHOT_INDICATED_AIRSPEED | SNAPSHOT_SIM_TIME))
+  {
+    Machine->IndicatedAirSpeed = Filters_Average(&Machine->AirspeedFilter, Snapshot->SimTime, Snapshot->IndicatedAirSpeed);
+    Machine->NearEndOfReverse = Filters_IsLow(&Machine->CutoffTrackingBand, Machine->IndicatedAirSpeed);
+  }
+}
+
+// forgets the previous approach
+static void ResetTouchdownPrediction
+  (
+  state_machine_t *Machine
+  )
+{
+  TouchdownPredictor_Reset(&Machine->Predictor);
+  Machine->ReversePrearmed = false;
+  Machine->MainGearDown = false;
+  ResetFilters(Machine);
+  UpdateSnapshotFields(Machine);
+}
+
+// moves the state machine into a state, every change of state goes through here.
+// entering START begins a landing so the touch down prediction and the filters start
+// again and nothing from an earlier landing is used. the transitions of a landing keep
+// the filters as each state carries on from the values the last one filtered, e.g.
+// applying reverse thrust uses the airspeed averaged while waiting for touch down and
+// the wheels stay debounced across the change
+static void EnterState
+  (
+  state_machine_t *Machine,
+  states_t State
+  )
+{
+  if (State == START) ResetTouchdownPrediction(Machine);
+  Machine->CurrentState = State;
+}
+
+// starts the manager if none of the landing conditions failed, otherwise tells the
+// user what is wrong unless it was just said
+// returns true if the manager was started
+static bool EnableWithArming
+  (
+  state_machine_t *Machine,
+  int Failures,     // ARMING_* flags
+  float SimTime     // when the conditions were checked
+  )
+{
+  if (Failures == 0)
+  {
+    Machine->LastArmingFailures = 0;
+    StateMachine_Arm(Machine);
+    LOG_INFO("Conditions met, now enabled\n");
+    return true;
+  }
+
+  // time going backwards means a new flight
+  float SinceLastSpeech = SimTime - Machine->LastArmingSpeechTime;
+  if ((Failures != Machine->LastArmingFailures) || (SinceLastSpeech < 0) || (SinceLastSpeech >= ARMING_SPEECH_DEBOUNCE_TIME))
+  {
+    Machine->Sim->Speak(Machine->Refcon, ArmingMessages[Failures], SPEECH_PRIORITY_GUIDANCE);
+    Machine->LastArmingFailures = Failures;
+    Machine->LastArmingSpeechTime = SimTime;
+  }
+  else
+  {
+    LOG_TRACE("Not repeating %s\n", ArmingMessages[Failures]);
+  }
+
+  return false;
+}
+
+// makes a state machine due at the next StateMachine_ExecuteDue
+static void ScheduleNow
+  (
+  state_machine_t *Machine
+  )
+{
+  NextExecutionTime[Machine->Index] = 0;
+  FramesToSkip[Machine->Index] = 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// GUARDS, ACTIONS AND UPDATES
+// these are only called through the state table below
+
+// returns true if the throttle isn't at idle
+static bool IsAboveIdle
+  (
+  state_machine_t *Machine
+  )
+{
+  return Machine->Snapshot.ThrottleRatio > 0;
+}
+
+// returns true once the throttle has reached idle
+static bool IsAtIdle
+  (
+  state_machine_t *Machine
+  )
+{
+  if (Machine->ThrottleMode == THROTTLE_MODE_DIRECT) return Machine->RetardComplete;
+  return Machine->Snapshot.ThrottleRatio == 0;
+}
+
+// returns true if all the wheels are on the ground, the latest reading has to agree so
+// reverse thrust is never started on a reading that has a wheel in the air
+static bool IsAllWheelsOnGround
+  (
+  state_machine_t *Machine
+  )
+{
+  return Machine->AllWheelsOnGround && (Machine->Snapshot.AllWheelsOnGround != 0);
+}
+
+// returns true if the aircraft is fast enough for reverse thrust
+static bool IsAboveMinSpeedReverseThrust
+  (
+  state_machine_t *Machine
+  )
+{
+  return Machine->IndicatedAirSpeed > Machine->Limits.MinSpeedReverseThrust;
+}
+
+// returns true once the aircraft has slowed down to the minimum reverse thrust speed
+static bool IsAtMinSpeedReverseThrust
+  (
+  state_machine_t *Machine
+  )
+{
+  return Machine->IndicatedAirSpeed <= Machine->Limits.MinSpeedReverseThrust;
+}
+
+// returns true if the reverse thrust is modulated
+static bool IsReverseModulated
+  (
+  state_machine_t *Machine
+  )
+{
+  return (Machine->RequestedCommands & COMMAND_REVERSE_DEPLOY) != 0;
+}
+
+// returns true if the throttles are being moved on every frame
+static bool IsRetardingThrottles
+  (
+  state_machine_t *Machine
+  )
+{
+  return Machine->ThrottleMode == THROTTLE_MODE_DIRECT;
+}
+
+// returns true once touch down is close
+static bool IsReversePrearmed
+  (
+  state_machine_t *Machine
+  )
+{
+  return Machine->ReversePrearmed;
+}
+
+// returns true if the end of reverse thrust is close or the reverse is modulated
+static bool IsNearEndOfReverse
+  (
+  state_machine_t *Machine
+  )
+{
+  return IsReverseModulated(Machine) || Machine->NearEndOfReverse;
+}
+
+static void LogThrottlingDown(state_machine_t *Machine) { LOG_INFO("Going to throttle down as we are not at idle throttle\n"); }
+static void LogAlreadyAtIdle(state_machine_t *Machine)  { LOG_INFO("Already at idle throttle, waiting for touch down of all three wheels\n"); }
+static void LogAllWheelsDown(state_machine_t *Machine)  { LOG_INFO("All wheels on ground, applying reverse thrust\n"); }
+
+// starts bringing the throttle to idle
+static void StartThrottleDown
+  (
+  state_machine_t *Machine
+  )
+{
+  if (Machine->ThrottleMode == THROTTLE_MODE_DIRECT)
+  {
+    LOG_INFO("Throttling down over %f seconds, waiting for idle throttle\n", Machine->RetardTime);
+    Machine->RetardStartTime = Machine->Snapshot.SimTime;
+    Machine->RetardNumEngines = Machine->Snapshot.NumEngines;
+    Machine->RetardComplete = false;
+    memcpy(Machine->RetardStartRatio, Machine->Snapshot.EngineThrottleRatio, sizeof(Machine->RetardStartRatio));
+  }
+  else
+  {
+    LOG_INFO("Throttling down, waiting for idle throttle\n");
+    BeginCommand(Machine, COMMAND_THROTTLE_DOWN);
+  }
+}
+
+// the direct throttle mode moves the throttles on every execution
+static void UpdateThrottleDown
+  (
+  state_machine_t *Machine
+  )
+{
+  if (Machine->ThrottleMode == THROTTLE_MODE_DIRECT) Machine->RetardComplete = RetardThrottles(Machine);
+}
+
+// stops throttling down once at idle
+static void EndThrottleDown
+  (
+  state_machine_t *Machine
+  )
+{
+  EndCommand(Machine, COMMAND_THROTTLE_DOWN);
+  LOG_INFO("Throttle now at idle, waiting for touch down of all three wheels\n");
+}
+
+// watches the approach, reverse is prearmed when low or when touch down is expected
+// soon, e.g. from a steep or fast descent. the main gear usually touches down first,
+// what can be done before the nose is down is done then but reverse thrust waits for
+// all the wheels
+static void UpdateTouchdown
+  (
+  state_machine_t *Machine
+  )
+{
+  TouchdownPredictor_Update(&Machine->Predictor, Machine->Snapshot.SimTime, Machine->Snapshot.AltitudeAboveGround);
+  float TimeToTouchdown = TouchdownPredictor_GetTimeToTouchdown(&Machine->Predictor);
+  if (!Machine->ReversePrearmed && ((Machine->Snapshot.AltitudeAboveGround <= TOUCHDOWN_TRACKING_ALTITUDE) || (TimeToTouchdown <= TOUCHDOWN_TRACKING_TIME)))
+  {
+    Machine->ReversePrearmed = true;
+    UpdateSnapshotFields(Machine);
+    LOG_INFO("Touch down expected in %f seconds at %fm, prearming reverse thrust\n", TimeToTouchdown, Machine->Snapshot.AltitudeAboveGround);
+  }
+
+  if (!Machine->MainGearDown && Machine->MainGearOnGround)
+  {
+    Machine->MainGearDown = true;
+    LOG_INFO("Main gear on ground, waiting for nose gear\n");
+    Machine->Sim->CommandOnce(Machine->Refcon, COMMAND_MAINS_DOWN);
+  }
+}
+
+// starts reverse thrust
+static void StartReverse
+  (
+  state_machine_t *Machine
+  )
+{
+  // holding the full reverse command would keep the reverse at full whatever the throttles are
+  // set to, so a modulated reverse deploys the reversers and leaves the power to the throttles.
+  // it starts at full reverse, the controller backs off once the aircraft is slowing down
+  if (Machine->ReverseTarget == REVERSE_TARGET_FULL)
+  {
+    BeginCommand(Machine, COMMAND_REVERSE_THRUST);
+  }
+  else
+  {
+    BeginCommand(Machine, COMMAND_REVERSE_DEPLOY);
+    ReverseController_Reset(&Machine->ReverseController, 1.0f);
+  }
+  Machine->Sim->Speak(Machine->Refcon, REVERSE_CALLOUT, SPEECH_PRIORITY_SAFETY);
+  LOG_INFO("Indicated air speed=%f which is above the minimum of %f, waiting for end condition\n", Machine->IndicatedAirSpeed, Machine->Limits.MinSpeedReverseThrust);
+}
+
+// sets the reverse power so the aircraft slows down at the target deceleration
+static void ModulateReverse
+  (
+  state_machine_t *Machine
+  )
+{
+  float Ratio = ReverseController_Update(&Machine->ReverseController, Machine->Snapshot.SimTime, Machine->Snapshot.GroundSpeed, ReverseTargetDecelerations[Machine->ReverseTarget]);
+  SetAllEngineThrottles(Machine, Ratio);
+}
+
+// stops reverse thrust at the minimum reverse thrust speed
+static void StopReverse
+  (
+  state_machine_t *Machine
+  )
+{
+  EndReverse(Machine);
+  LOG_INFO("Indicated air speed is %f, which is less than %f, end of reverse thrust\n", Machine->IndicatedAirSpeed, Machine->Limits.MinSpeedReverseThrust);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// STATE TABLE
+
+// when a state is executed again
+typedef enum _schedule_t
+{
+  SCHEDULE_DORMANT,         // not until the manager is enabled again
+  SCHEDULE_EVERY_FRAME,     // on the next frame
+  SCHEDULE_PERIODIC         // after the execution interval of the aircraft
+} schedule_t;
+
+// describes a state, indexed by states_t
+typedef struct _state_t
+{
+  const char *Activity;                                 // what the manager is doing, for the log
+  bool Deactivatable;                                   // the user can stop the manager in this state
+  void (*Update)(state_machine_t *Machine);             // called on every execution before the transitions, may be NULL
+  schedule_t Schedule;                                  // when to execute next, see StateMachine_Execute
+  bool (*NeedsEveryFrame)(state_machine_t *Machine);    // if it returns true the state is executed on every frame instead, may be NULL
+} state_t;
+
+// a way out of a state, the transitions of a state are tried in order and the first
+// one whose guard returns true is taken. a transition back to the same state runs its
+// action without leaving the state
+typedef struct _transition_t
+{
+  states_t From;
+  bool (*Guard)(state_machine_t *Machine);              // NULL to always take the transition
+  void (*Action)(state_machine_t *Machine);             // called when the transition is taken, may be NULL
+  states_t To;
+} transition_t;
+
+// the tables are constant expressions so a mistake in them fails the build
+static constexpr state_t States[] =
+{
+  // activity                           deactivatable update              schedule              every frame if
+  {"waiting for the user",              false,        NULL,               SCHEDULE_DORMANT,     NULL},                  // WAIT_FOR_USER
+  {"starting",                          false,        NULL,               SCHEDULE_EVERY_FRAME, NULL},                  // START
+  {"throttling down",                   false,        NULL,               SCHEDULE_EVERY_FRAME, NULL},                  // THROTTLE_DOWN
+  {"waiting for idle throttle",         true,         UpdateThrottleDown, SCHEDULE_PERIODIC,    IsRetardingThrottles},  // WAIT_FOR_IDLE_THROTTLE
+  {"waiting for touch down",            true,         UpdateTouchdown,    SCHEDULE_PERIODIC,    IsReversePrearmed},     // WAIT_FOR_TOUCHDOWN
+  {"applying reverse thrust",           false,        NULL,               SCHEDULE_EVERY_FRAME, NULL},                  // APPLY_REVERSE
+  {"waiting for end of reverse thrust", true,         NULL,               SCHEDULE_PERIODIC,    IsNearEndOfReverse}     // WAIT_FOR_END_OF_REVERSE
+};
+static_assert(sizeof(States) / sizeof(States[0]) == NUM_STATES, "States needs one row for each state, in states_t order");
+
+// every transition, grouped by the state they leave
+static constexpr transition_t Transitions[] =
+{
+  // from                   guard                         action             to
+  {START,                   IsAboveIdle,                  LogThrottlingDown, THROTTLE_DOWN},
+  {START,                   NULL,                         LogAlreadyAtIdle,  WAIT_FOR_TOUCHDOWN},
+  {THROTTLE_DOWN,           NULL,                         StartThrottleDown, WAIT_FOR_IDLE_THROTTLE},
+  {WAIT_FOR_IDLE_THROTTLE,  IsAtIdle,                     EndThrottleDown,   WAIT_FOR_TOUCHDOWN},
+  {WAIT_FOR_TOUCHDOWN,      IsAllWheelsOnGround,          LogAllWheelsDown,  APPLY_REVERSE},
+  {APPLY_REVERSE,           IsAboveMinSpeedReverseThrust, StartReverse,      WAIT_FOR_END_OF_REVERSE},
+  {APPLY_REVERSE,           NULL,                         NULL,              WAIT_FOR_USER},
+  {WAIT_FOR_END_OF_REVERSE, IsAtMinSpeedReverseThrust,    StopReverse,       WAIT_FOR_USER},
+  {WAIT_FOR_END_OF_REVERSE, IsReverseModulated,           ModulateReverse,   WAIT_FOR_END_OF_REVERSE}
+};
+#define NUM_TRANSITIONS (int)(sizeof(Transitions) / sizeof(Transitions[0]))
+
+// returns true if the transitions are grouped by the state they leave, in states_t order
+static constexpr bool IsInStateOrder
+  (
+  void
+  )
+{
+  for (int t = 0; t < NUM_TRANSITIONS; t++)
+  {
+    if ((Transitions[t].From >= NUM_STATES) || (Transitions[t].To >= NUM_STATES)) return false;
+    if ((t > 0) && (Transitions[t].From < Transitions[t - 1].From)) return false;
+  }
+  return true;
+}
+static_assert(IsInStateOrder(), "Transitions must be grouped by the state they leave, in states_t order");
+
+// where the transitions of each state start in the transition table, worked out when
+// compiling. the transitions of state s are First[s] to First[s + 1] - 1
+struct transition_index_t
+{
+  int First[NUM_STATES + 1];
+
+  constexpr transition_index_t() : First()
+  {
+    int t = 0;
+    for (int s = 0; s < NUM_STATES; s++)
+    {
+      First[s] = t;
+      while ((t < NUM_TRANSITIONS) && (Transitions[t].From == s)) t++;
+    }
+    First[NUM_STATES] = t;
+  }
+};
+static constexpr transition_index_t TransitionIndex;
+
+// stops the manager at the user's request, releasing any commands it is holding
+static void Deactivate
+  (
+  state_machine_t *Machine
+  )
+{
+  LOG_INFO("Deactivation while %s\n", States[Machine->CurrentState].Activity);
+  if (Machine->RequestedCommands & REVERSE_COMMANDS) EndReverse(Machine);
+  EndCommand(Machine, COMMAND_THROTTLE_DOWN);
+  Machine->DeactivationRequested = false;
+  EnterState(Machine, WAIT_FOR_USER);
+  Machine->Sim->Speak(Machine->Refcon, DISENGAGED_CALLOUT, SPEECH_PRIORITY_SAFETY);
+}
+
+// runs the current state once
+// returns true if the state changed
+static bool RunState
+  (
+  state_machine_t *Machine
+  )
+{
+  const state_t *State = &States[Machine->CurrentState];
+
+  if (Machine->DeactivationRequested && State->Deactivatable)
+  {
+    Deactivate(Machine);
+    return true;
+  }
+
+  if (State->Update != NULL) State->Update(Machine);
+
+  for (int t = TransitionIndex.First[Machine->CurrentState]; t < TransitionIndex.First[Machine->CurrentState + 1]; t++)
+  {
+    const transition_t *Transition = &Transitions[t];
+    if ((Transition->Guard == NULL) || Transition->Guard(Machine))
+    {
+      if (Transition->Action != NULL) Transition->Action(Machine);
+      EnterState(Machine, Transition->To);
+      return Machine->CurrentState != Transition->From;
+    }
+  }
+
+  return false;
+}
+
+// determines when the state machine should next be executed based on the current state
+// returns the number of seconds to the next execution, or a negative number of frames
+static float GetExecutionInterval
+  (
+  state_machine_t *Machine
+  )
+{
+  // the snapshot doesn't have what the current state needs, so look again on the next frame
+  int RequiredFields = Machine->SnapshotFields[Machine->CurrentState];
+  if ((Machine->Snapshot.Fields & RequiredFields) != RequiredFields) return EVERY_FRAME_INTERVAL;
+
+  const state_t *State = &States[Machine->CurrentState];
+  if ((State->NeedsEveryFrame != NULL) && State->NeedsEveryFrame(Machine)) return EVERY_FRAME_INTERVAL;
+
+  switch (State->Schedule)
+  {
+    case SCHEDULE_DORMANT:     return DORMANT_INTERVAL;
+    case SCHEDULE_EVERY_FRAME: return EVERY_FRAME_INTERVAL;
+    default:                   return Machine->Limits.ExecutionInterval;
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// STATE MACHINE API
+
+// creates a state machine connected to the sim, Refcon is passed to every call of
+// the sim interface so it can tell the aircraft apart
+// returns NULL if there are already STATE_MACHINE_MAX_INSTANCES state machines
+state_machine_t *StateMachine_Create
+  (
+  const sim_interface_t *Interface,
+  void *Refcon
+  )
+{
+  for (int m = 0; m < STATE_MACHINE_MAX_INSTANCES; m++)
+  {
+    if (Allocated[m]) continue;
+
+    state_machine_t *Machine = &Machines[m];
+    Allocated[m] = true;
+    Machine->Index = m;
+    Machine->Sim = Interface;
+    Machine->Refcon = Refcon;
+    StateMachine_Init(Machine);
+    return Machine;
+  }
+
+  LOG_ERROR("Can't create more than %d state machines\n", STATE_MACHINE_MAX_INSTANCES);
+  return NULL;
+}
+
+// frees a state machine, it must be stopped first
+void StateMachine_Destroy
+  (
+  state_machine_t *Machine
+  )
+{
+  Allocated[Machine->Index] = false;
+}
+
+// resets the state machine to WAIT_FOR_USER with the default settings
+void StateMachine_Init
+  (
+  state_machine_t *Machine
+  )
+{
+  Machine->CurrentState = WAIT_FOR_USER;
+  Machine->DeactivationRequested = false;
+  Machine->ActiveCommands = 0;
+  Machine->RequestedCommands = 0;
+  memset(&Machine->Snapshot, 0, sizeof(Machine->Snapshot));
+  Filters_InitDebouncer(&Machine->AllWheelsFilter, TOUCHDOWN_DEBOUNCE_REQUIRED, TOUCHDOWN_DEBOUNCE_SAMPLES);
+  Filters_InitDebouncer(&Machine->MainGearFilter, TOUCHDOWN_DEBOUNCE_REQUIRED, TOUCHDOWN_DEBOUNCE_SAMPLES);
+  Filters_InitEma(&Machine->AirspeedFilter, AIRSPEED_SMOOTHING_TIME);
+  ResetTouchdownPrediction(Machine);
+
+  Machine->Limits.MinSpeedReverseThrust = MIN_SPEED_REVERSE_THRUST;
+  Machine->Limits.MaxAirspeed           = MAX_AIRSPEED;
+  Machine->Limits.MinFlapAngle          = MIN_FLAP_ANGLE;
+  Machine->Limits.MaxAltitude           = MAX_ALTITUDE;
+  Machine->Limits.GearDownRatio         = GEAR_DOWN_RATIO;
+  Machine->Limits.ExecutionInterval     = STATE_MACHINE_EXECUTION_INTERVAL;
+  ConfigureFilters(Machine);
+
+  Machine->ThrottleMode = THROTTLE_MODE_COMMAND;
+  Machine->RetardTime   = THROTTLE_RETARD_TIME;
+
+  Machine->ReverseTarget = REVERSE_TARGET_FULL;
+
+  Machine->LastArmingFailures = 0;
+  Machine->LastArmingSpeechTime = 0;
+
+  NextExecutionTime[Machine->Index] = FLT_MAX;
+  FramesToSkip[Machine->Index] = 0;
+
+  UpdateSnapshotFields(Machine);
+}
+
+// sets the landing limits, StateMachine_Init resets them to the defaults
+// they can be changed at any time, the next execution uses them
+void StateMachine_SetLimits
+  (
+  state_machine_t *Machine,
+  const landing_limits_t *NewLimits
+  )
+{
+  Machine->Limits = *NewLimits;
+  ConfigureFilters(Machine);
+}
+
+// sets how the throttle is brought to idle and for THROTTLE_MODE_DIRECT how long
+// it takes in seconds, StateMachine_Init resets it to THROTTLE_MODE_COMMAND
+void StateMachine_SetThrottleMode
+  (
+  state_machine_t *Machine,
+  throttle_mode_t Mode,
+  float Time
+  )
+{
+  Machine->ThrottleMode = Mode;
+  Machine->RetardTime = Time;
+  UpdateSnapshotFields(Machine);
+}
+
+// sets how much reverse thrust to use, StateMachine_Init resets it to REVERSE_TARGET_FULL
+// which holds COMMAND_REVERSE_THRUST. the other targets hold COMMAND_REVERSE_DEPLOY and set
+// the reverse power by writing the engine throttles. a change takes effect from the next
+// time reverse thrust is applied
+void StateMachine_SetReverseTarget
+  (
+  state_machine_t *Machine,
+  reverse_target_t Target
+  )
+{
+  Machine->ReverseTarget = Target;
+  ReverseController_Reset(&Machine->ReverseController, 1.0f);
+  UpdateSnapshotFields(Machine);
+}
+
+// sets SNAPSHOT_* values to read on every execution in addition to what the current state needs
+void StateMachine_SetExtraSnapshotFields
+  (
+  state_machine_t *Machine,
+  int Fields
+  )
+{
+  Machine->ExtraSnapshotFields = Fields;
+}
+
+// executes the state machine once
+// returns the number of seconds to the next execution, a negative number of frames
+// or DORMANT_INTERVAL if it doesn't need executing until it is enabled again
+float StateMachine_Execute
+  (
+  state_machine_t *Machine
+  )
+{
+  Machine->Sim->ReadSnapshot(Machine->Refcon, &Machine->Snapshot, Machine->SnapshotFields[Machine->CurrentState] | Machine->ExtraSnapshotFields);
+  FilterSnapshot(Machine);
+
+  // a state entered during this execution is run straight away if the snapshot has
+  // what it needs, e.g. reverse thrust is applied on the frame that the last wheel
+  // touches down. every state is run at most once
+  for (int Step = 0; Step < NUM_STATES; Step++)
+  {
+    if (!RunState(Machine)) break;
+
+    int RequiredFields = Machine->SnapshotFields[Machine->CurrentState];
+    if ((Machine->Snapshot.Fields & RequiredFields) != RequiredFields) break;
+  }
+
+  ApplyCommands(Machine);
+
+  return GetExecutionInterval(Machine);
+}
+
+// executes every state machine that is due at a sim time, calling Executed after
+// each one so the caller can look at the result. this lets a single flight loop
+// run any number of aircraft, each one as often as its state needs
+// returns the number of seconds to the next state machine being due, a negative
+// number of frames or DORMANT_INTERVAL if none are running
+float StateMachine_ExecuteDue
+  (
+  float SimTime,
+  void (*Executed)(state_machine_t *Machine)
+  )
+{
+  float Interval = DORMANT_INTERVAL;
+
+  for (int m = 0; m < STATE_MACHINE_MAX_INSTANCES; m++)
+  {
+    if (!Allocated[m] || (NextExecutionTime[m] == FLT_MAX)) continue;
+
+    // time going backwards means a new flight or a replay, so don't wait for the old time
+    if (NextExecutionTime[m] - SimTime > STATE_MACHINE_MAX_EXECUTION_INTERVAL) NextExecutionTime[m] = SimTime;
+
+    if (FramesToSkip[m] > 0)
+    {
+      FramesToSkip[m]--;
+    }
+    else if (SimTime >= NextExecutionTime[m])
+    {
+      float MachineInterval = StateMachine_Execute(&Machines[m]);
+      if (Executed != NULL) Executed(&Machines[m]);
+
+      if (MachineInterval == DORMANT_INTERVAL)
+      {
+        NextExecutionTime[m] = FLT_MAX;
+        continue;
+      }
+      if (MachineInterval < 0)
+      {
+        NextExecutionTime[m] = SimTime;
+        FramesToSkip[m] = (int)-MachineInterval - 1;
+      }
+      else
+      {
+        NextExecutionTime[m] = SimTime + MachineInterval;
+      }
+    }
+
+    // anything counting frames or already due needs the next frame
+    float Until = NextExecutionTime[m] - SimTime;
+    if ((FramesToSkip[m] > 0) || (Until <= 0)) Until = EVERY_FRAME_INTERVAL;
+    if ((Interval == DORMANT_INTERVAL) || (Until < 0) || ((Interval > 0) && (Until < Interval))) Interval = Until;
+  }
+
+  return Interval;
+}
+
+// checks the landing conditions in a snapshot with the SNAPSHOT_ARMING values
+// returns the ARMING_* flags of the conditions that are not met, 0 if they all are
+int StateMachine_CheckArming
+  (
+  const state_machine_t *Machine,
+  const sim_snapshot_t *Arming
+  )
+{
+  int Failures = 0;
+  if (Arming->IndicatedAirSpeed > Machine->Limits.MaxAirspeed)    Failures |= ARMING_AIRSPEED_TOO_HIGH;
+  if (Arming->FlapAngle < Machine->Limits.MinFlapAngle)           Failures |= ARMING_FLAPS_TOO_LOW;
+  if (Arming->GearDeployRatio < Machine->Limits.GearDownRatio)    Failures |= ARMING_GEAR_NOT_DOWN;
+  if (Arming->AltitudeAboveGround > Machine->Limits.MaxAltitude)  Failures |= ARMING_ALTITUDE_TOO_HIGH;
+
+  return Failures;
+}
+
+// checks the landing conditions and if they are met starts the manager,
+// otherwise tells the user what is wrong unless it was just said
+// returns true if the manager was started
+bool StateMachine_Enable
+  (
+  state_machine_t *Machine
+  )
+{
+  if (Machine->CurrentState != WAIT_FOR_USER)
+  {
+    Machine->Sim->Speak(Machine->Refcon, "Already enabled", SPEECH_PRIORITY_GUIDANCE);
+    return false;
+  }
+
+  sim_snapshot_t Arming;
+  Machine->Sim->ReadSnapshot(Machine->Refcon, &Arming, SNAPSHOT_ARMING | SNAPSHOT_SIM_TIME);
+
+  LOG_TRACE("Enable requested by user\n");
+  LOG_TRACE("Current IAS=%f (require %f or below)\n", Arming.IndicatedAirSpeed, Machine->Limits.MaxAirspeed);
+  LOG_TRACE("Current flap angle=%f (require %f or above)\n", Arming.FlapAngle, Machine->Limits.MinFlapAngle);
+  LOG_TRACE("Current gear deploy ratio=%f (require %f or above)\n", Arming.GearDeployRatio, Machine->Limits.GearDownRatio);
+  LOG_TRACE("Current altitude=%fm (require %fm or below)\n", Arming.AltitudeAboveGround, Machine->Limits.MaxAltitude);
+
+  return EnableWithArming(Machine, StateMachine_CheckArming(Machine, &Arming), Arming.SimTime);
+}
+
+// starts the manager using the result of an earlier StateMachine_CheckArming at a
+// sim time, e.g. from a background check, so nothing is read from the sim
+// returns true if the manager was started
+bool StateMachine_EnableChecked
+  (
+  state_machine_t *Machine,
+  int Failures,
+  float SimTime
+  )
+{
+  if (Machine->CurrentState != WAIT_FOR_USER)
+  {
+    Machine->Sim->Speak(Machine->Refcon, "Already enabled", SPEECH_PRIORITY_GUIDANCE);
+    return false;
+  }
+
+  LOG_TRACE("Enable requested by user, conditions checked at %f\n", SimTime);
+
+  return EnableWithArming(Machine, Failures, SimTime);
+}
+
+// starts the manager without checking the landing conditions
+void StateMachine_Arm
+  (
+  state_machine_t *Machine
+  )
+{
+  Machine->DeactivationRequested = false;
+  EnterState(Machine, START);
+  ScheduleNow(Machine);
+}
+
+// puts the state machine straight into a state without running the states before it,
+// for tools that exercise one state at a time. the filters start again from the next snapshot
+void StateMachine_SetState
+  (
+  state_machine_t *Machine,
+  states_t State
+  )
+{
+  // the state may be part way through a landing, so only the filters start again
+  Machine->DeactivationRequested = false;
+  ResetFilters(Machine);
+  EnterState(Machine, State);
+  ScheduleNow(Machine);
+}
+
+// asks the state machine to stop at its next execution
+void StateMachine_RequestDeactivation
+  (
+  state_machine_t *Machine
+  )
+{
+  if (Machine->CurrentState != WAIT_FOR_USER)
+  {
+    Machine->DeactivationRequested = true;
+    LOG_INFO("User requested deactivation\n");
+  }
+}
+
+// stops the manager immediately, releasing any commands it is holding
+void StateMachine_Stop
+  (
+  state_machine_t *Machine
+  )
+{
+  if (Machine->CurrentState == WAIT_FOR_END_OF_REVERSE) EndReverse(Machine);
+  Machine->RequestedCommands = 0;
+  ApplyCommands(Machine);
+
+  Machine->DeactivationRequested = false;
+  EnterState(Machine, WAIT_FOR_USER);
+  NextExecutionTime[Machine->Index] = FLT_MAX;
+}
+
+// returns the current state
+states_t StateMachine_GetState
+  (
+  const state_machine_t *Machine
+  )
+{
+  return Machine->CurrentState;
+}
+
+// returns the sim values used by the last execution
+const sim_snapshot_t *StateMachine_GetSnapshot
+  (
+  const state_machine_t *Machine
+  )
+{
+  return &Machine->Snapshot;
+}
+
+// returns the manager_command_t flags of the commands being held
+int StateMachine_GetActiveCommands
+  (
+  const state_machine_t *Machine
+  )
+{
+  return Machine->ActiveCommands;
+}
+
+// returns the ARMING_* flags of the conditions that were not met the last time
+// enabling was refused, 0 once the manager has been enabled
+int StateMachine_GetRefusedArming
+  (
+  const state_machine_t *Machine
+  )
+{
+  return Machine->LastArmingFailures;
+}
+
+// returns the smoothed vertical speed in meters per second from the last execution
+// waiting for touch down, negative when descending
+float StateMachine_GetVerticalSpeed
+  (
+  const state_machine_t *Machine
+  )
+{
+  return Machine->Predictor.VerticalSpeed;
+}
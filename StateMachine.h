@@ -0,0 +1,260 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Landing state machine
+// decides when to throttle down and when to apply and remove reverse thrust.
+// it doesn't use the XPLM, sim data comes in and commands go out through a
+// sim_interface_t so the same logic runs in the plugin and in offline tools
+// the states ask for commands to be held or released and the requests are sent to
+// the sim at the end of each execution, at most one begin or end for each command.
+// the decisions are made on filtered values so a bounce or a noisy airspeed doesn't
+// trip them, see Filters.h
+// each managed aircraft has its own state machine, the plugin only creates one for
+// the user aircraft but tools and other hosts can run many of them from one loop
+
+#ifndef _STATE_MACHINE_H_
+#define _STATE_MACHINE_H_
+
+// configuration section
+// default landing limits, aircraft profiles can change them
+// minimum speed in knots at which the reverse thrust can be enabled
+#define MIN_SPEED_REVERSE_THRUST 60.0f
+// maximum speed in knots at which the manager can be enabled
+#define MAX_AIRSPEED 160.0f
+// minimum flap angle at which the manager can be enabled
+#define MIN_FLAP_ANGLE 18.0f
+// maximum height above ground in meters at which the manager can be enabled
+#define MAX_ALTITUDE 152.4f
+// the ratio of the gears at or above which they are down
+#define GEAR_DOWN_RATIO 1.0f
+// time between executions of the state machine in phases that are not time critical, in seconds
+#define STATE_MACHINE_EXECUTION_INTERVAL 0.25f
+
+// longest time between executions that a profile can set, in seconds
+#define STATE_MACHINE_MAX_EXECUTION_INTERVAL 1.0f
+// flight loop interval that parks the flight loop until it is scheduled again
+#define DORMANT_INTERVAL 0.0f
+// flight loop interval that requests execution on the next frame
+#define EVERY_FRAME_INTERVAL -1.0f
+// height above ground in meters below which touch down is checked on every frame
+#define TOUCHDOWN_TRACKING_ALTITUDE 15.0f
+// predicted time to touch down in seconds below which touch down is checked on every frame
+#define TOUCHDOWN_TRACKING_TIME 3.0f
+// speed in knots above the minimum reverse thrust speed below which the end of reverse
+// thrust is checked on every frame
+#define REVERSE_CUTOFF_TRACKING_MARGIN 15.0f
+// speed in knots above the tracking margin the airspeed has to rise back to before the end
+// of reverse thrust stops being checked on every frame
+#define REVERSE_CUTOFF_TRACKING_HYSTERESIS 5.0f
+// number of the latest executions that must see the wheels on the ground, out of how many,
+// before they are taken as being down, so a wheel touching in a bounce doesn't count
+#define TOUCHDOWN_DEBOUNCE_REQUIRED 2
+#define TOUCHDOWN_DEBOUNCE_SAMPLES  3
+// time constant in seconds of the smoothing of the indicated airspeed
+#define AIRSPEED_SMOOTHING_TIME 0.1f
+// callouts made when reverse thrust is applied and when the user stops the manager
+#define REVERSE_CALLOUT    "Reverse"
+#define DISENGAGED_CALLOUT "Disengaged"
+// time in seconds the direct throttle mode takes to bring the throttles to idle
+#define THROTTLE_RETARD_TIME 1.0f
+// maximum number of engines
+#define SIM_MAX_ENGINES 8
+// maximum number of gears
+#define SIM_MAX_GEARS 10
+// maximum number of state machines, one for each managed aircraft
+#define STATE_MACHINE_MAX_INSTANCES 32
+// target decelerations in meters per second squared of the modulated reverse thrust settings
+#define REVERSE_TARGET_LO_DECELERATION  1.5f
+#define REVERSE_TARGET_MED_DECELERATION 2.2f
+#define REVERSE_TARGET_HI_DECELERATION  3.0f
+
+// state machine states
+typedef enum _states_t
+{
+  WAIT_FOR_USER,
+  START,
+  THROTTLE_DOWN,
+  WAIT_FOR_IDLE_THROTTLE,
+  WAIT_FOR_TOUCHDOWN,
+  APPLY_REVERSE,
+  WAIT_FOR_END_OF_REVERSE,
+  NUM_STATES
+} states_t;
+
+// values that can be read into a sim snapshot
+#define SNAPSHOT_INDICATED_AIRSPEED    0x01
+#define SNAPSHOT_THROTTLE_RATIO        0x02
+#define SNAPSHOT_ALL_WHEELS_ON_GROUND  0x04   // also reads MainGearOnGround
+#define SNAPSHOT_FLAP_ANGLE            0x08
+#define SNAPSHOT_GEAR_DEPLOY_RATIO     0x10
+#define SNAPSHOT_ALTITUDE_ABOVE_GROUND 0x20
+#define SNAPSHOT_SIM_TIME              0x40
+#define SNAPSHOT_ENGINE_THROTTLE_RATIO 0x80
+#define SNAPSHOT_GROUND_SPEED          0x100
+#define SNAPSHOT_ALL                   0x1FF
+// the values needed to decide if the manager can be enabled
+#define SNAPSHOT_ARMING (SNAPSHOT_INDICATED_AIRSPEED | SNAPSHOT_FLAP_ANGLE | SNAPSHOT_GEAR_DEPLOY_RATIO | SNAPSHOT_ALTITUDE_ABOVE_GROUND)
+
+// landing conditions that are not met, from StateMachine_CheckArming
+#define ARMING_AIRSPEED_TOO_HIGH 0x01
+#define ARMING_FLAPS_TOO_LOW     0x02
+#define ARMING_GEAR_NOT_DOWN     0x04
+#define ARMING_ALTITUDE_TOO_HIGH 0x08
+// number of combinations of the ARMING_* flags
+#define ARMING_NUM_COMBINATIONS  16
+// time in seconds during which the same refusal to enable isn't spoken again
+#define ARMING_SPEECH_DEBOUNCE_TIME 3.0f
+
+// one consistent view of the sim, read once per execution of the state machine
+typedef struct _sim_snapshot_t
+{
+  int   Fields;                 // which of the values below were read, SNAPSHOT_* flags
+  float IndicatedAirSpeed;      // knots
+  float ThrottleRatio;          // 0 = idle, 1 = full
+  int   AllWheelsOnGround;      // 1 if all wheels are on the ground
+  int   MainGearOnGround;       // 1 if the wheels of all the main gears are on the ground
+  float FlapAngle;              // degrees
+  float GearDeployRatio;        // 0 = up, 1 = down
+  float AltitudeAboveGround;    // meters
+  float SimTime;                // seconds
+  float GroundSpeed;            // meters per second
+  int   NumEngines;             // number of values in EngineThrottleRatio
+  float EngineThrottleRatio[SIM_MAX_ENGINES];   // 0 = idle, 1 = full, for each engine
+} sim_snapshot_t;
+
+// landing limits and timing, these can be different for each aircraft
+// they are read on every execution so they are kept as plain values
+typedef struct _landing_limits_t
+{
+  float MinSpeedReverseThrust;  // knots, reverse thrust is removed at this speed
+  float MaxAirspeed;            // knots, the manager can only be enabled at this speed or below
+  float MinFlapAngle;           // degrees, the manager can only be enabled at this flap angle or above
+  float MaxAltitude;            // meters above ground, the manager can only be enabled at this height or below
+  float GearDownRatio;          // 0 to 1, the manager can only be enabled with the gears deployed this far or more
+  float ExecutionInterval;      // seconds between executions in phases that are not time critical,
+                                // up to STATE_MACHINE_MAX_EXECUTION_INTERVAL
+} landing_limits_t;
+
+// ways of bringing the throttle to idle
+typedef enum _throttle_mode_t
+{
+  THROTTLE_MODE_COMMAND,    // hold the throttle down command until the sim reaches idle
+  THROTTLE_MODE_DIRECT      // write the throttle of each engine, reaching idle in a fixed time
+} throttle_mode_t;
+
+// how much reverse thrust to use
+typedef enum _reverse_target_t
+{
+  REVERSE_TARGET_FULL,      // full reverse until the minimum reverse thrust speed
+  REVERSE_TARGET_LO,        // enough reverse to slow down at REVERSE_TARGET_LO_DECELERATION
+  REVERSE_TARGET_MED,       // and so on
+  REVERSE_TARGET_HI,
+  REVERSE_NUM_TARGETS
+} reverse_target_t;
+
+// commands the state machine can hold, the values are also flags
+typedef enum _manager_command_t
+{
+  COMMAND_THROTTLE_DOWN  = 0x01,
+  COMMAND_REVERSE_THRUST = 0x02,     // full reverse thrust
+  COMMAND_MAINS_DOWN     = 0x04,    // issued once when the main gear touches down, e.g. to deploy the spoilers
+  COMMAND_REVERSE_DEPLOY = 0x08     // the reversers are deployed and the engine throttles set the reverse power
+} manager_command_t;
+// the commands that are held while reverse thrust is used, one or the other
+#define REVERSE_COMMANDS (COMMAND_REVERSE_THRUST | COMMAND_REVERSE_DEPLOY)
+
+// how urgent something said to the user is
+typedef enum _speech_priority_t
+{
+  SPEECH_PRIORITY_GUIDANCE,   // e.g. why the manager can't be enabled
+  SPEECH_PRIORITY_SAFETY,     // callouts the pilot needs to hear straight away, said before any guidance
+  SPEECH_NUM_PRIORITIES
+} speech_priority_t;
+
+// connects the state machine to the sim, Refcon is the value given to
+// StateMachine_Create and tells the sim which aircraft the call is for
+typedef struct _sim_interface_t
+{
+  // reads the requested SNAPSHOT_* values from the sim
+  void (*ReadSnapshot)(void *Refcon, sim_snapshot_t *Snapshot, int Fields);
+  // starts holding a command
+  void (*CommandBegin)(void *Refcon, manager_command_t Command);
+  // stops holding a command
+  void (*CommandEnd)(void *Refcon, manager_command_t Command);
+  // issues a command once
+  void (*CommandOnce)(void *Refcon, manager_command_t Command);
+  // gives voice guidance to the user, it may be said later or dropped if more urgent
+  // messages are waiting
+  void (*Speak)(void *Refcon, const char *Message, speech_priority_t Priority);
+  // sets the throttle of the first NumEngines engines
+  void (*SetEngineThrottles)(void *Refcon, const float *Ratios, int NumEngines);
+} sim_interface_t;
+
+// the state of one managed aircraft
+typedef struct _state_machine_t state_machine_t;
+
+// creates a state machine connected to the sim, Refcon is passed to every call of
+// the sim interface so it can tell the aircraft apart
+// returns NULL if there are already STATE_MACHINE_MAX_INSTANCES state machines
+extern state_machine_t *StateMachine_Create(const sim_interface_t *Sim, void *Refcon);
+// frees a state machine, it must be stopped first
+extern void StateMachine_Destroy(state_machine_t *Machine);
+// resets the state machine to WAIT_FOR_USER with the default settings
+extern void StateMachine_Init(state_machine_t *Machine);
+// sets the landing limits, StateMachine_Init resets them to the defaults
+// they can be changed at any time, the next execution uses them
+extern void StateMachine_SetLimits(state_machine_t *Machine, const landing_limits_t *NewLimits);
+// sets how the throttle is brought to idle and for THROTTLE_MODE_DIRECT how long
+// it takes in seconds, StateMachine_Init resets it to THROTTLE_MODE_COMMAND
+extern void StateMachine_SetThrottleMode(state_machine_t *Machine, throttle_mode_t Mode, float RetardTime);
+// sets how much reverse thrust to use, StateMachine_Init resets it to REVERSE_TARGET_FULL
+// which holds COMMAND_REVERSE_THRUST. the other targets hold COMMAND_REVERSE_DEPLOY and set
+// the reverse power by writing the engine throttles. a change takes effect from the next
+// time reverse thrust is applied
+extern void StateMachine_SetReverseTarget(state_machine_t *Machine, reverse_target_t Target);
+// sets SNAPSHOT_* values to read on every execution in addition to what the current state needs
+extern void StateMachine_SetExtraSnapshotFields(state_machine_t *Machine, int Fields);
+// executes the state machine once
+// returns the number of seconds to the next execution, a negative number of frames
+// or DORMANT_INTERVAL if it doesn't need executing until it is enabled again
+extern float StateMachine_Execute(state_machine_t *Machine);
+// executes every state machine that is due at a sim time, calling Executed after
+// each one so the caller can look at the result. this lets a single flight loop
+// run any number of aircraft, each one as often as its state needs
+// returns the number of seconds to the next state machine being due, a negative
+// number of frames or DORMANT_INTERVAL if none are running
+extern float StateMachine_ExecuteDue(float SimTime, void (*Executed)(state_machine_t *Machine));
+// checks the landing conditions in a snapshot with the SNAPSHOT_ARMING values
+// returns the ARMING_* flags of the conditions that are not met, 0 if they all are
+extern int StateMachine_CheckArming(const state_machine_t *Machine, const sim_snapshot_t *Arming);
+// checks the landing conditions and if they are met starts the manager,
+// otherwise tells the user what is wrong unless it was just said
+// returns true if the manager was started
+extern bool StateMachine_Enable(state_machine_t *Machine);
+// starts the manager using the result of an earlier StateMachine_CheckArming at a
+// sim time, e.g. from a background check, so nothing is read from the sim
+// returns true if the manager was started
+extern bool StateMachine_EnableChecked(state_machine_t *Machine, int Failures, float SimTime);
+// starts the manager without checking the landing conditions
+extern void StateMachine_Arm(state_machine_t *Machine);
+// puts the state machine straight into a state without running the states before it,
+// for tools that exercise one state at a time. the filters start again from the next snapshot
+extern void StateMachine_SetState(state_machine_t *Machine, states_t State);
+// asks the state machine to stop at its next execution
+extern void StateMachine_RequestDeactivation(state_machine_t *Machine);
+// stops the manager immediately, releasing any commands it is holding
+extern void StateMachine_Stop(state_machine_t *Machine);
+// returns the current state
+extern states_t StateMachine_GetState(const state_machine_t *Machine);
+// returns the sim values used by the last execution
+extern const sim_snapshot_t *StateMachine_GetSnapshot(const state_machine_t *Machine);
+// returns the manager_command_t flags of the commands being held
+extern int StateMachine_GetActiveCommands(const state_machine_t *Machine);
+// returns the ARMING_* flags of the conditions that were not met the last time
+// enabling was refused, 0 once the manager has been enabled
+extern int StateMachine_GetRefusedArming(const state_machine_t *Machine);
+// returns the smoothed vertical speed in meters per second from the last execution
+// waiting for touch down, negative when descending
+extern float StateMachine_GetVerticalSpeed(const state_machine_t *Machine);
+
+#endif // _STATE_MACHINE_H_
@@ -0,0 +1,148 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Status datarefs, see StatusDatarefs.h
+
+#include <stddef.h>
+#include "XPLMDataAccess.h"
+#include "DatarefBrowser.h"
+#include "StatusDatarefs.h"
+
+// names of the published datarefs
+#define STATUS_STATE_DATAREF           "landingthrottlemanager/state"
+#define STATUS_ENABLED_DATAREF         "landingthrottlemanager/enabled"
+#define STATUS_REJECTED_DATAREF        "landingthrottlemanager/rejected"
+#define STATUS_SHARED_STATE_DATAREF    "landingthrottlemanager/shared/state"
+#define STATUS_SHARED_REJECTED_DATAREF "landingthrottlemanager/shared/rejected"
+
+// the state machine being published
+static const state_machine_t *Manager = NULL;
+static XPLMDataRef StateRef = NULL;
+static XPLMDataRef EnabledRef = NULL;
+static XPLMDataRef RejectedRef = NULL;
+// the shared values and what was last written to them
+static XPLMDataRef SharedStateRef = NULL;
+static XPLMDataRef SharedRejectedRef = NULL;
+static int SharedState = WAIT_FOR_USER;
+static int SharedRejected = 0;
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// INTERNAL FUNCTIONS
+
+// reads the state of the manager
+static int ReadState
+  (
+  void *inRefcon
+  )
+{
+  return (int)StateMachine_GetState(Manager);
+}
+
+// reads whether the manager is enabled
+static int ReadEnabled
+  (
+  void *inRefcon
+  )
+{
+  return (StateMachine_GetState(Manager) != WAIT_FOR_USER) ? 1 : 0;
+}
+
+// reads the landing conditions that were not met the last time enabling was refused
+static int ReadRejected
+  (
+  void *inRefcon
+  )
+{
+  return StateMachine_GetRefusedArming(Manager);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// STATUS DATAREFS API
+
+// publishes the datarefs for a state machine
+void StatusDatarefs_Start
+  (
+  const state_machine_t *Machine
+  )
+{
+  Manager = Machine;
+
+  StateRef = XPLMRegisterDataAccessor(STATUS_STATE_DATAREF, xplmType_Int, 0,
+    ReadState, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL);
+  EnabledRef = XPLMRegisterDataAccessor(STATUS_ENABLED_DATAREF, xplmType_Int, 0,
+    ReadEnabled, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL);
+  RejectedRef = XPLMRegisterDataAccessor(STATUS_REJECTED_DATAREF, xplmType_Int, 0,
+    ReadRejected, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL);
+
+  // we write the shared values but don't need telling when they change
+  if (XPLMShareData(STATUS_SHARED_STATE_DATAREF, xplmType_Int, NULL, NULL)) SharedStateRef = XPLMFindDataRef(STATUS_SHARED_STATE_DATAREF);
+  if (XPLMShareData(STATUS_SHARED_REJECTED_DATAREF, xplmType_Int, NULL, NULL)) SharedRejectedRef = XPLMFindDataRef(STATUS_SHARED_REJECTED_DATAREF);
+
+  SharedState = (int)StateMachine_GetState(Manager);
+  SharedRejected = StateMachine_GetRefusedArming(Manager);
+  if (SharedStateRef != NULL) XPLMSetDatai(SharedStateRef, SharedState);
+  if (SharedRejectedRef != NULL) XPLMSetDatai(SharedRejectedRef, SharedRejected);
+}
+
+// tells dataref browsers such as DataRefTool about the datarefs, call once all plugins are loaded
+void StatusDatarefs_Announce
+  (
+  void
+  )
+{
+  XPLMPluginID Browser = DatarefBrowser_Find();
+  DatarefBrowser_Show(Browser, STATUS_STATE_DATAREF);
+  DatarefBrowser_Show(Browser, STATUS_ENABLED_DATAREF);
+  DatarefBrowser_Show(Browser, STATUS_REJECTED_DATAREF);
+}
+
+// notifies the plugins sharing the values if they have changed, call after anything
+// that can change the state machine
+void StatusDatarefs_Update
+  (
+  void
+  )
+{
+  if (Manager == NULL) return;
+
+  // writing shared data calls every other plugin's notification function so only
+  // write when something changed
+  int State = (int)StateMachine_GetState(Manager);
+  if (State != SharedState)
+  {
+    SharedState = State;
+    if (SharedStateRef != NULL) XPLMSetDatai(SharedStateRef, State);
+  }
+
+  int Rejected = StateMachine_GetRefusedArming(Manager);
+  if (Rejected != SharedRejected)
+  {
+    SharedRejected = Rejected;
+    if (SharedRejectedRef != NULL) XPLMSetDatai(SharedRejectedRef, Rejected);
+  }
+}
+
+// removes the datarefs
+void StatusDatarefs_Stop
+  (
+  void
+  )
+{
+  if (StateRef != NULL) XPLMUnregisterDataAccessor(StateRef);
+  if (EnabledRef != NULL) XPLMUnregisterDataAccessor(EnabledRef);
+  if (RejectedRef != NULL) XPLMUnregisterDataAccessor(RejectedRef);
+  StateRef = NULL;
+  EnabledRef = NULL;
+  RejectedRef = NULL;
+
+  if (SharedStateRef != NULL) XPLMUnshareData(STATUS_SHARED_STATE_DATAREF, xplmType_Int, NULL, NULL);
+  if (SharedRejectedRef != NULL) XPLMUnshareData(STATUS_SHARED_REJECTED_DATAREF, xplmType_Int, NULL, NULL);
+  SharedStateRef = NULL;
+  SharedRejectedRef = NULL;
+  Manager = NULL;
+}
@@ -0,0 +1,33 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Status datarefs
+// publishes what the manager is doing so other plugins and cockpit scripts don't
+// have to read the log:
+//   landingthrottlemanager/state     states_t of the manager, 0 = waiting for the user
+//   landingthrottlemanager/enabled   1 while the manager is enabled
+//   landingthrottlemanager/rejected  ARMING_* flags of the last refused enable, 0 once enabled
+// whether the manager can be enabled now is published by the arming monitor.
+// plugins that want to be told when the values change instead of polling them can
+// call XPLMShareData with a notification function on these, which are only written
+// when they change:
+//   landingthrottlemanager/shared/state     int, as landingthrottlemanager/state
+//   landingthrottlemanager/shared/rejected  int, as landingthrottlemanager/rejected
+// must only be used from the sim thread
+
+#ifndef _STATUS_DATAREFS_H_
+#define _STATUS_DATAREFS_H_
+
+#include "StateMachine.h"
+
+// publishes the datarefs for a state machine
+extern void StatusDatarefs_Start(const state_machine_t *Machine);
+// tells dataref browsers such as DataRefTool about the datarefs, call once all plugins are loaded
+extern void StatusDatarefs_Announce(void);
+// notifies the plugins sharing the values if they have changed, call after anything
+// that can change the state machine
+extern void StatusDatarefs_Update(void);
+// removes the datarefs
+extern void StatusDatarefs_Stop(void);
+
+#endif // _STATUS_DATAREFS_H_
@@ -0,0 +1,90 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Binary touchdown telemetry recorder, see Telemetry.h
+
+#include <string.h>
+#include "MappedFile.h"
+#include "Telemetry.h"
+
+// the mapped telemetry file
+static mapped_file_t File;
+// start of the file and of the ring of frames, NULL if not open
+static telemetry_header_t *Header = NULL;
+static telemetry_frame_t *Frames = NULL;
+
+// opens or creates the telemetry file at Path
+// returns true for success
+bool Telemetry_Open
+  (
+  const char *Path
+  )
+{
+  if (Header != NULL) return true;
+
+  if (!MappedFile_Open(&File, Path, sizeof(telemetry_header_t) + TELEMETRY_CAPACITY * sizeof(telemetry_frame_t)))
+  {
+    return false;
+  }
+
+  Header = (telemetry_header_t *)File.Data;
+  Frames = (telemetry_frame_t *)(Header + 1);
+
+  // start again if the file is new or has a different layout, otherwise
+  // carry on from where the last session stopped
+  if ((Header->Magic != TELEMETRY_MAGIC) || (Header->Version != TELEMETRY_VERSION) ||
+      (Header->FrameSize != sizeof(telemetry_frame_t)) || (Header->Capacity != TELEMETRY_CAPACITY))
+  {
+    memset(Header, 0, sizeof(telemetry_header_t));
+    Header->Magic     = TELEMETRY_MAGIC;
+    Header->Version   = TELEMETRY_VERSION;
+    Header->FrameSize = sizeof(telemetry_frame_t);
+    Header->Capacity  = TELEMETRY_CAPACITY;
+  }
+
+  return true;
+}
+
+// returns true if frames are being recorded
+bool Telemetry_IsOpen
+  (
+  void
+  )
+{
+  return Header != NULL;
+}
+
+// adds a frame to the ring
+void Telemetry_Record
+  (
+  const telemetry_frame_t *Frame
+  )
+{
+  if (Header == NULL) return;
+
+  Frames[Header->FramesWritten % TELEMETRY_CAPACITY] = *Frame;
+  Header->FramesWritten++;
+}
+
+// starts writing the recorded frames to disk, call after a landing
+void Telemetry_Flush
+  (
+  void
+  )
+{
+  MappedFile_Flush(&File);
+}
+
+// closes the telemetry file
+void Telemetry_Close
+  (
+  void
+  )
+{
+  if (Header == NULL) return;
+
+  MappedFile_Flush(&File);
+  MappedFile_Close(&File);
+  Header = NULL;
+  Frames = NULL;
+}
@@ -0,0 +1,73 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Binary touchdown telemetry recorder
+// while the manager is armed a fixed size frame is recorded on every execution of
+// the state machine. frames go into a ring in a preallocated memory mapped file so
+// recording never allocates, formats text or makes a system call. a frame has the
+// values the state machine read on that execution, recording doesn't read anything
+// more from the sim, so Fields says which ones are new and the others are held from
+// the last execution that read them
+
+#ifndef _TELEMETRY_H_
+#define _TELEMETRY_H_
+
+#include <stdint.h>
+
+// identifies a telemetry file, "LTMT"
+#define TELEMETRY_MAGIC   0x544D544C
+// version of the file layout
+#define TELEMETRY_VERSION 4
+// number of frames in the ring, about 18 minutes of per-frame recording at 60fps
+#define TELEMETRY_CAPACITY 65536
+// number of engines whose throttles are recorded
+#define TELEMETRY_MAX_ENGINES 8
+
+// commands held by the manager, for telemetry_frame_t Commands
+#define TELEMETRY_COMMAND_THROTTLE_DOWN 0x01
+#define TELEMETRY_COMMAND_REVERSE_THRUST 0x02     // full or modulated
+
+// start of the file
+typedef struct _telemetry_header_t
+{
+  uint32_t Magic;           // TELEMETRY_MAGIC
+  uint32_t Version;         // TELEMETRY_VERSION
+  uint32_t FrameSize;       // sizeof(telemetry_frame_t)
+  uint32_t Capacity;        // number of frames in the ring
+  uint64_t FramesWritten;   // total frames ever written, the next one goes in slot FramesWritten % Capacity
+  uint64_t Reserved;
+} telemetry_header_t;
+
+// one execution of the state machine, the sim values it used and the result
+typedef struct _telemetry_frame_t
+{
+  float   SimTime;              // seconds
+  float   IndicatedAirSpeed;    // knots
+  float   ThrottleRatio;        // 0 = idle, 1 = full
+  float   AltitudeAboveGround;  // meters
+  float   FlapAngle;            // degrees
+  float   GearDeployRatio;      // 0 = up, 1 = down
+  uint8_t AllWheelsOnGround;    // 1 if all wheels are on the ground
+  uint8_t State;                // states_t at the end of the execution
+  uint8_t Commands;             // TELEMETRY_COMMAND_* flags at the end of the execution
+  uint8_t MainGearOnGround;     // 1 if the wheels of all the main gears are on the ground
+  uint16_t Fields;              // SNAPSHOT_* flags of the values read on this execution
+  uint8_t NumEngines;           // number of engines in EngineThrottleRatio
+  uint8_t Reserved;
+  float   GroundSpeed;          // meters per second
+  float   EngineThrottleRatio[TELEMETRY_MAX_ENGINES];   // 0 = idle, 1 = full
+} telemetry_frame_t;
+
+// opens or creates the telemetry file at Path
+// returns true for success
+extern bool Telemetry_Open(const char *Path);
+// returns true if frames are being recorded
+extern bool Telemetry_IsOpen(void);
+// adds a frame to the ring
+extern void Telemetry_Record(const telemetry_frame_t *Frame);
+// starts writing the recorded frames to disk, call after a landing
+extern void Telemetry_Flush(void);
+// closes the telemetry file
+extern void Telemetry_Close(void);
+
+#endif // _TELEMETRY_H_
@@ -0,0 +1,666 @@
+// Landing Throttle Manager - Benchmark
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Measures the cost of the work the plugin does inside x-plane's frame, so a
+// change that makes a frame more expensive can be caught before it ships.
+// each benchmark runs its operation in batches against a mocked sim and reports
+// the mean time per operation and the 99th percentile over the batches. a single
+// operation is shorter than the clock resolution on some platforms so individual
+// operations are not timed
+//
+// the state machine is timed one execution at a time in each state, with sim values
+// that take each path through the state, and a full fleet of them is stepped the way
+// the plugin's flight loop steps them. the logger is stopped while it is timed
+// so those figures don't include queueing the diagnostic messages, that is timed
+// separately
+//
+// usage: Benchmark [--save <results file>] [--baseline <results file>] [--tolerance <percent>]
+//   --save       writes the results so they can be used as a baseline later
+//   --baseline   compares the results with a saved run and fails if any are slower
+//   --tolerance  how much slower than the baseline is allowed, default 10%
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "Aircraft.h"
+#include "Filters.h"
+#include "Logger.h"
+#include "StateMachine.h"
+
+// number of timed batches for each benchmark
+#define BENCHMARK_SAMPLES 200
+// number of untimed batches run first to warm up the caches and branch predictors
+#define BENCHMARK_WARMUP_SAMPLES 20
+// operations in each batch
+#define BENCHMARK_BATCH_OPS 1000
+// operations in each batch of the logger benchmark, less than the ring size so nothing is dropped
+#define BENCHMARK_LOGGER_BATCH_OPS 512
+// default allowed slow down from the baseline in percent
+#define BENCHMARK_DEFAULT_TOLERANCE 10.0
+// log file written by the logger benchmark
+#define BENCHMARK_LOG_FILE_NAME "Benchmark.log"
+// profiles file written by the matching benchmark
+#define BENCHMARK_PROFILES_FILE_NAME "Benchmark.profiles"
+// number of profiles in the profiles file written by the matching benchmark
+#define BENCHMARK_NUM_PROFILES 100
+
+// one benchmark
+typedef struct _benchmark_t
+{
+  const char *Name;               // no spaces, identifies the benchmark in the results file
+  void (*Setup)(void);            // called once before the batches, may be NULL
+  void (*Operation)(void);        // the operation being timed
+  void (*BetweenBatches)(void);   // called untimed after each batch, may be NULL
+  void (*Teardown)(void);         // called once after the batches, may be NULL
+  int OpsPerBatch;
+} benchmark_t;
+
+// the result of one benchmark
+typedef struct _benchmark_result_t
+{
+  char   Name[64];
+  double MeanNs;    // nanoseconds per operation
+  double P99Ns;     // 99th percentile of the batches, nanoseconds per operation
+} benchmark_result_t;
+
+// the sim values the mocked sim hands to the state machines
+static sim_snapshot_t MockSim;
+// the state machine the benchmarks run, and the others the fleet benchmark adds to it
+static state_machine_t *Manager = NULL;
+static state_machine_t *Fleet[STATE_MACHINE_MAX_INSTANCES - 1];
+// state the tick benchmarks start each execution in
+static states_t TickState = WAIT_FOR_USER;
+// aircraft description the matching benchmark uses, and a copy it can lower case
+static const char *MatchDescription = "";
+// stops the compiler removing operations whose results aren't used
+static volatile int Sink = 0;
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// MOCKED SIM
+
+// copies the requested values, standing in for reading datarefs
+static void MockReadSnapshot
+  (
+  void *Refcon,
+  sim_snapshot_t *Snapshot,
+  int Fields
+  )
+{
+  Snapshot->Fields = Fields;
+
+  if (Fields & SNAPSHOT_INDICATED_AIRSPEED)    Snapshot->IndicatedAirSpeed   = MockSim.IndicatedAirSpeed;
+  if (Fields & SNAPSHOT_THROTTLE_RATIO)        Snapshot->ThrottleRatio       = MockSim.ThrottleRatio;
+  if (Fields & SNAPSHOT_ALL_WHEELS_ON_GROUND)
+  {
+    Snapshot->AllWheelsOnGround = MockSim.AllWheelsOnGround;
+    Snapshot->MainGearOnGround  = MockSim.MainGearOnGround;
+  }
+  if (Fields & SNAPSHOT_FLAP_ANGLE)            Snapshot->FlapAngle           = MockSim.FlapAngle;
+  if (Fields & SNAPSHOT_GEAR_DEPLOY_RATIO)     Snapshot->GearDeployRatio     = MockSim.GearDeployRatio;
+  if (Fields & SNAPSHOT_ALTITUDE_ABOVE_GROUND) Snapshot->AltitudeAboveGround = MockSim.AltitudeAboveGround;
+  if (Fields & SNAPSHOT_SIM_TIME)              Snapshot->SimTime             = MockSim.SimTime;
+  if (Fields & SNAPSHOT_GROUND_SPEED)          Snapshot->GroundSpeed         = MockSim.GroundSpeed;
+
+  if (Fields & SNAPSHOT_ENGINE_THROTTLE_RATIO)
+  {
+    Snapshot->NumEngines = MockSim.NumEngines;
+    memcpy(Snapshot->EngineThrottleRatio, MockSim.EngineThrottleRatio, sizeof(Snapshot->EngineThrottleRatio));
+  }
+}
+
+// commands are counted, standing in for XPLMCommandBegin
+static void MockCommandBegin
+  (
+  void *Refcon,
+  manager_command_t Command
+  )
+{
+  Sink = Sink + Command;
+}
+
+// commands are counted, standing in for XPLMCommandEnd
+static void MockCommandEnd
+  (
+  void *Refcon,
+  manager_command_t Command
+  )
+{
+  Sink = Sink - Command;
+}
+
+// commands are counted, standing in for XPLMCommandOnce
+static void MockCommandOnce
+  (
+  void *Refcon,
+  manager_command_t Command
+  )
+{
+  Sink = Sink + Command;
+}
+
+// the benchmark is silent
+static void MockSpeak
+  (
+  void *Refcon,
+  const char *Message,
+  speech_priority_t Priority
+  )
+{
+  Sink = Sink + Message[0];
+}
+
+// throttles are counted, standing in for writing the throttle datarefs
+static void MockSetEngineThrottles
+  (
+  void *Refcon,
+  const float *Ratios,
+  int NumEngines
+  )
+{
+  Sink = Sink + NumEngines;
+}
+
+static const sim_interface_t MockInterface =
+{
+  MockReadSnapshot,
+  MockCommandBegin,
+  MockCommandEnd,
+  MockCommandOnce,
+  MockSpeak,
+  MockSetEngineThrottles
+};
+
+// sets the mocked sim to a stable approach that meets the landing conditions
+static void SetApproach
+  (
+  void
+  )
+{
+  MockSim.IndicatedAirSpeed   = 140.0f;
+  MockSim.ThrottleRatio       = 0.4f;
+  MockSim.AllWheelsOnGround   = 0;
+  MockSim.MainGearOnGround    = 0;
+  MockSim.FlapAngle           = 22.0f;
+  MockSim.GearDeployRatio     = GEAR_DOWN_RATIO;
+  MockSim.AltitudeAboveGround = 120.0f;
+  MockSim.SimTime             = 1000.0f;
+  MockSim.GroundSpeed         = 72.0f;
+  MockSim.NumEngines          = 2;
+  for (int e = 0; e < SIM_MAX_ENGINES; e++) MockSim.EngineThrottleRatio[e] = (e < MockSim.NumEngines) ? MockSim.ThrottleRatio : 0.0f;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// BENCHMARKS
+
+// one execution of the state machine starting in TickState
+static void TickOperation
+  (
+  void
+  )
+{
+  StateMachine_SetState(Manager, TickState);
+  Sink = Sink + (int)StateMachine_Execute(Manager);
+}
+
+static void SetupWaitForUser(void)                 { SetApproach(); TickState = WAIT_FOR_USER; }
+static void SetupStart(void)                       { SetApproach(); TickState = START; }
+static void SetupThrottleDown(void)                { SetApproach(); TickState = THROTTLE_DOWN; }
+static void SetupWaitForIdleThrottleSpooling(void) { SetApproach(); TickState = WAIT_FOR_IDLE_THROTTLE; }
+static void SetupWaitForIdleThrottleIdle(void)     { SetApproach(); MockSim.ThrottleRatio = 0.0f; TickState = WAIT_FOR_IDLE_THROTTLE; }
+static void SetupWaitForIdleThrottleDirect(void)   { SetApproach(); StateMachine_SetThrottleMode(Manager, THROTTLE_MODE_DIRECT, THROTTLE_RETARD_TIME); StateMachine_SetState(Manager, THROTTLE_DOWN); StateMachine_Execute(Manager); TickState = WAIT_FOR_IDLE_THROTTLE; MockSim.SimTime += THROTTLE_RETARD_TIME / 2; }
+static void SetupWaitForTouchdownHigh(void)        { SetApproach(); MockSim.ThrottleRatio = 0.0f; TickState = WAIT_FOR_TOUCHDOWN; }
+static void SetupWaitForTouchdownFlare(void)       { SetupWaitForTouchdownHigh(); MockSim.AltitudeAboveGround = 3.0f; }
+static void SetupWaitForTouchdownLanded(void)      { SetupWaitForTouchdownFlare(); MockSim.AltitudeAboveGround = 0.0f; MockSim.MainGearOnGround = 1; MockSim.AllWheelsOnGround = 1; }
+static void SetupApplyReverse(void)                { SetupWaitForTouchdownLanded(); MockSim.IndicatedAirSpeed = 125.0f; TickState = APPLY_REVERSE; }
+static void SetupWaitForEndOfReverseFast(void)     { SetupApplyReverse(); TickState = WAIT_FOR_END_OF_REVERSE; }
+static void SetupWaitForEndOfReverseSlowing(void)  { SetupWaitForEndOfReverseFast(); MockSim.IndicatedAirSpeed = 70.0f; }
+static void SetupWaitForEndOfReverseCutoff(void)   { SetupWaitForEndOfReverseFast(); MockSim.IndicatedAirSpeed = 58.0f; }
+
+// one execution of the state machine on the next frame of a landing roll, slowing
+// down at 2m/s/s at 60 frames per second
+static void TickRollOutOperation
+  (
+  void
+  )
+{
+  MockSim.SimTime += 1.0f / 60.0f;
+  MockSim.GroundSpeed -= 2.0f / 60.0f;
+  TickOperation();
+}
+
+static void SetupWaitForEndOfReverseModulated(void) { SetupWaitForEndOfReverseFast(); StateMachine_SetReverseTarget(Manager, REVERSE_TARGET_MED); }
+static void ResetRollOut(void)                     { MockSim.GroundSpeed = 72.0f; }
+
+// the user enabling the manager, then stopping it ready for the next operation
+static void EnableOperation
+  (
+  void
+  )
+{
+  Sink = Sink + (StateMachine_Enable(Manager) ? 1 : 0);
+  StateMachine_Stop(Manager);
+}
+
+// one frame of a fleet of aircraft all in the flare, the worst case for one flight
+// loop stepping every aircraft as each one is executed on every frame
+static void TickFleetOperation
+  (
+  void
+  )
+{
+  MockSim.SimTime += 1.0f / 60.0f;
+  Sink = Sink + (int)StateMachine_ExecuteDue(MockSim.SimTime, NULL);
+}
+
+// fills the state machines up to STATE_MACHINE_MAX_INSTANCES, all waiting for touch down in the flare
+static void SetupFleet
+  (
+  void
+  )
+{
+  SetupWaitForTouchdownFlare();
+  StateMachine_SetState(Manager, WAIT_FOR_TOUCHDOWN);
+  for (int m = 0; m < STATE_MACHINE_MAX_INSTANCES - 1; m++)
+  {
+    Fleet[m] = StateMachine_Create(&MockInterface, NULL);
+    StateMachine_SetState(Fleet[m], WAIT_FOR_TOUCHDOWN);
+  }
+}
+
+// removes the state machines the fleet benchmark added
+static void TeardownFleet
+  (
+  void
+  )
+{
+  for (int m = 0; m < STATE_MACHINE_MAX_INSTANCES - 1; m++)
+  {
+    StateMachine_Stop(Fleet[m]);
+    StateMachine_Destroy(Fleet[m]);
+  }
+}
+
+static void SetupEnableConditionsMet(void)    { SetApproach(); }
+static void SetupEnableConditionsNotMet(void) { SetApproach(); MockSim.IndicatedAirSpeed = 200.0f; MockSim.FlapAngle = 5.0f; MockSim.GearDeployRatio = 0.0f; MockSim.AltitudeAboveGround = 900.0f; }
+
+// matching the description of a newly loaded aircraft
+static void MatchOperation
+  (
+  void
+  )
+{
+  Sink = Sink + ((Aircraft_Match(MatchDescription, AIRCRAFT_DESCRIPTION_SIZE) != NULL) ? 1 : 0);
+}
+
+static void SetupMatchKnown(void)   { MatchDescription = "X-Crafts ERJ-175 Embraer E175 Regional Jet, Version 2.4.1"; }
+static void SetupMatchUnknown(void) { MatchDescription = "Boeing 737-800 Laminar Research Next Generation Twin Jet"; }
+static void SetupMatchLivery(void)  { MatchDescription = "  X-CRAFTS   ERJ-175,  Embraer E175 -- Regional Jet (Republic Airways / United Express)"; }
+
+// loads a fleet sized profiles file with the known aircraft last
+static void SetupMatchFleet
+  (
+  void
+  )
+{
+  FILE *File = fopen(BENCHMARK_PROFILES_FILE_NAME, "w");
+  if (File == NULL)
+  {
+    fprintf(stderr, "Unable to create %s\n", BENCHMARK_PROFILES_FILE_NAME);
+    exit(1);
+  }
+  for (int p = 0; p < BENCHMARK_NUM_PROFILES - 1; p++)
+  {
+    fprintf(File, "[Aircraft %d]\nmatch = maker%d model %d\nmatch = type%d\n", p, p % 10, p, p);
+  }
+  fprintf(File, "[X-Crafts ERJ Family]\nmatch = x-crafts erj\n");
+  fclose(File);
+
+  Aircraft_LoadProfiles(BENCHMARK_PROFILES_FILE_NAME);
+  remove(BENCHMARK_PROFILES_FILE_NAME);
+  SetupMatchKnown();
+}
+
+static void TeardownMatchFleet(void) { Aircraft_Init(); }
+
+// queueing a diagnostic message with a typical set of arguments
+static void LoggerOperation
+  (
+  void
+  )
+{
+  LOG_INFO("Indicated air speed=%f which is above the minimum of %f, waiting for end condition\n", MockSim.IndicatedAirSpeed, MIN_SPEED_REVERSE_THRUST);
+}
+
+// queueing a message below the runtime log level
+static void LoggerFilteredOperation
+  (
+  void
+  )
+{
+  LOG_TRACE("Current IAS=%f (require %f or below)\n", MockSim.IndicatedAirSpeed, MAX_AIRSPEED);
+}
+
+static void SetupLogger
+  (
+  void
+  )
+{
+  SetApproach();
+  if (!Logger_Start(BENCHMARK_LOG_FILE_NAME))
+  {
+    fprintf(stderr, "Unable to create %s\n", BENCHMARK_LOG_FILE_NAME);
+    exit(1);
+  }
+  Logger_SetLevel(LOG_LEVEL_INFO);
+}
+
+// lets the background thread empty the ring so the next batch isn't dropped
+static void WaitForLogger
+  (
+  void
+  )
+{
+  while (Logger_GetPendingCount() > 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+static void TeardownLogger
+  (
+  void
+  )
+{
+  Logger_Stop();
+  if (Logger_GetDroppedCount() > 0) fprintf(stderr, "Warning: %u log records were dropped\n", Logger_GetDroppedCount());
+  remove(BENCHMARK_LOG_FILE_NAME);
+}
+
+// the filters, fed a signal that changes on every sample so each one takes its slowest path
+static debouncer_t Debouncer;
+static hysteresis_t Band;
+static ema_t Average;
+static int FilterSample = 0;
+
+static void SetupFilters
+  (
+  void
+  )
+{
+  Filters_InitDebouncer(&Debouncer, TOUCHDOWN_DEBOUNCE_REQUIRED, TOUCHDOWN_DEBOUNCE_SAMPLES);
+  Filters_InitHysteresis(&Band, MIN_SPEED_REVERSE_THRUST, MIN_SPEED_REVERSE_THRUST + REVERSE_CUTOFF_TRACKING_HYSTERESIS);
+  Filters_InitEma(&Average, AIRSPEED_SMOOTHING_TIME);
+  FilterSample = 0;
+}
+
+// one sample of a wheel flickering on and off the ground
+static void DebounceOperation
+  (
+  void
+  )
+{
+  FilterSample++;
+  Sink = Sink + (Filters_Debounce(&Debouncer, (FilterSample & 1) != 0) ? 1 : 0);
+}
+
+// one sample of an airspeed crossing in and out of the band
+static void HysteresisOperation
+  (
+  void
+  )
+{
+  FilterSample++;
+  Sink = Sink + (Filters_IsLow(&Band, (FilterSample & 1) ? MIN_SPEED_REVERSE_THRUST - 1.0f : MIN_SPEED_REVERSE_THRUST + REVERSE_CUTOFF_TRACKING_HYSTERESIS + 1.0f) ? 1 : 0);
+}
+
+// one sample of a noisy airspeed at 60 frames per second
+static void AverageOperation
+  (
+  void
+  )
+{
+  FilterSample++;
+  Sink = Sink + (int)Filters_Average(&Average, FilterSample / 60.0f, (FilterSample & 1) ? 59.0f : 61.0f);
+}
+
+// all the benchmarks, in the order they are run
+static const benchmark_t Benchmarks[] =
+{
+  {"tick.wait_for_user",                     SetupWaitForUser,                  TickOperation,           NULL,          NULL,               BENCHMARK_BATCH_OPS},
+  {"tick.start",                             SetupStart,                        TickOperation,           NULL,          NULL,               BENCHMARK_BATCH_OPS},
+  {"tick.throttle_down",                     SetupThrottleDown,                 TickOperation,           NULL,          NULL,               BENCHMARK_BATCH_OPS},
+  {"tick.wait_for_idle_throttle.spooling",   SetupWaitForIdleThrottleSpooling,  TickOperation,           NULL,          NULL,               BENCHMARK_BATCH_OPS},
+  {"tick.wait_for_idle_throttle.idle",       SetupWaitForIdleThrottleIdle,      TickOperation,           NULL,          NULL,               BENCHMARK_BATCH_OPS},
+  {"tick.wait_for_idle_throttle.direct",     SetupWaitForIdleThrottleDirect,    TickOperation,           NULL,          NULL,               BENCHMARK_BATCH_OPS},
+  {"tick.wait_for_touchdown.high",           SetupWaitForTouchdownHigh,         TickOperation,           NULL,          NULL,               BENCHMARK_BATCH_OPS},
+  {"tick.wait_for_touchdown.flare",          SetupWaitForTouchdownFlare,        TickOperation,           NULL,          NULL,               BENCHMARK_BATCH_OPS},
+  {"tick.wait_for_touchdown.landed",         SetupWaitForTouchdownLanded,       TickOperation,           NULL,          NULL,               BENCHMARK_BATCH_OPS},
+  {"tick.apply_reverse",                     SetupApplyReverse,                 TickOperation,           NULL,          NULL,               BENCHMARK_BATCH_OPS},
+  {"tick.wait_for_end_of_reverse.fast",      SetupWaitForEndOfReverseFast,      TickOperation,           NULL,          NULL,               BENCHMARK_BATCH_OPS},
+  {"tick.wait_for_end_of_reverse.slowing",   SetupWaitForEndOfReverseSlowing,   TickOperation,           NULL,          NULL,               BENCHMARK_BATCH_OPS},
+  {"tick.wait_for_end_of_reverse.cutoff",    SetupWaitForEndOfReverseCutoff,    TickOperation,           NULL,          NULL,               BENCHMARK_BATCH_OPS},
+  {"tick.wait_for_end_of_reverse.modulated", SetupWaitForEndOfReverseModulated, TickRollOutOperation,    ResetRollOut,  NULL,               BENCHMARK_BATCH_OPS},
+  {"tick.fleet.flare",                       SetupFleet,                        TickFleetOperation,      NULL,          TeardownFleet,      BENCHMARK_BATCH_OPS},
+  {"enable.conditions_met",                  SetupEnableConditionsMet,          EnableOperation,         NULL,          NULL,               BENCHMARK_BATCH_OPS},
+  {"enable.conditions_not_met",              SetupEnableConditionsNotMet,       EnableOperation,         NULL,          NULL,               BENCHMARK_BATCH_OPS},
+  {"aircraft.match.known",                   SetupMatchKnown,                   MatchOperation,          NULL,          NULL,               BENCHMARK_BATCH_OPS},
+  {"aircraft.match.unknown",                 SetupMatchUnknown,                 MatchOperation,          NULL,          NULL,               BENCHMARK_BATCH_OPS},
+  {"aircraft.match.livery",                  SetupMatchLivery,                  MatchOperation,          NULL,          NULL,               BENCHMARK_BATCH_OPS},
+  {"aircraft.match.fleet",                   SetupMatchFleet,                   MatchOperation,          NULL,          TeardownMatchFleet, BENCHMARK_BATCH_OPS},
+  {"filters.debounce",                       SetupFilters,                      DebounceOperation,       NULL,          NULL,               BENCHMARK_BATCH_OPS},
+  {"filters.hysteresis",                     SetupFilters,                      HysteresisOperation,     NULL,          NULL,               BENCHMARK_BATCH_OPS},
+  {"filters.average",                        SetupFilters,                      AverageOperation,        NULL,          NULL,               BENCHMARK_BATCH_OPS},
+  {"logger.write",                           SetupLogger,                       LoggerOperation,         WaitForLogger, TeardownLogger,     BENCHMARK_LOGGER_BATCH_OPS},
+  {"logger.filtered",                        SetupLogger,                       LoggerFilteredOperation, NULL,          TeardownLogger,     BENCHMARK_BATCH_OPS}
+};
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// INTERNAL FUNCTIONS
+
+// runs one benchmark
+static void RunBenchmark
+  (
+  const benchmark_t *Benchmark,
+  benchmark_result_t *Result
+  )
+{
+  std::vector<double> Samples;
+
+  StateMachine_Init(Manager);
+  if (Benchmark->Setup != NULL) Benchmark->Setup();
+
+  for (int s = 0; s < BENCHMARK_WARMUP_SAMPLES + BENCHMARK_SAMPLES; s++)
+  {
+    auto Start = std::chrono::steady_clock::now();
+    for (int o = 0; o < Benchmark->OpsPerBatch; o++) Benchmark->Operation();
+    auto End = std::chrono::steady_clock::now();
+
+    if (s >= BENCHMARK_WARMUP_SAMPLES)
+    {
+      Samples.push_back(std::chrono::duration<double, std::nano>(End - Start).count() / Benchmark->OpsPerBatch);
+    }
+
+    if (Benchmark->BetweenBatches != NULL) Benchmark->BetweenBatches();
+  }
+
+  if (Benchmark->Teardown != NULL) Benchmark->Teardown();
+  StateMachine_Stop(Manager);
+
+  double Total = 0;
+  for (size_t s = 0; s < Samples.size(); s++) Total += Samples[s];
+  std::sort(Samples.begin(), Samples.end());
+
+  strncpy(Result->Name, Benchmark->Name, sizeof(Result->Name) - 1);
+  Result->Name[sizeof(Result->Name) - 1] = '\0';
+  Result->MeanNs = Total / Samples.size();
+  Result->P99Ns  = Samples[(size_t)(0.99 * (Samples.size() - 1))];
+}
+
+// writes the results to a file that can be used as a baseline
+// returns true for success
+static bool SaveResults
+  (
+  const char *Path,
+  const std::vector<benchmark_result_t> &Results
+  )
+{
+  FILE *File = fopen(Path, "w");
+  if (File == NULL)
+  {
+    fprintf(stderr, "Unable to create %s\n", Path);
+    return false;
+  }
+
+  for (size_t r = 0; r < Results.size(); r++)
+  {
+    fprintf(File, "%s %.2f %.2f\n", Results[r].Name, Results[r].MeanNs, Results[r].P99Ns);
+  }
+
+  fclose(File);
+  return true;
+}
+
+// reads results written by SaveResults
+// returns true for success
+static bool LoadResults
+  (
+  const char *Path,
+  std::vector<benchmark_result_t> &Results
+  )
+{
+  FILE *File = fopen(Path, "r");
+  if (File == NULL)
+  {
+    fprintf(stderr, "Unable to open %s\n", Path);
+    return false;
+  }
+
+  benchmark_result_t Result;
+  Results.clear();
+  while (fscanf(File, "%63s %lf %lf", Result.Name, &Result.MeanNs, &Result.P99Ns) == 3)
+  {
+    Results.push_back(Result);
+  }
+
+  fclose(File);
+  return true;
+}
+
+// finds a result by name
+// returns NULL if there isn't one
+static const benchmark_result_t *FindResult
+  (
+  const std::vector<benchmark_result_t> &Results,
+  const char *Name
+  )
+{
+  for (size_t r = 0; r < Results.size(); r++)
+  {
+    if (strcmp(Results[r].Name, Name) == 0) return &Results[r];
+  }
+
+  return NULL;
+}
+
+// returns the change from a baseline figure in percent
+static double PercentChange
+  (
+  double Baseline,
+  double Current
+  )
+{
+  if (Baseline <= 0) return 0;
+  return ((Current - Baseline) / Baseline) * 100.0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// MAIN
+
+int main
+  (
+  int argc,
+  char *argv[]
+  )
+{
+  const char *SavePath = NULL;
+  const char *BaselinePath = NULL;
+  double Tolerance = BENCHMARK_DEFAULT_TOLERANCE;
+
+  for (int a = 1; a < argc; a++)
+  {
+    if ((strcmp(argv[a], "--save") == 0) && (a + 1 < argc))
+    {
+      SavePath = argv[++a];
+    }
+    else if ((strcmp(argv[a], "--baseline") == 0) && (a + 1 < argc))
+    {
+      BaselinePath = argv[++a];
+    }
+    else if ((strcmp(argv[a], "--tolerance") == 0) && (a + 1 < argc))
+    {
+      Tolerance = atof(argv[++a]);
+    }
+    else
+    {
+      fprintf(stderr, "usage: %s [--save <results file>] [--baseline <results file>] [--tolerance <percent>]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  std::vector<benchmark_result_t> Baseline;
+  if ((BaselinePath != NULL) && !LoadResults(BaselinePath, Baseline)) return 1;
+
+  printf("%-40s %10s %10s", "benchmark", "ns/op", "p99 ns/op");
+  if (BaselinePath != NULL) printf(" %9s %9s", "mean", "p99");
+  printf("\n");
+
+  Aircraft_Init();
+  Manager = StateMachine_Create(&MockInterface, NULL);
+
+  std::vector<benchmark_result_t> Results;
+  int Regressions = 0;
+  int NumBenchmarks = sizeof(Benchmarks) / sizeof(benchmark_t);
+
+  for (int b = 0; b < NumBenchmarks; b++)
+  {
+    benchmark_result_t Result;
+    RunBenchmark(&Benchmarks[b], &Result);
+    Results.push_back(Result);
+
+    printf("%-40s %10.1f %10.1f", Result.Name, Result.MeanNs, Result.P99Ns);
+
+    const benchmark_result_t *Previous = (BaselinePath != NULL) ? FindResult(Baseline, Result.Name) : NULL;
+    if (Previous != NULL)
+    {
+      double MeanChange = PercentChange(Previous->MeanNs, Result.MeanNs);
+      double P99Change = PercentChange(Previous->P99Ns, Result.P99Ns);
+      printf(" %+8.1f%% %+8.1f%%", MeanChange, P99Change);
+
+      if ((MeanChange > Tolerance) || (P99Change > Tolerance))
+      {
+        printf("  REGRESSION");
+        Regressions++;
+      }
+    }
+    else if (BaselinePath != NULL)
+    {
+      printf(" %9s %9s", "new", "new");
+    }
+    printf("\n");
+  }
+
+  if ((SavePath != NULL) && !SaveResults(SavePath, Results)) return 1;
+
+  if (Regressions > 0)
+  {
+    printf("%d benchmarks are more than %.1f%% slower than the baseline\n", Regressions, Tolerance);
+    return 2;
+  }
+
+  return 0;
+}
@@ -0,0 +1,612 @@
+// Landing Throttle Manager - FakeSim
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Flies the whole plugin through approaches and rollouts against a fake X-Plane,
+// see FakeXPLM.h, so the plugin can be run end to end on any machine.
+// a simple model of an aircraft descends to the runway, responds to the throttle down
+// and reverse thrust commands the plugin holds, and slows down on the ground. the
+// manager is enabled with its command on each approach as the user would, or on some
+// approaches only once all the wheels are down as a user who forgot would. each approach
+// starts a little differently, from a fixed sequence so every run is the same, and each
+// landing is checked: idle throttle before touch down, reverse thrust soon after all the
+// wheels are down and only then, the reverse callout, and reverse thrust removed at
+// about 60 knots. enabling on the runway must give reverse thrust in the same frame
+// and keep the landing out of the landing statistics.
+// the approaches cycle through the reverse thrust settings, the low, medium and high
+// settings must slow the aircraft down at their target deceleration once settled.
+// a multiplayer aircraft in the first traffic slot flies the same approach, and the
+// manager must follow its landing with the same checks
+//
+// usage: FakeSim [number of approaches] [plugin folder]
+//   the plugin folder gets the plugin's log and recordings, default the current folder
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "XPLMDataAccess.h"
+#include "XPLMPlugin.h"
+#include "XPLMPlanes.h"
+#include "XPLMUtilities.h"
+#include "LandingLog.h"
+#include "StateMachine.h"
+#include "Traffic.h"
+#include "Voice.h"
+#include "FakeXPLM.h"
+
+// default number of approaches
+#define FAKESIM_DEFAULT_APPROACHES 100
+// frame time in seconds
+#define FAKESIM_FRAME_TIME (1.0f / 60.0f)
+// longest approach and rollout in seconds before it is failed
+#define FAKESIM_MAX_APPROACH_TIME 300.0f
+// meters per second in a knot
+#define FAKESIM_KNOTS_TO_MS 0.514444f
+// the plugin's enable command
+#define FAKESIM_ENABLE_COMMAND "Landing Throttle Manager//Enable"
+// menu item that turns on following the multiplayer traffic
+#define FAKESIM_TRAFFIC_MENU_ITEM "Follow multiplayer traffic"
+// the traffic slot the multiplayer aircraft is in and its mode S id
+#define FAKESIM_TRAFFIC_SLOT 1
+#define FAKESIM_TRAFFIC_MODE_S 0xA1B2C3
+// aircraft the approaches are flown in and the profile the plugin uses for it
+#define FAKESIM_AIRCRAFT_DESCRIPTION "X-Crafts ERJ-175 Embraer E175 Regional Jet"
+#define FAKESIM_PROFILE_NAME "X-Crafts ERJ Family"
+// latest reverse thrust is allowed after all the wheels are down, in seconds
+#define FAKESIM_MAX_REVERSE_DELAY 0.5f
+// every this many approaches the manager is only enabled once all the wheels are down
+#define FAKESIM_ENABLE_ON_RUNWAY_EVERY 4
+// latest reverse thrust is allowed after enabling on the runway, in seconds, the wheels
+// are taken to be down from the first reading so it comes in the frame that is enabled
+#define FAKESIM_MAX_RUNWAY_ENABLE_DELAY (0.5f * FAKESIM_FRAME_TIME)
+// time after reverse thrust begins for a modulated reverse to settle, in seconds
+#define FAKESIM_REVERSE_SETTLE_TIME 3.0f
+// largest difference from the target deceleration of a settled modulated reverse, in
+// meters per second squared
+#define FAKESIM_MAX_DECELERATION_ERROR 0.15f
+// airspeeds reverse thrust must be removed between, in knots
+#define FAKESIM_MIN_REVERSE_END_AIRSPEED 50.0f
+#define FAKESIM_MAX_REVERSE_END_AIRSPEED 62.0f
+
+// datarefs and commands of the aircraft, the defaults in the profiles
+#define DATAREF_THROTTLE_RATIO_ALL   "sim/cockpit2/engine/actuators/throttle_ratio_all"
+#define DATAREF_THROTTLE_RATIO       "sim/cockpit2/engine/actuators/throttle_ratio"
+#define DATAREF_NUM_ENGINES          "sim/aircraft/engine/acf_num_engines"
+#define DATAREF_INDICATED_AIRSPEED   "sim/flightmodel/position/indicated_airspeed2"
+#define DATAREF_GROUND_SPEED         "sim/flightmodel/position/groundspeed"
+#define DATAREF_REVERSER_MODE        "sim/cockpit2/engine/actuators/prop_mode"
+#define DATAREF_ON_GROUND            "sim/flightmodel2/gear/on_ground"
+#define DATAREF_FLAP_ANGLE           "sim/flightmodel2/wing/flap1_deg"
+#define DATAREF_GEAR_DEPLOY_RATIO    "sim/flightmodel2/gear/deploy_ratio"
+#define DATAREF_ALTITUDE             "sim/flightmodel2/position/y_agl"
+#define DATAREF_DESCRIPTION          "sim/aircraft/view/acf_descrip"
+#define DATAREF_MANAGER_STATE        "landingthrottlemanager/state"
+#define DATAREF_TCAS_NUM_AIRCRAFT    "sim/cockpit2/tcas/indicators/tcas_num_acf"
+#define DATAREF_TCAS_MODE_S          "sim/cockpit2/tcas/targets/modeS_id"
+#define DATAREF_TCAS_Y               "sim/cockpit2/tcas/targets/position/y"
+#define DATAREF_TCAS_VY              "sim/cockpit2/tcas/targets/position/vy"
+#define DATAREF_TCAS_VZ              "sim/cockpit2/tcas/targets/position/vz"
+#define DATAREF_TCAS_GEAR_DEPLOY     "sim/cockpit2/tcas/targets/position/gear_deploy"
+#define DATAREF_TCAS_FLAP_RATIO      "sim/cockpit2/tcas/targets/position/flap_ratio"
+#define DATAREF_TCAS_THROTTLE        "sim/cockpit2/tcas/targets/position/throttle"
+#define DATAREF_TCAS_ON_GROUND       "sim/cockpit2/tcas/targets/position/weight_on_wheels"
+#define DATAREF_TRAFFIC_STATE        "landingthrottlemanager/traffic/state"
+#define DATAREF_TRAFFIC_COMMANDS     "landingthrottlemanager/traffic/commands"
+#define SIM_COMMAND_THROTTLE_DOWN    "sim/engines/throttle_down"
+#define SIM_COMMAND_REVERSE_THRUST   "sim/engines/thrust_reverse_hold"
+
+// the aircraft model
+#define FLAP_ANGLE 22.0f
+#define NUM_ENGINES 2
+#define NUM_GEARS 3
+#define NOSE_GEAR 0
+// throttle movement per second while throttle down is held
+#define THROTTLE_DOWN_RATE 1.5f
+// time from the main gear to the nose gear touching down in seconds
+#define NOSE_GEAR_DELAY 1.0f
+// decelerations in meters per second squared, the reverse is at full throttle and
+// the user only brakes when full reverse is used
+#define AIRBORNE_DECELERATION 0.4f
+#define ROLLING_DECELERATION 0.8f
+#define BRAKING_DECELERATION 1.0f
+#define REVERSE_DECELERATION 2.5f
+// reverser mode of an engine with the reversers deployed
+#define REVERSER_MODE_REVERSE 3
+
+// one approach
+typedef struct _approach_t
+{
+  float Altitude;         // meters above ground
+  float VerticalSpeed;    // meters per second, negative when descending
+  float Speed;            // meters per second
+  float Throttle;         // 0 = idle, 1 = full
+} approach_t;
+
+// what happened on one approach, times are sim times in seconds
+typedef struct _landing_t
+{
+  float EnableTime;
+  float MainsDownTime;
+  float AllWheelsDownTime;
+  float ReverseBeginTime;
+  float ReverseCalloutTime;
+  float ReverseEndAirspeed;   // knots
+  float ThrottleAtTouchdown;
+  bool  ReverseAirborne;      // reverse thrust was held before touch down
+  bool  EnabledOnRunway;      // the manager was enabled once all the wheels were down
+  reverse_target_t ReverseTarget;
+  float SettledTime;          // when the modulated reverse should have settled
+  float SettledSpeed;         // meters per second
+  float ReverseEndTime;
+  float ReverseEndSpeed;      // meters per second
+  float ThrottleAfterReverse;
+  bool  TrafficEnabled;       // the traffic was followed before touch down
+  bool  TrafficReverseAirborne;
+  float TrafficReverseBeginTime;
+  float TrafficReverseEndAirspeed;
+  bool  Finished;             // the manager has stopped after touching down
+} landing_t;
+
+// the plugin's reverse thrust menu items, indexed by reverse_target_t
+static const char *ReverseTargetItems[] =
+{
+  "Full",
+  "Low",
+  "Medium",
+  "High"
+};
+// target decelerations in meters per second squared, indexed by reverse_target_t
+static const float ReverseTargetDecelerations[] =
+{
+  0,
+  REVERSE_TARGET_LO_DECELERATION,
+  REVERSE_TARGET_MED_DECELERATION,
+  REVERSE_TARGET_HI_DECELERATION
+};
+
+// state of the fixed sequence the approaches are varied by
+static unsigned int Sequence = 12345;
+// the datarefs and commands, looked up once
+static XPLMDataRef ThrottleRatioAllRef = NULL;
+static XPLMDataRef ThrottleRatioRef = NULL;
+static XPLMDataRef IndicatedAirspeedRef = NULL;
+static XPLMDataRef GroundSpeedRef = NULL;
+static XPLMDataRef ReverserModeRef = NULL;
+static XPLMDataRef OnGroundRef = NULL;
+static XPLMDataRef AltitudeRef = NULL;
+static XPLMDataRef ManagerStateRef = NULL;
+static XPLMDataRef TcasYRef = NULL;
+static XPLMDataRef TcasVYRef = NULL;
+static XPLMDataRef TcasVZRef = NULL;
+static XPLMDataRef TcasThrottleRef = NULL;
+static XPLMDataRef TcasOnGroundRef = NULL;
+static XPLMDataRef TrafficStateRef = NULL;
+static XPLMDataRef TrafficCommandsRef = NULL;
+static XPLMCommandRef ThrottleDownCmd = NULL;
+static XPLMCommandRef ReverseThrustCmd = NULL;
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// INTERNAL FUNCTIONS
+
+// returns the next number from the sequence between Min and Max
+static float Vary
+  (
+  float Min,
+  float Max
+  )
+{
+  Sequence = (Sequence * 1103515245u) + 12345u;
+  return Min + ((Max - Min) * (float)((Sequence >> 8) & 0xFFFF) / 65535.0f);
+}
+
+// writes the state of the aircraft into the sim datarefs
+static void WriteAircraft
+  (
+  const approach_t *Aircraft,
+  bool MainsDown,
+  bool NoseDown
+  )
+{
+  float Throttles[NUM_ENGINES];
+  for (int e = 0; e < NUM_ENGINES; e++) Throttles[e] = Aircraft->Throttle;
+  XPLMSetDatavf(ThrottleRatioRef, Throttles, 0, NUM_ENGINES);
+  XPLMSetDataf(ThrottleRatioAllRef, Aircraft->Throttle);
+  XPLMSetDataf(AltitudeRef, Aircraft->Altitude);
+  XPLMSetDataf(GroundSpeedRef, Aircraft->Speed);
+  XPLMSetDataf(IndicatedAirspeedRef, Aircraft->Speed / FAKESIM_KNOTS_TO_MS);
+
+  int OnGround[NUM_GEARS];
+  for (int g = 0; g < NUM_GEARS; g++) OnGround[g] = ((g == NOSE_GEAR) ? NoseDown : MainsDown) ? 1 : 0;
+  XPLMSetDatavi(OnGroundRef, OnGround, 0, NUM_GEARS);
+
+  // the multiplayer aircraft is in the same place, flying towards -z
+  float Altitude = Aircraft->Altitude;
+  float VerticalSpeed = MainsDown ? 0 : Aircraft->VerticalSpeed;
+  float Speed = -Aircraft->Speed;
+  float Throttle = Aircraft->Throttle;
+  int WeightOnWheels = MainsDown ? 1 : 0;
+  XPLMSetDatavf(TcasYRef, &Altitude, FAKESIM_TRAFFIC_SLOT, 1);
+  XPLMSetDatavf(TcasVYRef, &VerticalSpeed, FAKESIM_TRAFFIC_SLOT, 1);
+  XPLMSetDatavf(TcasVZRef, &Speed, FAKESIM_TRAFFIC_SLOT, 1);
+  XPLMSetDatavf(TcasThrottleRef, &Throttle, FAKESIM_TRAFFIC_SLOT, 1);
+  XPLMSetDatavi(TcasOnGroundRef, &WeightOnWheels, FAKESIM_TRAFFIC_SLOT, 1);
+}
+
+// reads a published value of the multiplayer aircraft
+static int ReadTraffic
+  (
+  XPLMDataRef Ref
+  )
+{
+  int Value = 0;
+  XPLMGetDatavi(Ref, &Value, FAKESIM_TRAFFIC_SLOT, 1);
+  return Value;
+}
+
+// runs the enable command as the user would
+// returns false if the manager couldn't be enabled
+static bool Enable
+  (
+  void
+  )
+{
+  FakeXPLM_RunCommand(FAKESIM_ENABLE_COMMAND);
+  if (XPLMGetDatai(ManagerStateRef) == 0)
+  {
+    // the reason is said on the next frame
+    FakeXPLM_RunFrame(FAKESIM_FRAME_TIME);
+    return false;
+  }
+  return true;
+}
+
+// flies one approach and rollout until the manager stops or it takes too long
+// the manager is enabled at the start or, if EnableOnRunway, once all the wheels are down
+// returns false if the manager couldn't be enabled
+static bool FlyApproach
+  (
+  landing_t *Landing,
+  bool EnableOnRunway,
+  reverse_target_t ReverseTarget
+  )
+{
+  approach_t Aircraft;
+  Aircraft.Altitude      = Vary(60.0f, 140.0f);
+  Aircraft.VerticalSpeed = Vary(-4.0f, -2.5f);
+  Aircraft.Speed         = Vary(125.0f, 150.0f) * FAKESIM_KNOTS_TO_MS;
+  Aircraft.Throttle      = Vary(0.2f, 0.7f);
+  // without the manager the user brings the throttle to idle
+  if (EnableOnRunway) Aircraft.Throttle = 0;
+
+  memset(Landing, 0, sizeof(landing_t));
+  Landing->MainsDownTime     = -1;
+  Landing->AllWheelsDownTime = -1;
+  Landing->ReverseBeginTime  = -1;
+  Landing->ReverseCalloutTime = -1;
+  Landing->EnableTime = -1;
+  Landing->EnabledOnRunway = EnableOnRunway;
+  Landing->ReverseTarget = ReverseTarget;
+  Landing->SettledTime = -1;
+  Landing->ReverseEndTime = -1;
+  Landing->TrafficReverseBeginTime = -1;
+
+  WriteAircraft(&Aircraft, false, false);
+  FakeXPLM_RunFrame(FAKESIM_FRAME_TIME);
+
+  if (!EnableOnRunway)
+  {
+    if (!Enable()) return false;
+    Landing->EnableTime = FakeXPLM_GetSimTime();
+  }
+
+  float StartTime = FakeXPLM_GetSimTime();
+  bool Reverse = false;
+  bool ReverseHeld = false;
+  bool ReversersDeployed = false;
+  bool TrafficReverse = false;
+  int SpokenCount = FakeXPLM_GetSpokenCount();
+  while (FakeXPLM_GetSimTime() - StartTime < FAKESIM_MAX_APPROACH_TIME)
+  {
+    // the sim time of the frame about to run, which is when the plugin sees the new state
+    float Now = FakeXPLM_GetSimTime() + FAKESIM_FRAME_TIME;
+
+    if (FakeXPLM_IsCommandHeld(ThrottleDownCmd))
+    {
+      Aircraft.Throttle -= THROTTLE_DOWN_RATE * FAKESIM_FRAME_TIME;
+      if (Aircraft.Throttle < 0) Aircraft.Throttle = 0;
+    }
+    else
+    {
+      // the plugin may have moved the engine throttles itself
+      XPLMGetDatavf(ThrottleRatioRef, &Aircraft.Throttle, 0, 1);
+    }
+
+    float Deceleration;
+    if (Landing->MainsDownTime < 0)
+    {
+      Aircraft.Altitude += Aircraft.VerticalSpeed * FAKESIM_FRAME_TIME;
+      if (Aircraft.Altitude <= 0)
+      {
+        Aircraft.Altitude = 0;
+        Landing->MainsDownTime = Now;
+        Landing->ThrottleAtTouchdown = Aircraft.Throttle;
+      }
+      Deceleration = AIRBORNE_DECELERATION;
+    }
+    else
+    {
+      if ((Landing->AllWheelsDownTime < 0) && (Now - Landing->MainsDownTime >= NOSE_GEAR_DELAY)) Landing->AllWheelsDownTime = Now;
+      // like x-plane the reverse command holds full reverse whatever the throttles are set
+      // to, with the reversers deployed the throttles set the reverse power
+      float ReverseRatio = 0;
+      if (ReverseHeld) ReverseRatio = 1; else if (ReversersDeployed) ReverseRatio = Aircraft.Throttle;
+      bool Braking = (Landing->AllWheelsDownTime >= 0) && (ReverseTarget == REVERSE_TARGET_FULL);
+      Deceleration = ROLLING_DECELERATION + (Braking ? BRAKING_DECELERATION : 0) + (ReverseRatio * REVERSE_DECELERATION);
+    }
+
+    Aircraft.Speed -= Deceleration * FAKESIM_FRAME_TIME;
+    if (Aircraft.Speed < 0) Aircraft.Speed = 0;
+
+    WriteAircraft(&Aircraft, Landing->MainsDownTime >= 0, Landing->AllWheelsDownTime >= 0);
+    if ((Landing->EnableTime < 0) && (Landing->AllWheelsDownTime >= 0))
+    {
+      if (!Enable()) return false;
+      Landing->EnableTime = Now;
+    }
+    FakeXPLM_RunFrame(FAKESIM_FRAME_TIME);
+
+    // see what the plugin did in the frame
+    bool WasReverse = Reverse;
+    int ReverserMode = 0;
+    XPLMGetDatavi(ReverserModeRef, &ReverserMode, 0, 1);
+    ReverseHeld = FakeXPLM_IsCommandHeld(ReverseThrustCmd);
+    ReversersDeployed = ReverserMode == REVERSER_MODE_REVERSE;
+    Reverse = ReverseHeld || ReversersDeployed;
+    if (Reverse && (Landing->MainsDownTime < 0)) Landing->ReverseAirborne = true;
+    if (Reverse && !WasReverse && (Landing->ReverseBeginTime < 0)) Landing->ReverseBeginTime = Now;
+    if (Reverse && (Landing->SettledTime < 0) && (Now - Landing->ReverseBeginTime >= FAKESIM_REVERSE_SETTLE_TIME))
+    {
+      Landing->SettledTime  = Now;
+      Landing->SettledSpeed = Aircraft.Speed;
+    }
+    if (!Reverse && WasReverse)
+    {
+      Landing->ReverseEndAirspeed = Aircraft.Speed / FAKESIM_KNOTS_TO_MS;
+      Landing->ReverseEndTime     = Now;
+      Landing->ReverseEndSpeed    = Aircraft.Speed;
+      XPLMGetDatavf(ThrottleRatioRef, &Landing->ThrottleAfterReverse, 0, 1);
+    }
+    if ((FakeXPLM_GetSpokenCount() != SpokenCount) && (strcmp(FakeXPLM_GetLastSpoken(), REVERSE_CALLOUT) == 0) && (Landing->ReverseCalloutTime < 0))
+    {
+      Landing->ReverseCalloutTime = Now;
+    }
+    SpokenCount = FakeXPLM_GetSpokenCount();
+
+    // the same for the multiplayer aircraft from what the manager publishes
+    int TrafficState = ReadTraffic(TrafficStateRef);
+    bool WasTrafficReverse = TrafficReverse;
+    TrafficReverse = (ReadTraffic(TrafficCommandsRef) & COMMAND_REVERSE_THRUST) != 0;
+    if ((TrafficState > WAIT_FOR_USER) && (Landing->MainsDownTime < 0)) Landing->TrafficEnabled = true;
+    if (TrafficReverse && (Landing->MainsDownTime < 0)) Landing->TrafficReverseAirborne = true;
+    if (TrafficReverse && !WasTrafficReverse && (Landing->TrafficReverseBeginTime < 0)) Landing->TrafficReverseBeginTime = Now;
+    if (!TrafficReverse && WasTrafficReverse) Landing->TrafficReverseEndAirspeed = Aircraft.Speed / FAKESIM_KNOTS_TO_MS;
+
+    if ((Landing->EnableTime >= 0) && (Landing->MainsDownTime >= 0) && (XPLMGetDatai(ManagerStateRef) == 0) && (TrafficState <= WAIT_FOR_USER))
+    {
+      Landing->Finished = true;
+      break;
+    }
+  }
+
+  return true;
+}
+
+// returns the deceleration from when a modulated reverse settled to the end of reverse
+// thrust, in meters per second squared
+static float GetSettledDeceleration
+  (
+  const landing_t *Landing
+  )
+{
+  return (Landing->SettledSpeed - Landing->ReverseEndSpeed) / (Landing->ReverseEndTime - Landing->SettledTime);
+}
+
+// checks a landing
+// returns a description of what is wrong or NULL if nothing is
+static const char *CheckLanding
+  (
+  const landing_t *Landing
+  )
+{
+  if (!Landing->Finished)                    return "the manager didn't finish";
+  if (Landing->ThrottleAtTouchdown > 0)      return "the throttle wasn't at idle at touch down";
+  if (Landing->ReverseAirborne)              return "reverse thrust was used in the air";
+  if (Landing->ReverseBeginTime < 0)         return "reverse thrust wasn't used";
+
+  float Delay = Landing->ReverseBeginTime - Landing->AllWheelsDownTime;
+  if (Delay < 0)                             return "reverse thrust was used before all the wheels were down";
+  if (Delay > FAKESIM_MAX_REVERSE_DELAY)     return "reverse thrust was late";
+  if (Landing->EnabledOnRunway && (Landing->ReverseBeginTime - Landing->EnableTime > FAKESIM_MAX_RUNWAY_ENABLE_DELAY))
+  {
+    return "reverse thrust was late after enabling on the runway";
+  }
+
+  float CalloutDelay = Landing->ReverseCalloutTime - Landing->ReverseBeginTime;
+  if ((Landing->ReverseCalloutTime < 0) || (CalloutDelay < 0) || (CalloutDelay > VOICE_SAFETY_MAX_AGE))
+  {
+    return "reverse thrust wasn't called out";
+  }
+
+  if ((Landing->ReverseEndAirspeed < FAKESIM_MIN_REVERSE_END_AIRSPEED) || (Landing->ReverseEndAirspeed > FAKESIM_MAX_REVERSE_END_AIRSPEED))
+  {
+    return "reverse thrust wasn't removed at about 60 knots";
+  }
+
+  // the deceleration of a modulated reverse from when it has settled to the end
+  if (Landing->ReverseTarget != REVERSE_TARGET_FULL)
+  {
+    if ((Landing->SettledTime < 0) || (Landing->ReverseEndTime <= Landing->SettledTime)) return "the modulated reverse thrust didn't last long enough to settle";
+    float Error = GetSettledDeceleration(Landing) - ReverseTargetDecelerations[Landing->ReverseTarget];
+    if ((Error < -FAKESIM_MAX_DECELERATION_ERROR) || (Error > FAKESIM_MAX_DECELERATION_ERROR))
+    {
+      return "the modulated reverse thrust didn't slow down at the target deceleration";
+    }
+    if (Landing->ThrottleAfterReverse > 0)   return "the throttles weren't left at idle after the modulated reverse thrust";
+  }
+
+  // the multiplayer aircraft has all its wheels down with the mains
+  if (!Landing->TrafficEnabled)              return "the traffic wasn't followed";
+  if (Landing->TrafficReverseAirborne)       return "the traffic was given reverse thrust in the air";
+  if (Landing->TrafficReverseBeginTime < 0)  return "the traffic wasn't given reverse thrust";
+
+  float TrafficDelay = Landing->TrafficReverseBeginTime - Landing->MainsDownTime;
+  if ((TrafficDelay < 0) || (TrafficDelay > FAKESIM_MAX_REVERSE_DELAY)) return "the traffic was given reverse thrust late";
+  if ((Landing->TrafficReverseEndAirspeed < FAKESIM_MIN_REVERSE_END_AIRSPEED) || (Landing->TrafficReverseEndAirspeed > FAKESIM_MAX_REVERSE_END_AIRSPEED))
+  {
+    return "the traffic's reverse thrust wasn't removed at about 60 knots";
+  }
+
+  return NULL;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ENTRY POINT
+
+int main
+  (
+  int argc,
+  char *argv[]
+  )
+{
+  int NumApproaches = (argc >= 2) ? atoi(argv[1]) : FAKESIM_DEFAULT_APPROACHES;
+  char PluginFolder[256];
+  snprintf(PluginFolder, sizeof(PluginFolder), "%s%s", (argc >= 3) ? argv[2] : ".", XPLMGetDirectorySeparator());
+  if (NumApproaches < 1)
+  {
+    fprintf(stderr, "usage: %s [number of approaches] [plugin folder]\n", argv[0]);
+    return 1;
+  }
+
+  FakeXPLM_Reset(PluginFolder);
+  ThrottleRatioAllRef  = XPLMFindDataRef(DATAREF_THROTTLE_RATIO_ALL);
+  ThrottleRatioRef     = XPLMFindDataRef(DATAREF_THROTTLE_RATIO);
+  IndicatedAirspeedRef = XPLMFindDataRef(DATAREF_INDICATED_AIRSPEED);
+  GroundSpeedRef       = XPLMFindDataRef(DATAREF_GROUND_SPEED);
+  ReverserModeRef      = XPLMFindDataRef(DATAREF_REVERSER_MODE);
+  OnGroundRef          = XPLMFindDataRef(DATAREF_ON_GROUND);
+  AltitudeRef          = XPLMFindDataRef(DATAREF_ALTITUDE);
+  ThrottleDownCmd      = XPLMFindCommand(SIM_COMMAND_THROTTLE_DOWN);
+  ReverseThrustCmd     = XPLMFindCommand(SIM_COMMAND_REVERSE_THRUST);
+  TcasYRef             = XPLMFindDataRef(DATAREF_TCAS_Y);
+  TcasVYRef            = XPLMFindDataRef(DATAREF_TCAS_VY);
+  TcasVZRef            = XPLMFindDataRef(DATAREF_TCAS_VZ);
+  TcasThrottleRef      = XPLMFindDataRef(DATAREF_TCAS_THROTTLE);
+  TcasOnGroundRef      = XPLMFindDataRef(DATAREF_TCAS_ON_GROUND);
+
+  char Description[FAKE_XPLM_MAX_BYTES];
+  memset(Description, 0, sizeof(Description));
+  snprintf(Description, sizeof(Description), "%s", FAKESIM_AIRCRAFT_DESCRIPTION);
+  XPLMSetDatab(XPLMFindDataRef(DATAREF_DESCRIPTION), Description, 0, sizeof(Description));
+  XPLMSetDatai(XPLMFindDataRef(DATAREF_NUM_ENGINES), NUM_ENGINES);
+  XPLMSetDataf(XPLMFindDataRef(DATAREF_FLAP_ANGLE), FLAP_ANGLE);
+  XPLMSetDataf(XPLMFindDataRef(DATAREF_GEAR_DEPLOY_RATIO), 1.0f);
+
+  // the user aircraft and the multiplayer aircraft in the traffic slots
+  float FlapRatio = FLAP_ANGLE / TRAFFIC_FULL_FLAP_ANGLE;
+  float GearDeploy = 1.0f;
+  int ModeS = FAKESIM_TRAFFIC_MODE_S;
+  XPLMSetDatai(XPLMFindDataRef(DATAREF_TCAS_NUM_AIRCRAFT), FAKESIM_TRAFFIC_SLOT + 1);
+  XPLMSetDatavi(XPLMFindDataRef(DATAREF_TCAS_MODE_S), &ModeS, FAKESIM_TRAFFIC_SLOT, 1);
+  XPLMSetDatavf(XPLMFindDataRef(DATAREF_TCAS_FLAP_RATIO), &FlapRatio, FAKESIM_TRAFFIC_SLOT, 1);
+  XPLMSetDatavf(XPLMFindDataRef(DATAREF_TCAS_GEAR_DEPLOY), &GearDeploy, FAKESIM_TRAFFIC_SLOT, 1);
+
+  if (!FakeXPLM_StartPlugin())
+  {
+    fprintf(stderr, "The plugin failed to start\n");
+    return 1;
+  }
+  // the plugin publishes its state once started
+  ManagerStateRef    = XPLMFindDataRef(DATAREF_MANAGER_STATE);
+  TrafficStateRef    = XPLMFindDataRef(DATAREF_TRAFFIC_STATE);
+  TrafficCommandsRef = XPLMFindDataRef(DATAREF_TRAFFIC_COMMANDS);
+  if (!FakeXPLM_ChooseMenuItem(FAKESIM_TRAFFIC_MENU_ITEM))
+  {
+    fprintf(stderr, "The plugin has no menu item to follow the traffic\n");
+    return 1;
+  }
+  FakeXPLM_SendMessage(XPLM_MSG_PLANE_LOADED, (void *)(intptr_t)XPLM_USER_AIRCRAFT);
+
+  int Failures = 0;
+  double TotalDelay = 0;
+  float MaxDelay = 0;
+  double TotalDeceleration[REVERSE_NUM_TARGETS];
+  int NumDecelerations[REVERSE_NUM_TARGETS];
+  memset(TotalDeceleration, 0, sizeof(TotalDeceleration));
+  memset(NumDecelerations, 0, sizeof(NumDecelerations));
+  std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+
+  for (int a = 0; a < NumApproaches; a++)
+  {
+    // each setting is flown for a set of approaches that includes enabling on the runway
+    reverse_target_t ReverseTarget = (reverse_target_t)((a / FAKESIM_ENABLE_ON_RUNWAY_EVERY) % REVERSE_NUM_TARGETS);
+    if (!FakeXPLM_ChooseMenuItem(ReverseTargetItems[ReverseTarget]))
+    {
+      fprintf(stderr, "The plugin has no menu item for %s reverse thrust\n", ReverseTargetItems[ReverseTarget]);
+      return 1;
+    }
+
+    landing_t Landing;
+    if (!FlyApproach(&Landing, (a % FAKESIM_ENABLE_ON_RUNWAY_EVERY) == (FAKESIM_ENABLE_ON_RUNWAY_EVERY - 1), ReverseTarget))
+    {
+      printf("Approach %d: the manager couldn't be enabled, %s\n", a + 1, FakeXPLM_GetLastSpoken());
+      Failures++;
+      continue;
+    }
+
+    const char *Problem = CheckLanding(&Landing);
+    if (Problem != NULL)
+    {
+      printf("Approach %d: %s\n", a + 1, Problem);
+      Failures++;
+      continue;
+    }
+
+    float Delay = Landing.ReverseBeginTime - Landing.AllWheelsDownTime;
+    TotalDelay += Delay;
+    if (Delay > MaxDelay) MaxDelay = Delay;
+    if (ReverseTarget != REVERSE_TARGET_FULL)
+    {
+      TotalDeceleration[ReverseTarget] += GetSettledDeceleration(&Landing);
+      NumDecelerations[ReverseTarget]++;
+    }
+  }
+
+  double Elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+
+  // a landing enabled on the runway has no touch down to measure, so every vertical speed
+  // in the landing statistics is a descent
+  landing_stats_t VerticalSpeed;
+  if (!LandingLog_GetStats(FAKESIM_PROFILE_NAME, LANDING_METRIC_TOUCHDOWN_VERTICAL_SPEED, &VerticalSpeed) || (VerticalSpeed.P95 >= 0))
+  {
+    printf("The landing statistics have touch downs that weren't descending\n");
+    Failures++;
+  }
+  FakeXPLM_StopPlugin();
+
+  printf("%d approaches in %.1f ms, %.0f approaches per second\n", NumApproaches, Elapsed * 1000.0, NumApproaches / Elapsed);
+  if (Failures < NumApproaches)
+  {
+    printf("reverse thrust after all wheels down: mean %.3f s, max %.3f s\n", TotalDelay / (NumApproaches - Failures), MaxDelay);
+  }
+  for (int t = REVERSE_TARGET_LO; t < REVERSE_NUM_TARGETS; t++)
+  {
+    if (NumDecelerations[t] == 0) continue;
+    printf("%s reverse thrust: mean settled deceleration %.2f m/s/s, target %.2f m/s/s\n", ReverseTargetItems[t], TotalDeceleration[t] / NumDecelerations[t], ReverseTargetDecelerations[t]);
+  }
+  printf("%d failed\n", Failures);
+
+  return (Failures == 0) ? 0 : 1;
+}
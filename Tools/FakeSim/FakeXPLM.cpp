@@ -0,0 +1,1013 @@
+// Landing Throttle Manager - FakeSim
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Fake X-Plane, see FakeXPLM.h
+
+#include <stdio.h>
+#include <string.h>
+#include "XPLMDataAccess.h"
+#include "XPLMMenus.h"
+#include "XPLMPlugin.h"
+#include "XPLMProcessing.h"
+#include "XPLMScenery.h"
+#include "XPLMUtilities.h"
+#include "FakeXPLM.h"
+
+// the id the plugin gets
+#define FAKE_XPLM_PLUGIN_ID 1
+// number of plugins that can share one dataref
+#define FAKE_XPLM_MAX_SHARERS 4
+// number of handlers one command can have
+#define FAKE_XPLM_MAX_HANDLERS 4
+
+// where the value of a dataref comes from
+typedef enum _dataref_kind_t
+{
+  DATAREF_KIND_SIM,         // stored here, written by the program
+  DATAREF_KIND_ACCESSOR,    // read and written through the plugin's callbacks
+  DATAREF_KIND_SHARED       // stored here, the sharers are told when it is written
+} dataref_kind_t;
+
+// one dataref
+typedef struct _fake_dataref_t
+{
+  bool              InUse;
+  char              Name[FAKE_XPLM_NAME_SIZE];
+  dataref_kind_t    Kind;
+  float             Floats[FAKE_XPLM_MAX_VALUES];   // the float and int values are kept in step
+  int               Ints[FAKE_XPLM_MAX_VALUES];
+  char              Bytes[FAKE_XPLM_MAX_BYTES];
+  XPLMGetDatai_f    ReadInt;
+  XPLMSetDatai_f    WriteInt;
+  XPLMGetDataf_f    ReadFloat;
+  XPLMSetDataf_f    WriteFloat;
+  XPLMGetDatavi_f   ReadIntArray;
+  XPLMGetDatavf_f   ReadFloatArray;
+  void             *ReadRefcon;
+  void             *WriteRefcon;
+  int               NumSharers;
+  XPLMDataChanged_f Notify[FAKE_XPLM_MAX_SHARERS];
+  void             *NotifyRefcon[FAKE_XPLM_MAX_SHARERS];
+} fake_dataref_t;
+
+// one command
+typedef struct _fake_command_t
+{
+  bool                  InUse;
+  char                  Name[FAKE_XPLM_NAME_SIZE];
+  bool                  Held;
+  int                   Count;
+  int                   NumHandlers;
+  XPLMCommandCallback_f Handlers[FAKE_XPLM_MAX_HANDLERS];
+  void                 *Refcons[FAKE_XPLM_MAX_HANDLERS];
+} fake_command_t;
+
+// one flight loop
+typedef struct _fake_flight_loop_t
+{
+  bool             InUse;
+  XPLMFlightLoop_f Callback;
+  void            *Refcon;
+  bool             Scheduled;
+  bool             InFrames;          // FramesLeft is used rather than DueTime
+  float            DueTime;           // sim time of the next call
+  int              FramesLeft;        // frames to the next call
+  int              ScheduledFrame;    // frame it was scheduled in, it isn't counted down until the next one
+  float            LastCallTime;
+  int              Counter;
+} fake_flight_loop_t;
+
+// one menu, menu 0 is the plugins menu
+typedef struct _fake_menu_t
+{
+  bool              InUse;
+  XPLMMenuHandler_f Handler;
+  void             *MenuRef;
+  int               NumItems;
+  char              ItemNames[FAKE_XPLM_MAX_MENU_ITEMS][FAKE_XPLM_NAME_SIZE];
+  void             *ItemRefs[FAKE_XPLM_MAX_MENU_ITEMS];
+  XPLMMenuCheck     Checks[FAKE_XPLM_MAX_MENU_ITEMS];
+} fake_menu_t;
+
+static fake_dataref_t Datarefs[FAKE_XPLM_MAX_DATAREFS];
+static fake_command_t Commands[FAKE_XPLM_MAX_COMMANDS];
+static fake_flight_loop_t FlightLoops[FAKE_XPLM_MAX_FLIGHT_LOOPS];
+static fake_menu_t Menus[FAKE_XPLM_MAX_MENUS];
+// the time and the number of frames run
+static float SimTime = 0;
+static int Frame = 0;
+static fake_dataref_t *SimTimeRef = NULL;
+// path of the plugin file
+static char PluginPath[256];
+// the speech
+static int SpokenCount = 0;
+static char LastSpoken[256];
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// INTERNAL FUNCTIONS
+
+// checks if a name belongs to the sim rather than to a plugin
+static bool IsSimName
+  (
+  const char *Name
+  )
+{
+  return strncmp(Name, "sim/", 4) == 0;
+}
+
+// finds a dataref by name, optionally adding a sim dataref if it isn't there
+// returns NULL if not found or the table is full
+static fake_dataref_t *FindDataref
+  (
+  const char *Name,
+  bool Add
+  )
+{
+  for (int d = 0; d < FAKE_XPLM_MAX_DATAREFS; d++)
+  {
+    if (Datarefs[d].InUse && (strcmp(Datarefs[d].Name, Name) == 0)) return &Datarefs[d];
+  }
+
+  if (!Add) return NULL;
+
+  for (int d = 0; d < FAKE_XPLM_MAX_DATAREFS; d++)
+  {
+    if (Datarefs[d].InUse || (Datarefs[d].Name[0] != '\0')) continue;
+
+    fake_dataref_t *Dataref = &Datarefs[d];
+    memset(Dataref, 0, sizeof(fake_dataref_t));
+    Dataref->InUse = true;
+    Dataref->Kind  = DATAREF_KIND_SIM;
+    snprintf(Dataref->Name, FAKE_XPLM_NAME_SIZE, "%s", Name);
+    return Dataref;
+  }
+
+  fprintf(stderr, "FakeXPLM: no room for dataref %s\n", Name);
+  return NULL;
+}
+
+// finds a command by name, optionally adding it if it isn't there
+// returns NULL if not found or the table is full
+static fake_command_t *FindCommand
+  (
+  const char *Name,
+  bool Add
+  )
+{
+  for (int c = 0; c < FAKE_XPLM_MAX_COMMANDS; c++)
+  {
+    if (Commands[c].InUse && (strcmp(Commands[c].Name, Name) == 0)) return &Commands[c];
+  }
+
+  if (!Add) return NULL;
+
+  for (int c = 0; c < FAKE_XPLM_MAX_COMMANDS; c++)
+  {
+    if (Commands[c].InUse) continue;
+
+    fake_command_t *Command = &Commands[c];
+    memset(Command, 0, sizeof(fake_command_t));
+    Command->InUse = true;
+    snprintf(Command->Name, FAKE_XPLM_NAME_SIZE, "%s", Name);
+    return Command;
+  }
+
+  fprintf(stderr, "FakeXPLM: no room for command %s\n", Name);
+  return NULL;
+}
+
+// runs the handlers of a command for a phase, stopping at one that returns 0
+static void RunHandlers
+  (
+  fake_command_t *Command,
+  XPLMCommandPhase Phase
+  )
+{
+  for (int h = 0; h < Command->NumHandlers; h++)
+  {
+    if (Command->Handlers[h]((XPLMCommandRef)Command, Phase, Command->Refcons[h]) == 0) break;
+  }
+}
+
+// tells the plugins sharing a dataref that it has been written
+static void NotifySharers
+  (
+  fake_dataref_t *Dataref
+  )
+{
+  if (Dataref->Kind != DATAREF_KIND_SHARED) return;
+
+  for (int s = 0; s < Dataref->NumSharers; s++)
+  {
+    if (Dataref->Notify[s] != NULL) Dataref->Notify[s](Dataref->NotifyRefcon[s]);
+  }
+}
+
+// works out when a flight loop is next called from an interval in the XPLM form,
+// seconds if positive, frames if negative and never if zero
+static void ScheduleFlightLoop
+  (
+  fake_flight_loop_t *Loop,
+  float Interval,
+  float From
+  )
+{
+  Loop->Scheduled      = (Interval != 0);
+  Loop->InFrames       = (Interval < 0);
+  Loop->DueTime        = From + Interval;
+  Loop->FramesLeft     = (int)-Interval;
+  Loop->ScheduledFrame = Frame;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// FAKE XPLM API
+
+// forgets everything and sets sim time to zero, PluginFolder is where the plugin is
+// installed, with a trailing directory separator. call before starting the plugin
+void FakeXPLM_Reset
+  (
+  const char *PluginFolder
+  )
+{
+  memset(Datarefs, 0, sizeof(Datarefs));
+  memset(Commands, 0, sizeof(Commands));
+  memset(FlightLoops, 0, sizeof(FlightLoops));
+  memset(Menus, 0, sizeof(Menus));
+  Menus[0].InUse = true;
+
+  SimTime = 0;
+  Frame = 0;
+  SimTimeRef = FindDataref(FAKE_XPLM_SIM_TIME_DATAREF, true);
+  SpokenCount = 0;
+  LastSpoken[0] = '\0';
+
+  // the plugin looks for its folder above the 64 folder
+  snprintf(PluginPath, sizeof(PluginPath), "%s64%sLandingThrottleManager.xpl", PluginFolder, XPLMGetDirectorySeparator());
+}
+
+// starts and enables the plugin
+// returns false if it failed to start
+bool FakeXPLM_StartPlugin
+  (
+  void
+  )
+{
+  char Name[256];
+  char Signature[256];
+  char Description[256];
+  if (!XPluginStart(Name, Signature, Description)) return false;
+
+  return XPluginEnable() != 0;
+}
+
+// disables and stops the plugin
+void FakeXPLM_StopPlugin
+  (
+  void
+  )
+{
+  XPluginDisable();
+  XPluginStop();
+}
+
+// sends a message to the plugin as X-Plane would, e.g. XPLM_MSG_PLANE_LOADED
+void FakeXPLM_SendMessage
+  (
+  int Message,
+  void *Param
+  )
+{
+  XPluginReceiveMessage(XPLM_NO_PLUGIN_ID, Message, Param);
+}
+
+// moves sim time on by FrameTime seconds and runs the flight loops that are due
+void FakeXPLM_RunFrame
+  (
+  float FrameTime
+  )
+{
+  Frame++;
+  SimTime += FrameTime;
+  SimTimeRef->Floats[0] = SimTime;
+  SimTimeRef->Ints[0] = (int)SimTime;
+
+  for (int l = 0; l < FAKE_XPLM_MAX_FLIGHT_LOOPS; l++)
+  {
+    fake_flight_loop_t *Loop = &FlightLoops[l];
+    if (!Loop->InUse || !Loop->Scheduled || (Loop->ScheduledFrame == Frame)) continue;
+
+    if (Loop->InFrames)
+    {
+      if (--Loop->FramesLeft > 0) continue;
+    }
+    else if (SimTime < Loop->DueTime)
+    {
+      continue;
+    }
+
+    float SinceLast = SimTime - Loop->LastCallTime;
+    Loop->LastCallTime = SimTime;
+    float Interval = Loop->Callback(SinceLast, FrameTime, ++Loop->Counter, Loop->Refcon);
+    if (Loop->InUse) ScheduleFlightLoop(Loop, Interval, SimTime);
+  }
+}
+
+// returns the sim time in seconds
+float FakeXPLM_GetSimTime
+  (
+  void
+  )
+{
+  return SimTime;
+}
+
+// returns true while a command is being held
+bool FakeXPLM_IsCommandHeld
+  (
+  XPLMCommandRef Command
+  )
+{
+  return (Command != NULL) && ((fake_command_t *)Command)->Held;
+}
+
+// returns the number of times a command has been started, by being held or issued once
+int FakeXPLM_GetCommandCount
+  (
+  XPLMCommandRef Command
+  )
+{
+  return (Command != NULL) ? ((fake_command_t *)Command)->Count : 0;
+}
+
+// issues a command once as if the user pressed a button bound to it
+// returns false if there is no such command
+bool FakeXPLM_RunCommand
+  (
+  const char *Name
+  )
+{
+  fake_command_t *Command = FindCommand(Name, false);
+  if (Command == NULL) return false;
+
+  XPLMCommandOnce((XPLMCommandRef)Command);
+  return true;
+}
+
+// chooses a menu item by its name as if the user clicked on it
+// returns false if there is no such item
+bool FakeXPLM_ChooseMenuItem
+  (
+  const char *Name
+  )
+{
+  for (int m = 0; m < FAKE_XPLM_MAX_MENUS; m++)
+  {
+    fake_menu_t *Menu = &Menus[m];
+    if (!Menu->InUse || (Menu->Handler == NULL)) continue;
+
+    for (int i = 0; i < Menu->NumItems; i++)
+    {
+      if (strcmp(Menu->ItemNames[i], Name) != 0) continue;
+      Menu->Handler(Menu->MenuRef, Menu->ItemRefs[i]);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// returns the number of times something has been spoken
+int FakeXPLM_GetSpokenCount
+  (
+  void
+  )
+{
+  return SpokenCount;
+}
+
+// returns the last thing spoken, empty if nothing has been
+const char *FakeXPLM_GetLastSpoken
+  (
+  void
+  )
+{
+  return LastSpoken;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// XPLM DATA ACCESS
+
+XPLMDataRef XPLMFindDataRef
+  (
+  const char *inDataRefName
+  )
+{
+  return (XPLMDataRef)FindDataref(inDataRefName, IsSimName(inDataRefName));
+}
+
+int XPLMIsDataRefGood
+  (
+  XPLMDataRef inDataRef
+  )
+{
+  return ((inDataRef != NULL) && ((fake_dataref_t *)inDataRef)->InUse) ? 1 : 0;
+}
+
+int XPLMGetDatai
+  (
+  XPLMDataRef inDataRef
+  )
+{
+  fake_dataref_t *Dataref = (fake_dataref_t *)inDataRef;
+  if ((Dataref == NULL) || !Dataref->InUse) return 0;
+
+  if (Dataref->Kind != DATAREF_KIND_ACCESSOR) return Dataref->Ints[0];
+  if (Dataref->ReadInt != NULL) return Dataref->ReadInt(Dataref->ReadRefcon);
+  if (Dataref->ReadFloat != NULL) return (int)Dataref->ReadFloat(Dataref->ReadRefcon);
+  return 0;
+}
+
+void XPLMSetDatai
+  (
+  XPLMDataRef inDataRef,
+  int inValue
+  )
+{
+  fake_dataref_t *Dataref = (fake_dataref_t *)inDataRef;
+  if ((Dataref == NULL) || !Dataref->InUse) return;
+
+  if (Dataref->Kind == DATAREF_KIND_ACCESSOR)
+  {
+    if (Dataref->WriteInt != NULL) Dataref->WriteInt(Dataref->WriteRefcon, inValue);
+    return;
+  }
+
+  Dataref->Ints[0] = inValue;
+  Dataref->Floats[0] = (float)inValue;
+  NotifySharers(Dataref);
+}
+
+float XPLMGetDataf
+  (
+  XPLMDataRef inDataRef
+  )
+{
+  fake_dataref_t *Dataref = (fake_dataref_t *)inDataRef;
+  if ((Dataref == NULL) || !Dataref->InUse) return 0;
+
+  if (Dataref->Kind != DATAREF_KIND_ACCESSOR) return Dataref->Floats[0];
+  if (Dataref->ReadFloat != NULL) return Dataref->ReadFloat(Dataref->ReadRefcon);
+  if (Dataref->ReadInt != NULL) return (float)Dataref->ReadInt(Dataref->ReadRefcon);
+  return 0;
+}
+
+void XPLMSetDataf
+  (
+  XPLMDataRef inDataRef,
+  float inValue
+  )
+{
+  fake_dataref_t *Dataref = (fake_dataref_t *)inDataRef;
+  if ((Dataref == NULL) || !Dataref->InUse) return;
+
+  if (Dataref->Kind == DATAREF_KIND_ACCESSOR)
+  {
+    if (Dataref->WriteFloat != NULL) Dataref->WriteFloat(Dataref->WriteRefcon, inValue);
+    return;
+  }
+
+  Dataref->Floats[0] = inValue;
+  Dataref->Ints[0] = (int)inValue;
+  NotifySharers(Dataref);
+}
+
+int XPLMGetDatavi
+  (
+  XPLMDataRef inDataRef,
+  int *outValues,
+  int inOffset,
+  int inMax
+  )
+{
+  fake_dataref_t *Dataref = (fake_dataref_t *)inDataRef;
+  if ((Dataref == NULL) || !Dataref->InUse) return 0;
+
+  if (Dataref->Kind == DATAREF_KIND_ACCESSOR)
+  {
+    return (Dataref->ReadIntArray != NULL) ? Dataref->ReadIntArray(Dataref->ReadRefcon, outValues, inOffset, inMax) : 0;
+  }
+
+  if (outValues == NULL) return FAKE_XPLM_MAX_VALUES;
+  int Count = 0;
+  for (int v = inOffset; (v < FAKE_XPLM_MAX_VALUES) && (Count < inMax); v++) outValues[Count++] = Dataref->Ints[v];
+  return Count;
+}
+
+void XPLMSetDatavi
+  (
+  XPLMDataRef inDataRef,
+  int *inValues,
+  int inoffset,
+  int inCount
+  )
+{
+  fake_dataref_t *Dataref = (fake_dataref_t *)inDataRef;
+  if ((Dataref == NULL) || !Dataref->InUse || (Dataref->Kind == DATAREF_KIND_ACCESSOR)) return;
+
+  for (int v = 0; (v < inCount) && (inoffset + v < FAKE_XPLM_MAX_VALUES); v++)
+  {
+    Dataref->Ints[inoffset + v] = inValues[v];
+    Dataref->Floats[inoffset + v] = (float)inValues[v];
+  }
+  NotifySharers(Dataref);
+}
+
+int XPLMGetDatavf
+  (
+  XPLMDataRef inDataRef,
+  float *outValues,
+  int inOffset,
+  int inMax
+  )
+{
+  fake_dataref_t *Dataref = (fake_dataref_t *)inDataRef;
+  if ((Dataref == NULL) || !Dataref->InUse) return 0;
+
+  if (Dataref->Kind == DATAREF_KIND_ACCESSOR)
+  {
+    return (Dataref->ReadFloatArray != NULL) ? Dataref->ReadFloatArray(Dataref->ReadRefcon, outValues, inOffset, inMax) : 0;
+  }
+
+  if (outValues == NULL) return FAKE_XPLM_MAX_VALUES;
+  int Count = 0;
+  for (int v = inOffset; (v < FAKE_XPLM_MAX_VALUES) && (Count < inMax); v++) outValues[Count++] = Dataref->Floats[v];
+  return Count;
+}
+
+void XPLMSetDatavf
+  (
+  XPLMDataRef inDataRef,
+  float *inValues,
+  int inoffset,
+  int inCount
+  )
+{
+  fake_dataref_t *Dataref = (fake_dataref_t *)inDataRef;
+  if ((Dataref == NULL) || !Dataref->InUse || (Dataref->Kind == DATAREF_KIND_ACCESSOR)) return;
+
+  for (int v = 0; (v < inCount) && (inoffset + v < FAKE_XPLM_MAX_VALUES); v++)
+  {
+    Dataref->Floats[inoffset + v] = inValues[v];
+    Dataref->Ints[inoffset + v] = (int)inValues[v];
+  }
+  NotifySharers(Dataref);
+}
+
+int XPLMGetDatab
+  (
+  XPLMDataRef inDataRef,
+  void *outValue,
+  int inOffset,
+  int inMaxBytes
+  )
+{
+  fake_dataref_t *Dataref = (fake_dataref_t *)inDataRef;
+  if ((Dataref == NULL) || !Dataref->InUse || (Dataref->Kind == DATAREF_KIND_ACCESSOR)) return 0;
+
+  if (outValue == NULL) return FAKE_XPLM_MAX_BYTES;
+  if ((inOffset < 0) || (inOffset >= FAKE_XPLM_MAX_BYTES)) return 0;
+
+  // like X-Plane this copies the whole array, which isn't terminated if the text fills it
+  int Count = FAKE_XPLM_MAX_BYTES - inOffset;
+  if (Count > inMaxBytes) Count = inMaxBytes;
+  memcpy(outValue, &Dataref->Bytes[inOffset], Count);
+  return Count;
+}
+
+void XPLMSetDatab
+  (
+  XPLMDataRef inDataRef,
+  void *inValue,
+  int inOffset,
+  int inLength
+  )
+{
+  fake_dataref_t *Dataref = (fake_dataref_t *)inDataRef;
+  if ((Dataref == NULL) || !Dataref->InUse || (Dataref->Kind == DATAREF_KIND_ACCESSOR)) return;
+  if ((inOffset < 0) || (inOffset >= FAKE_XPLM_MAX_BYTES)) return;
+
+  int Count = FAKE_XPLM_MAX_BYTES - inOffset;
+  if (Count > inLength) Count = inLength;
+  memcpy(&Dataref->Bytes[inOffset], inValue, Count);
+  NotifySharers(Dataref);
+}
+
+XPLMDataRef XPLMRegisterDataAccessor
+  (
+  const char *inDataName,
+  XPLMDataTypeID inDataType,
+  int inIsWritable,
+  XPLMGetDatai_f inReadInt,
+  XPLMSetDatai_f inWriteInt,
+  XPLMGetDataf_f inReadFloat,
+  XPLMSetDataf_f inWriteFloat,
+  XPLMGetDatad_f inReadDouble,
+  XPLMSetDatad_f inWriteDouble,
+  XPLMGetDatavi_f inReadIntArray,
+  XPLMSetDatavi_f inWriteIntArray,
+  XPLMGetDatavf_f inReadFloatArray,
+  XPLMSetDatavf_f inWriteFloatArray,
+  XPLMGetDatab_f inReadData,
+  XPLMSetDatab_f inWriteData,
+  void *inReadRefcon,
+  void *inWriteRefcon
+  )
+{
+  if (FindDataref(inDataName, false) != NULL)
+  {
+    fprintf(stderr, "FakeXPLM: dataref %s already exists\n", inDataName);
+    return NULL;
+  }
+
+  fake_dataref_t *Dataref = FindDataref(inDataName, true);
+  if (Dataref == NULL) return NULL;
+
+  Dataref->Kind           = DATAREF_KIND_ACCESSOR;
+  Dataref->ReadInt        = inReadInt;
+  Dataref->WriteInt       = inIsWritable ? inWriteInt : NULL;
+  Dataref->ReadFloat      = inReadFloat;
+  Dataref->WriteFloat     = inIsWritable ? inWriteFloat : NULL;
+  Dataref->ReadIntArray   = inReadIntArray;
+  Dataref->ReadFloatArray = inReadFloatArray;
+  Dataref->ReadRefcon     = inReadRefcon;
+  Dataref->WriteRefcon    = inWriteRefcon;
+  return (XPLMDataRef)Dataref;
+}
+
+void XPLMUnregisterDataAccessor
+  (
+  XPLMDataRef inDataRef
+  )
+{
+  fake_dataref_t *Dataref = (fake_dataref_t *)inDataRef;
+  if ((Dataref == NULL) || (Dataref->Kind != DATAREF_KIND_ACCESSOR)) return;
+
+  // the name is kept so the slot isn't reused while the plugin may still hold the handle
+  Dataref->InUse = false;
+}
+
+int XPLMShareData
+  (
+  const char *inDataName,
+  XPLMDataTypeID inDataType,
+  XPLMDataChanged_f inNotificationFunc,
+  void *inNotificationRefcon
+  )
+{
+  fake_dataref_t *Dataref = FindDataref(inDataName, true);
+  if ((Dataref == NULL) || (Dataref->Kind == DATAREF_KIND_ACCESSOR) || (Dataref->NumSharers >= FAKE_XPLM_MAX_SHARERS)) return 0;
+
+  Dataref->Kind = DATAREF_KIND_SHARED;
+  Dataref->Notify[Dataref->NumSharers]       = inNotificationFunc;
+  Dataref->NotifyRefcon[Dataref->NumSharers] = inNotificationRefcon;
+  Dataref->NumSharers++;
+  return 1;
+}
+
+int XPLMUnshareData
+  (
+  const char *inDataName,
+  XPLMDataTypeID inDataType,
+  XPLMDataChanged_f inNotificationFunc,
+  void *inNotificationRefcon
+  )
+{
+  fake_dataref_t *Dataref = FindDataref(inDataName, false);
+  if ((Dataref == NULL) || (Dataref->Kind != DATAREF_KIND_SHARED)) return 0;
+
+  for (int s = 0; s < Dataref->NumSharers; s++)
+  {
+    if ((Dataref->Notify[s] != inNotificationFunc) || (Dataref->NotifyRefcon[s] != inNotificationRefcon)) continue;
+
+    Dataref->NumSharers--;
+    Dataref->Notify[s]       = Dataref->Notify[Dataref->NumSharers];
+    Dataref->NotifyRefcon[s] = Dataref->NotifyRefcon[Dataref->NumSharers];
+    return 1;
+  }
+
+  return 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// XPLM UTILITIES
+
+XPLMCommandRef XPLMFindCommand
+  (
+  const char *inName
+  )
+{
+  return (XPLMCommandRef)FindCommand(inName, IsSimName(inName));
+}
+
+XPLMCommandRef XPLMCreateCommand
+  (
+  const char *inName,
+  const char *inDescription
+  )
+{
+  return (XPLMCommandRef)FindCommand(inName, true);
+}
+
+void XPLMRegisterCommandHandler
+  (
+  XPLMCommandRef inComand,
+  XPLMCommandCallback_f inHandler,
+  int inBefore,
+  void *inRefcon
+  )
+{
+  fake_command_t *Command = (fake_command_t *)inComand;
+  if ((Command == NULL) || (Command->NumHandlers >= FAKE_XPLM_MAX_HANDLERS)) return;
+
+  Command->Handlers[Command->NumHandlers] = inHandler;
+  Command->Refcons[Command->NumHandlers]  = inRefcon;
+  Command->NumHandlers++;
+}
+
+void XPLMCommandBegin
+  (
+  XPLMCommandRef inCommand
+  )
+{
+  fake_command_t *Command = (fake_command_t *)inCommand;
+  if (Command == NULL) return;
+
+  Command->Held = true;
+  Command->Count++;
+  RunHandlers(Command, xplm_CommandBegin);
+}
+
+void XPLMCommandEnd
+  (
+  XPLMCommandRef inCommand
+  )
+{
+  fake_command_t *Command = (fake_command_t *)inCommand;
+  if ((Command == NULL) || !Command->Held) return;
+
+  Command->Held = false;
+  RunHandlers(Command, xplm_CommandEnd);
+}
+
+void XPLMCommandOnce
+  (
+  XPLMCommandRef inCommand
+  )
+{
+  XPLMCommandBegin(inCommand);
+  XPLMCommandEnd(inCommand);
+}
+
+void XPLMSpeakString
+  (
+  const char *inString
+  )
+{
+  SpokenCount++;
+  snprintf(LastSpoken, sizeof(LastSpoken), "%s", inString);
+}
+
+void XPLMDebugString
+  (
+  const char *inString
+  )
+{
+}
+
+const char *XPLMGetDirectorySeparator
+  (
+  void
+  )
+{
+#if IBM
+  return "\\";
+#else
+  return "/";
+#endif
+}
+
+void XPLMEnableFeature
+  (
+  const char *inFeature,
+  int inEnable
+  )
+{
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// XPLM PLUGINS
+
+XPLMPluginID XPLMGetMyID
+  (
+  void
+  )
+{
+  return FAKE_XPLM_PLUGIN_ID;
+}
+
+void XPLMGetPluginInfo
+  (
+  XPLMPluginID inPlugin,
+  char *outName,
+  char *outFilePath,
+  char *outSignature,
+  char *outDescription
+  )
+{
+  if (outName != NULL) outName[0] = '\0';
+  if (outFilePath != NULL) snprintf(outFilePath, 256, "%s", PluginPath);
+  if (outSignature != NULL) outSignature[0] = '\0';
+  if (outDescription != NULL) outDescription[0] = '\0';
+}
+
+XPLMPluginID XPLMFindPluginBySignature
+  (
+  const char *inSignature
+  )
+{
+  // there are no other plugins
+  return XPLM_NO_PLUGIN_ID;
+}
+
+void XPLMSendMessageToPlugin
+  (
+  XPLMPluginID inPlugin,
+  int inMessage,
+  void *inParam
+  )
+{
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// XPLM PROCESSING
+
+XPLMFlightLoopID XPLMCreateFlightLoop
+  (
+  XPLMCreateFlightLoop_t *inParams
+  )
+{
+  for (int l = 0; l < FAKE_XPLM_MAX_FLIGHT_LOOPS; l++)
+  {
+    fake_flight_loop_t *Loop = &FlightLoops[l];
+    if (Loop->InUse) continue;
+
+    memset(Loop, 0, sizeof(fake_flight_loop_t));
+    Loop->InUse        = true;
+    Loop->Callback     = inParams->callbackFunc;
+    Loop->Refcon       = inParams->refcon;
+    Loop->LastCallTime = SimTime;
+    return (XPLMFlightLoopID)Loop;
+  }
+
+  fprintf(stderr, "FakeXPLM: no room for a flight loop\n");
+  return NULL;
+}
+
+void XPLMDestroyFlightLoop
+  (
+  XPLMFlightLoopID inFlightLoopID
+  )
+{
+  fake_flight_loop_t *Loop = (fake_flight_loop_t *)inFlightLoopID;
+  if (Loop != NULL) Loop->InUse = false;
+}
+
+void XPLMScheduleFlightLoop
+  (
+  XPLMFlightLoopID inFlightLoopID,
+  float inInterval,
+  int inRelativeToNow
+  )
+{
+  fake_flight_loop_t *Loop = (fake_flight_loop_t *)inFlightLoopID;
+  if ((Loop == NULL) || !Loop->InUse) return;
+
+  ScheduleFlightLoop(Loop, inInterval, inRelativeToNow ? SimTime : Loop->LastCallTime);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// XPLM MENUS
+
+XPLMMenuID XPLMFindPluginsMenu
+  (
+  void
+  )
+{
+  return (XPLMMenuID)&Menus[0];
+}
+
+XPLMMenuID XPLMCreateMenu
+  (
+  const char *inName,
+  XPLMMenuID inParentMenu,
+  int inParentItem,
+  XPLMMenuHandler_f inHandler,
+  void *inMenuRef
+  )
+{
+  for (int m = 1; m < FAKE_XPLM_MAX_MENUS; m++)
+  {
+    fake_menu_t *Menu = &Menus[m];
+    if (Menu->InUse) continue;
+
+    memset(Menu, 0, sizeof(fake_menu_t));
+    Menu->InUse   = true;
+    Menu->Handler = inHandler;
+    Menu->MenuRef = inMenuRef;
+    return (XPLMMenuID)Menu;
+  }
+
+  fprintf(stderr, "FakeXPLM: no room for menu %s\n", inName);
+  return NULL;
+}
+
+int XPLMAppendMenuItem
+  (
+  XPLMMenuID inMenu,
+  const char *inItemName,
+  void *inItemRef,
+  int inDeprecatedAndIgnored
+  )
+{
+  fake_menu_t *Menu = (fake_menu_t *)inMenu;
+  if ((Menu == NULL) || (Menu->NumItems >= FAKE_XPLM_MAX_MENU_ITEMS)) return -1;
+
+  int Item = Menu->NumItems++;
+  snprintf(Menu->ItemNames[Item], FAKE_XPLM_NAME_SIZE, "%s", inItemName);
+  Menu->ItemRefs[Item] = inItemRef;
+  Menu->Checks[Item]   = xplm_Menu_NoCheck;
+  return Item;
+}
+
+void XPLMCheckMenuItem
+  (
+  XPLMMenuID inMenu,
+  int index,
+  XPLMMenuCheck inCheck
+  )
+{
+  fake_menu_t *Menu = (fake_menu_t *)inMenu;
+  if ((Menu == NULL) || (index < 0) || (index >= Menu->NumItems)) return;
+
+  Menu->Checks[index] = inCheck;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// XPLM SCENERY
+
+XPLMProbeRef XPLMCreateProbe
+  (
+  XPLMProbeType inProbeType
+  )
+{
+  // there is nothing to keep for a probe of flat terrain
+  static int Probe;
+  return (XPLMProbeRef)&Probe;
+}
+
+void XPLMDestroyProbe
+  (
+  XPLMProbeRef inProbe
+  )
+{
+}
+
+XPLMProbeResult XPLMProbeTerrainXYZ
+  (
+  XPLMProbeRef inProbe,
+  float inX,
+  float inY,
+  float inZ,
+  XPLMProbeInfo_t *outInfo
+  )
+{
+  outInfo->locationX = inX;
+  outInfo->locationY = 0;
+  outInfo->locationZ = inZ;
+  outInfo->normalX   = 0;
+  outInfo->normalY   = 1;
+  outInfo->normalZ   = 0;
+  outInfo->velocityX = 0;
+  outInfo->velocityY = 0;
+  outInfo->velocityZ = 0;
+  outInfo->is_wet    = 0;
+  return xplm_ProbeHitTerrain;
+}
@@ -0,0 +1,77 @@
+// Landing Throttle Manager - FakeSim
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Fake X-Plane for running the plugin without the simulator
+// FakeXPLM.cpp implements the XPLM functions the plugin uses, so linking it in place of
+// XPLM_64.lib turns the plugin into part of an ordinary program. the program plays the
+// part of X-Plane: it starts the plugin, writes the sim datarefs and moves time on a frame
+// at a time, and the plugin's flight loops, commands, menus and datarefs work as they do
+// in the sim. the program reads and writes datarefs and finds commands with the XPLM API
+// like any other plugin, the functions here do what only X-Plane can.
+// sim time only moves on with each frame, so apart from the timestamps in the log every
+// run gives the same result.
+// sim datarefs and commands, the ones starting with "sim/", exist as soon as they are
+// looked up and start at zero, everything else has to be created by the plugin.
+// the terrain is flat at a local y of zero.
+// the tables have a fixed size and nothing is allocated
+
+#ifndef _FAKE_XPLM_H_
+#define _FAKE_XPLM_H_
+
+#include "XPLMDefs.h"
+#include "XPLMUtilities.h"
+
+// sizes of the tables
+#define FAKE_XPLM_MAX_DATAREFS     128
+#define FAKE_XPLM_MAX_COMMANDS     32
+#define FAKE_XPLM_MAX_FLIGHT_LOOPS 16
+#define FAKE_XPLM_MAX_MENUS        8
+#define FAKE_XPLM_MAX_MENU_ITEMS   16
+// longest dataref, command or menu item name
+#define FAKE_XPLM_NAME_SIZE 128
+// number of values in an array dataref
+#define FAKE_XPLM_MAX_VALUES 16
+// size of a byte array dataref, the same as sim/aircraft/view/acf_descrip
+#define FAKE_XPLM_MAX_BYTES 260
+// the sim time dataref, written at the start of each frame
+#define FAKE_XPLM_SIM_TIME_DATAREF "sim/time/total_running_time_sec"
+
+// the plugin, implemented by Main.cpp
+PLUGIN_API int XPluginStart(char *outName, char *outSig, char *outDesc);
+PLUGIN_API void XPluginStop(void);
+PLUGIN_API int XPluginEnable(void);
+PLUGIN_API void XPluginDisable(void);
+PLUGIN_API void XPluginReceiveMessage(XPLMPluginID inFromWho, int inMessage, void *inParam);
+
+// forgets everything and sets sim time to zero, PluginFolder is where the plugin is
+// installed, with a trailing directory separator. call before starting the plugin
+extern void FakeXPLM_Reset(const char *PluginFolder);
+// starts and enables the plugin
+// returns false if it failed to start
+extern bool FakeXPLM_StartPlugin(void);
+// disables and stops the plugin
+extern void FakeXPLM_StopPlugin(void);
+// sends a message to the plugin as X-Plane would, e.g. XPLM_MSG_PLANE_LOADED
+extern void FakeXPLM_SendMessage(int Message, void *Param);
+// moves sim time on by FrameTime seconds and runs the flight loops that are due
+extern void FakeXPLM_RunFrame(float FrameTime);
+// returns the sim time in seconds
+extern float FakeXPLM_GetSimTime(void);
+
+// returns true while a command is being held
+extern bool FakeXPLM_IsCommandHeld(XPLMCommandRef Command);
+// returns the number of times a command has been started, by being held or issued once
+extern int FakeXPLM_GetCommandCount(XPLMCommandRef Command);
+// issues a command once as if the user pressed a button bound to it
+// returns false if there is no such command
+extern bool FakeXPLM_RunCommand(const char *Name);
+// chooses a menu item by its name as if the user clicked on it
+// returns false if there is no such item
+extern bool FakeXPLM_ChooseMenuItem(const char *Name);
+
+// returns the number of times something has been spoken
+extern int FakeXPLM_GetSpokenCount(void);
+// returns the last thing spoken, empty if nothing has been
+extern const char *FakeXPLM_GetLastSpoken(void);
+
+#endif // _FAKE_XPLM_H_
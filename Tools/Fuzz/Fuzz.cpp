@@ -0,0 +1,613 @@
+// Landing Throttle Manager - Fuzz
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Checks the plugin against randomly generated landings using the fake X-Plane in
+// Tools/FakeSim, see FakeXPLM.h.
+// each trace is a short final approach and rollout flown at a high and uneven frame
+// rate, with the things that trip up the timing of the state machine thrown in:
+// bouncing touch downs, the on ground values of the gears flickering, noise on the
+// indicated airspeed around the reverse thrust cutoff, the user stopping the manager
+// or pressing enable again part way through. after every frame the commands the
+// plugin holds are checked against these properties:
+//   reverse thrust never begins unless all the wheels were on the ground in that frame
+//   a command is never begun while it is already held, and nothing is left held once
+//     the manager is back to waiting for the user
+//   once the user has asked the manager to stop, the first execution in a state that
+//     can be stopped releases every command
+//   reverse thrust begins at most once each time the manager is enabled
+//   the manager always finishes
+//   voice guidance is never said less than VOICE_INTERVAL after the last message
+// every trace is made from its number so a run is the same every time. the plugin is
+// restarted every FUZZ_TRACES_PER_SESSION traces to keep the sim time small, so to
+// repeat a failure run the session it was in, which is printed with the failure.
+// runs can be split over several processes with the first trace number
+//
+// usage: Fuzz [number of traces] [first trace] [plugin folder]
+//   the plugin folder gets the plugin's log and recordings, default the current folder
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "XPLMDataAccess.h"
+#include "XPLMPlugin.h"
+#include "XPLMPlanes.h"
+#include "XPLMUtilities.h"
+#include "StateMachine.h"
+#include "Voice.h"
+#include "FakeXPLM.h"
+
+// default number of traces
+#define FUZZ_DEFAULT_TRACES 10000
+// number of traces run before the plugin is restarted
+#define FUZZ_TRACES_PER_SESSION 256
+// longest trace in sim seconds before the manager is failed for not finishing
+#define FUZZ_MAX_TRACE_TIME 120.0f
+// frames run after the manager finishes to check nothing is begun again
+#define FUZZ_SETTLE_FRAMES 10
+// number of failures printed, the rest are only counted
+#define FUZZ_MAX_REPORTED 20
+// meters per second in a knot
+#define FUZZ_KNOTS_TO_MS 0.514444f
+// allowance for rounding in the sim time when checking the time between messages, in seconds
+#define FUZZ_TIME_TOLERANCE 0.001f
+// the plugin's commands and the log level menu item that keeps the log small
+#define FUZZ_ENABLE_COMMAND "Landing Throttle Manager//Enable"
+#define FUZZ_STOP_COMMAND   "Landing Throttle Manager//Stop"
+#define FUZZ_LOG_LEVEL_ITEM "Errors only"
+// aircraft the traces are flown in
+#define FUZZ_AIRCRAFT_DESCRIPTION "X-Crafts ERJ-175 Embraer E175 Regional Jet"
+
+// datarefs and commands of the aircraft, the defaults in the profiles
+#define DATAREF_THROTTLE_RATIO_ALL   "sim/cockpit2/engine/actuators/throttle_ratio_all"
+#define DATAREF_THROTTLE_RATIO       "sim/cockpit2/engine/actuators/throttle_ratio"
+#define DATAREF_NUM_ENGINES          "sim/aircraft/engine/acf_num_engines"
+#define DATAREF_INDICATED_AIRSPEED   "sim/flightmodel/position/indicated_airspeed2"
+#define DATAREF_GROUND_SPEED         "sim/flightmodel/position/groundspeed"
+#define DATAREF_ON_GROUND            "sim/flightmodel2/gear/on_ground"
+#define DATAREF_FLAP_ANGLE           "sim/flightmodel2/wing/flap1_deg"
+#define DATAREF_GEAR_DEPLOY_RATIO    "sim/flightmodel2/gear/deploy_ratio"
+#define DATAREF_ALTITUDE             "sim/flightmodel2/position/y_agl"
+#define DATAREF_DESCRIPTION          "sim/aircraft/view/acf_descrip"
+#define DATAREF_MANAGER_STATE        "landingthrottlemanager/state"
+#define DATAREF_TICK_COUNT           "landingthrottlemanager/perf/tick_count"
+#define COMMAND_THROTTLE_DOWN        "sim/engines/throttle_down"
+#define COMMAND_REVERSE_THRUST       "sim/engines/thrust_reverse_hold"
+
+// the aircraft model
+#define NUM_ENGINES 2
+#define NUM_GEARS 3
+#define NOSE_GEAR 0
+// throttle movement per second while throttle down is held
+#define THROTTLE_DOWN_RATE 1.5f
+// downwards acceleration after a bounce in meters per second squared
+#define BOUNCE_GRAVITY 4.0f
+// decelerations in meters per second squared
+#define AIRBORNE_DECELERATION 0.4f
+#define ROLLING_DECELERATION 0.8f
+// height in meters below which the on ground values can flicker
+#define FLICKER_ALTITUDE 0.5f
+
+// the properties that are checked
+typedef enum _property_t
+{
+  PROPERTY_REVERSE_BEFORE_ALL_WHEELS_DOWN,
+  PROPERTY_BEGIN_WHILE_HELD,
+  PROPERTY_HELD_AFTER_FINISHING,
+  PROPERTY_HELD_AFTER_STOP,
+  PROPERTY_REVERSE_BEGUN_TWICE,
+  PROPERTY_NOT_FINISHED,
+  PROPERTY_NOT_ENABLED,
+  PROPERTY_SPOKEN_TOO_SOON,
+  NUM_PROPERTIES
+} property_t;
+
+// descriptions of the properties, indexed by property_t
+static const char *PropertyNames[NUM_PROPERTIES] =
+{
+  "reverse thrust begun without all the wheels on the ground",
+  "command begun while already held",
+  "command held after the manager finished",
+  "command held after the execution that should have stopped the manager",
+  "reverse thrust begun twice in one landing",
+  "manager didn't finish",
+  "manager couldn't be enabled",
+  "voice guidance said too soon after the last message"
+};
+
+// one trace, the values at the top are chosen at the start and don't change
+typedef struct _trace_t
+{
+  unsigned int Sequence;        // state of the numbers the trace is made from
+  float FrameTime;              // mean seconds per frame
+  float FrameJitter;            // fraction each frame time can be off by
+  float NoseGearDelay;          // seconds from the main gear to the nose gear touching down
+  float BrakingDeceleration;    // meters per second squared once all the wheels are down
+  float ReverseDeceleration;    // meters per second squared added by reverse thrust
+  float AirspeedNoise;          // knots either side of the true airspeed
+  float FlickerChance;          // chance on each frame of one on ground value being wrong
+  int   BouncesLeft;            // number of bounces still to come
+  float BounceSpeed;            // meters per second upwards when bouncing
+  float StopTime;               // seconds after enabling the user stops the manager, -1 for never
+  float EnableAgainTime;        // seconds after enabling the user presses enable again, -1 for never
+
+  float Altitude;               // meters above ground of the main gear
+  float VerticalSpeed;          // meters per second, negative when descending
+  float Acceleration;           // vertical, meters per second squared
+  float Speed;                  // meters per second
+  float Throttle;               // 0 = idle, 1 = full
+  float MainsDownTime;          // sim time the main gear last touched down, -1 while airborne
+} trace_t;
+
+// the datarefs and commands, looked up once per session
+static XPLMDataRef ThrottleRatioAllRef = NULL;
+static XPLMDataRef ThrottleRatioRef = NULL;
+static XPLMDataRef IndicatedAirspeedRef = NULL;
+static XPLMDataRef GroundSpeedRef = NULL;
+static XPLMDataRef OnGroundRef = NULL;
+static XPLMDataRef AltitudeRef = NULL;
+static XPLMDataRef ManagerStateRef = NULL;
+static XPLMDataRef TickCountRef = NULL;
+static XPLMCommandRef ThrottleDownCmd = NULL;
+static XPLMCommandRef ReverseThrustCmd = NULL;
+// failures of each property over the run
+static int PropertyFailures[NUM_PROPERTIES];
+static int NumReported = 0;
+// frames run over the whole run
+static uint64_t TotalFrames = 0;
+// messages said so far in the session and when the last one was, -1 for never
+static int SpokenCount = 0;
+static float LastSpokenTime = -1;
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// INTERNAL FUNCTIONS
+
+// returns the next number from the sequence of a trace between Min and Max
+static float Vary
+  (
+  trace_t *Trace,
+  float Min,
+  float Max
+  )
+{
+  Trace->Sequence = (Trace->Sequence * 1103515245u) + 12345u;
+  return Min + ((Max - Min) * (float)((Trace->Sequence >> 8) & 0xFFFF) / 65535.0f);
+}
+
+// returns true with a chance from 0 to 1
+static bool Chance
+  (
+  trace_t *Trace,
+  float Probability
+  )
+{
+  return Vary(Trace, 0.0f, 1.0f) < Probability;
+}
+
+// makes the starting conditions of a trace from its number
+static void MakeTrace
+  (
+  trace_t *Trace,
+  int Number
+  )
+{
+  memset(Trace, 0, sizeof(trace_t));
+  Trace->Sequence = ((unsigned int)Number * 2654435761u) ^ 0x5A17C3E5u;
+
+  // anything from a slow sim to a fast monitor, some with a very uneven frame rate
+  Trace->FrameTime           = 1.0f / Vary(Trace, 20.0f, 240.0f);
+  Trace->FrameJitter         = Chance(Trace, 0.3f) ? Vary(Trace, 0.0f, 0.9f) : 0.0f;
+  Trace->NoseGearDelay       = Vary(Trace, 0.0f, 2.5f);
+  Trace->BrakingDeceleration = Vary(Trace, 0.5f, 3.0f);
+  Trace->ReverseDeceleration = Vary(Trace, 0.5f, 4.0f);
+  Trace->AirspeedNoise       = Chance(Trace, 0.5f) ? Vary(Trace, 0.0f, 4.0f) : 0.0f;
+  Trace->FlickerChance       = Chance(Trace, 0.3f) ? Vary(Trace, 0.0f, 0.3f) : 0.0f;
+  Trace->BouncesLeft         = Chance(Trace, 0.4f) ? (int)Vary(Trace, 1.0f, 3.99f) : 0;
+  Trace->BounceSpeed         = Vary(Trace, 0.2f, 2.0f);
+  Trace->StopTime            = Chance(Trace, 0.2f) ? Vary(Trace, 0.0f, 15.0f) : -1.0f;
+  Trace->EnableAgainTime     = Chance(Trace, 0.2f) ? Vary(Trace, 0.0f, 15.0f) : -1.0f;
+
+  // start close to the runway so the traces are short
+  Trace->Altitude      = Vary(Trace, 0.5f, 30.0f);
+  Trace->VerticalSpeed = Vary(Trace, -4.0f, -0.5f);
+  Trace->Acceleration  = 0;
+  Trace->Speed         = Vary(Trace, 65.0f, 150.0f) * FUZZ_KNOTS_TO_MS;
+  Trace->Throttle      = Chance(Trace, 0.2f) ? 0.0f : Vary(Trace, 0.05f, 0.8f);
+  Trace->MainsDownTime = -1;
+}
+
+// moves the aircraft on by one frame ending at sim time Now
+static void MoveAircraft
+  (
+  trace_t *Trace,
+  float FrameTime,
+  float Now,
+  bool Reverse
+  )
+{
+  if (FakeXPLM_IsCommandHeld(ThrottleDownCmd))
+  {
+    Trace->Throttle -= THROTTLE_DOWN_RATE * FrameTime;
+    if (Trace->Throttle < 0) Trace->Throttle = 0;
+  }
+  else
+  {
+    // the plugin may have moved the engine throttles itself
+    XPLMGetDatavf(ThrottleRatioRef, &Trace->Throttle, 0, 1);
+  }
+
+  float Deceleration = ROLLING_DECELERATION;
+  if (Trace->MainsDownTime < 0)
+  {
+    Trace->VerticalSpeed -= Trace->Acceleration * FrameTime;
+    Trace->Altitude += Trace->VerticalSpeed * FrameTime;
+    if (Trace->Altitude <= 0)
+    {
+      Trace->Altitude = 0;
+      Trace->VerticalSpeed = 0;
+      Trace->MainsDownTime = Now;
+    }
+    Deceleration = AIRBORNE_DECELERATION;
+  }
+  else if ((Trace->BouncesLeft > 0) && (Now - Trace->MainsDownTime >= Vary(Trace, 0.0f, 0.5f)))
+  {
+    // back into the air for a moment, the nose gear comes up with the mains
+    Trace->BouncesLeft--;
+    Trace->VerticalSpeed = Trace->BounceSpeed * Vary(Trace, 0.3f, 1.0f);
+    Trace->Acceleration = BOUNCE_GRAVITY;
+    Trace->Altitude = 0.01f;
+    Trace->MainsDownTime = -1;
+  }
+  else if (Now - Trace->MainsDownTime >= Trace->NoseGearDelay)
+  {
+    Deceleration += Trace->BrakingDeceleration;
+  }
+
+  if (Reverse && (Trace->MainsDownTime >= 0)) Deceleration += Trace->ReverseDeceleration;
+  Trace->Speed -= Deceleration * FrameTime;
+  if (Trace->Speed < 0) Trace->Speed = 0;
+}
+
+// writes the state of the aircraft into the sim datarefs with the noise of the trace
+// returns true if all the wheels were written as being on the ground
+static bool WriteAircraft
+  (
+  trace_t *Trace,
+  float Now
+  )
+{
+  float Throttles[NUM_ENGINES];
+  for (int e = 0; e < NUM_ENGINES; e++) Throttles[e] = Trace->Throttle;
+  XPLMSetDatavf(ThrottleRatioRef, Throttles, 0, NUM_ENGINES);
+  XPLMSetDataf(ThrottleRatioAllRef, Trace->Throttle);
+  XPLMSetDataf(AltitudeRef, Trace->Altitude);
+  XPLMSetDataf(GroundSpeedRef, Trace->Speed);
+
+  float Airspeed = Trace->Speed / FUZZ_KNOTS_TO_MS;
+  if (Trace->AirspeedNoise > 0) Airspeed += Vary(Trace, -Trace->AirspeedNoise, Trace->AirspeedNoise);
+  if (Airspeed < 0) Airspeed = 0;
+  XPLMSetDataf(IndicatedAirspeedRef, Airspeed);
+
+  bool MainsDown = (Trace->MainsDownTime >= 0);
+  bool NoseDown = MainsDown && (Now - Trace->MainsDownTime >= Trace->NoseGearDelay);
+  int OnGround[NUM_GEARS];
+  for (int g = 0; g < NUM_GEARS; g++) OnGround[g] = ((g == NOSE_GEAR) ? NoseDown : MainsDown) ? 1 : 0;
+
+  // one gear reads wrong for a frame close to the ground
+  if ((Trace->FlickerChance > 0) && (Trace->Altitude < FLICKER_ALTITUDE) && Chance(Trace, Trace->FlickerChance))
+  {
+    int Gear = (int)Vary(Trace, 0.0f, NUM_GEARS - 0.01f);
+    OnGround[Gear] = !OnGround[Gear];
+  }
+  XPLMSetDatavi(OnGroundRef, OnGround, 0, NUM_GEARS);
+
+  for (int g = 0; g < NUM_GEARS; g++)
+  {
+    if (!OnGround[g]) return false;
+  }
+  return true;
+}
+
+// notes what the plugin said in the frame that has just run
+// returns false if it was said too soon after the last message
+static bool CheckSpeech
+  (
+  void
+  )
+{
+  int NewSpokenCount = FakeXPLM_GetSpokenCount();
+  if (NewSpokenCount == SpokenCount) return true;
+
+  float Now = FakeXPLM_GetSimTime();
+  bool TooSoon = (NewSpokenCount - SpokenCount > 1) || ((LastSpokenTime >= 0) && (Now - LastSpokenTime < VOICE_INTERVAL - FUZZ_TIME_TOLERANCE));
+  SpokenCount = NewSpokenCount;
+  LastSpokenTime = Now;
+  return !TooSoon;
+}
+
+// records a failure of a property in a trace
+static void Fail
+  (
+  int Number,
+  int SessionFirst,
+  property_t Property,
+  float Elapsed
+  )
+{
+  PropertyFailures[Property]++;
+  if (NumReported >= FUZZ_MAX_REPORTED) return;
+  NumReported++;
+
+  printf("Trace %d: %s %.3f s after enabling, repeat with: Fuzz %d %d\n", Number, PropertyNames[Property], Elapsed, FUZZ_TRACES_PER_SESSION, SessionFirst);
+}
+
+// runs one trace and checks the properties after every frame
+// returns true if every property held
+static bool RunTrace
+  (
+  int Number,
+  int SessionFirst
+  )
+{
+  trace_t Trace;
+  MakeTrace(&Trace, Number);
+  int Failures = 0;
+
+  WriteAircraft(&Trace, FakeXPLM_GetSimTime());
+  FakeXPLM_RunFrame(Trace.FrameTime);
+  TotalFrames++;
+  if (!CheckSpeech())
+  {
+    Fail(Number, SessionFirst, PROPERTY_SPOKEN_TOO_SOON, 0);
+    Failures++;
+  }
+
+  FakeXPLM_RunCommand(FUZZ_ENABLE_COMMAND);
+  if (XPLMGetDatai(ManagerStateRef) == WAIT_FOR_USER)
+  {
+    Fail(Number, SessionFirst, PROPERTY_NOT_ENABLED, 0);
+    return false;
+  }
+
+  float EnableTime = FakeXPLM_GetSimTime();
+  bool StopSent = false;
+  bool EnableAgainSent = false;
+  bool StopPending = false;
+  bool Reverse = FakeXPLM_IsCommandHeld(ReverseThrustCmd);
+  bool ThrottleDown = FakeXPLM_IsCommandHeld(ThrottleDownCmd);
+  int ReverseCount = FakeXPLM_GetCommandCount(ReverseThrustCmd);
+  int ThrottleDownCount = FakeXPLM_GetCommandCount(ThrottleDownCmd);
+  int ReverseBegins = 0;
+  int Ticks = XPLMGetDatai(TickCountRef);
+  int State = XPLMGetDatai(ManagerStateRef);
+  int SettleFrames = -1;
+
+  while (SettleFrames != 0)
+  {
+    float Elapsed = FakeXPLM_GetSimTime() - EnableTime;
+    if (Elapsed > FUZZ_MAX_TRACE_TIME)
+    {
+      Fail(Number, SessionFirst, PROPERTY_NOT_FINISHED, Elapsed);
+      Failures++;
+      break;
+    }
+
+    // the user
+    if (!StopSent && (Trace.StopTime >= 0) && (Elapsed >= Trace.StopTime) && (State != WAIT_FOR_USER))
+    {
+      StopSent = true;
+      StopPending = true;
+      FakeXPLM_RunCommand(FUZZ_STOP_COMMAND);
+    }
+    if (!EnableAgainSent && (Trace.EnableAgainTime >= 0) && (Elapsed >= Trace.EnableAgainTime) && (State != WAIT_FOR_USER))
+    {
+      EnableAgainSent = true;
+      FakeXPLM_RunCommand(FUZZ_ENABLE_COMMAND);
+    }
+
+    float FrameTime = Trace.FrameTime;
+    if (Trace.FrameJitter > 0) FrameTime *= 1.0f + Vary(&Trace, -Trace.FrameJitter, Trace.FrameJitter);
+    float Now = FakeXPLM_GetSimTime() + FrameTime;
+
+    MoveAircraft(&Trace, FrameTime, Now, Reverse);
+    bool AllWheelsDown = WriteAircraft(&Trace, Now);
+    int StateBefore = State;
+    FakeXPLM_RunFrame(FrameTime);
+    TotalFrames++;
+
+    // see what the plugin did in the frame
+    Elapsed = FakeXPLM_GetSimTime() - EnableTime;
+    bool WasReverse = Reverse;
+    bool WasThrottleDown = ThrottleDown;
+    int NewReverseCount = FakeXPLM_GetCommandCount(ReverseThrustCmd);
+    int NewThrottleDownCount = FakeXPLM_GetCommandCount(ThrottleDownCmd);
+    int NewTicks = XPLMGetDatai(TickCountRef);
+    Reverse = FakeXPLM_IsCommandHeld(ReverseThrustCmd);
+    ThrottleDown = FakeXPLM_IsCommandHeld(ThrottleDownCmd);
+    State = XPLMGetDatai(ManagerStateRef);
+
+    int NewReverseBegins = NewReverseCount - ReverseCount;
+    if ((NewReverseBegins > 0) && !AllWheelsDown)
+    {
+      Fail(Number, SessionFirst, PROPERTY_REVERSE_BEFORE_ALL_WHEELS_DOWN, Elapsed);
+      Failures++;
+    }
+    if ((NewReverseBegins > 1) || ((NewReverseBegins > 0) && WasReverse) ||
+        (NewThrottleDownCount - ThrottleDownCount > 1) || ((NewThrottleDownCount > ThrottleDownCount) && WasThrottleDown))
+    {
+      Fail(Number, SessionFirst, PROPERTY_BEGIN_WHILE_HELD, Elapsed);
+      Failures++;
+    }
+    ReverseBegins += NewReverseBegins;
+    if ((NewReverseBegins > 0) && (ReverseBegins == 2))
+    {
+      Fail(Number, SessionFirst, PROPERTY_REVERSE_BEGUN_TWICE, Elapsed);
+      Failures++;
+    }
+
+    if ((State == WAIT_FOR_USER) && (Reverse || ThrottleDown))
+    {
+      Fail(Number, SessionFirst, PROPERTY_HELD_AFTER_FINISHING, Elapsed);
+      Failures++;
+    }
+
+    // an execution that started in a state the user can stop the manager in
+    bool Stoppable = (StateBefore == WAIT_FOR_IDLE_THROTTLE) || (StateBefore == WAIT_FOR_TOUCHDOWN) || (StateBefore == WAIT_FOR_END_OF_REVERSE);
+    if (StopPending && (NewTicks != Ticks) && Stoppable)
+    {
+      StopPending = false;
+      if ((State != WAIT_FOR_USER) || Reverse || ThrottleDown)
+      {
+        Fail(Number, SessionFirst, PROPERTY_HELD_AFTER_STOP, Elapsed);
+        Failures++;
+      }
+    }
+
+    if (!CheckSpeech())
+    {
+      Fail(Number, SessionFirst, PROPERTY_SPOKEN_TOO_SOON, Elapsed);
+      Failures++;
+    }
+
+    ReverseCount = NewReverseCount;
+    ThrottleDownCount = NewThrottleDownCount;
+    Ticks = NewTicks;
+
+    if (Failures > 0) break;
+    if (SettleFrames > 0) SettleFrames--;
+    else if ((SettleFrames < 0) && (State == WAIT_FOR_USER)) SettleFrames = FUZZ_SETTLE_FRAMES;
+  }
+
+  // make sure the next trace starts with the manager waiting for the user
+  if (XPLMGetDatai(ManagerStateRef) != WAIT_FOR_USER)
+  {
+    FakeXPLM_RunCommand(FUZZ_STOP_COMMAND);
+    for (int f = 0; (f < FUZZ_SETTLE_FRAMES) && (XPLMGetDatai(ManagerStateRef) != WAIT_FOR_USER); f++)
+    {
+      FakeXPLM_RunFrame(Trace.FrameTime);
+      if (!CheckSpeech())
+      {
+        Fail(Number, SessionFirst, PROPERTY_SPOKEN_TOO_SOON, FakeXPLM_GetSimTime() - EnableTime);
+        Failures++;
+      }
+    }
+  }
+
+  return Failures == 0;
+}
+
+// starts the plugin in a fresh fake sim with the aircraft loaded
+// returns false if the plugin failed to start
+static bool StartSession
+  (
+  const char *PluginFolder
+  )
+{
+  FakeXPLM_Reset(PluginFolder);
+  ThrottleRatioAllRef  = XPLMFindDataRef(DATAREF_THROTTLE_RATIO_ALL);
+  ThrottleRatioRef     = XPLMFindDataRef(DATAREF_THROTTLE_RATIO);
+  IndicatedAirspeedRef = XPLMFindDataRef(DATAREF_INDICATED_AIRSPEED);
+  GroundSpeedRef       = XPLMFindDataRef(DATAREF_GROUND_SPEED);
+  OnGroundRef          = XPLMFindDataRef(DATAREF_ON_GROUND);
+  AltitudeRef          = XPLMFindDataRef(DATAREF_ALTITUDE);
+  ThrottleDownCmd      = XPLMFindCommand(COMMAND_THROTTLE_DOWN);
+  ReverseThrustCmd     = XPLMFindCommand(COMMAND_REVERSE_THRUST);
+  SpokenCount          = FakeXPLM_GetSpokenCount();
+  LastSpokenTime       = -1;
+
+  char Description[FAKE_XPLM_MAX_BYTES];
+  memset(Description, 0, sizeof(Description));
+  snprintf(Description, sizeof(Description), "%s", FUZZ_AIRCRAFT_DESCRIPTION);
+  XPLMSetDatab(XPLMFindDataRef(DATAREF_DESCRIPTION), Description, 0, sizeof(Description));
+  XPLMSetDatai(XPLMFindDataRef(DATAREF_NUM_ENGINES), NUM_ENGINES);
+  XPLMSetDataf(XPLMFindDataRef(DATAREF_FLAP_ANGLE), 22.0f);
+  XPLMSetDataf(XPLMFindDataRef(DATAREF_GEAR_DEPLOY_RATIO), 1.0f);
+
+  if (!FakeXPLM_StartPlugin()) return false;
+
+  // the plugin publishes these once started
+  ManagerStateRef = XPLMFindDataRef(DATAREF_MANAGER_STATE);
+  TickCountRef    = XPLMFindDataRef(DATAREF_TICK_COUNT);
+  FakeXPLM_ChooseMenuItem(FUZZ_LOG_LEVEL_ITEM);
+  FakeXPLM_SendMessage(XPLM_MSG_PLANE_LOADED, (void *)(intptr_t)XPLM_USER_AIRCRAFT);
+
+  return (ManagerStateRef != NULL) && (TickCountRef != NULL);
+}
+
+// stops the plugin at the end of a session
+// returns false if it left a command held
+static bool StopSession
+  (
+  void
+  )
+{
+  FakeXPLM_StopPlugin();
+  return !FakeXPLM_IsCommandHeld(ReverseThrustCmd) && !FakeXPLM_IsCommandHeld(ThrottleDownCmd);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ENTRY POINT
+
+int main
+  (
+  int argc,
+  char *argv[]
+  )
+{
+  int NumTraces = (argc >= 2) ? atoi(argv[1]) : FUZZ_DEFAULT_TRACES;
+  int FirstTrace = (argc >= 3) ? atoi(argv[2]) : 0;
+  char PluginFolder[256];
+  snprintf(PluginFolder, sizeof(PluginFolder), "%s%s", (argc >= 4) ? argv[3] : ".", XPLMGetDirectorySeparator());
+  if ((NumTraces < 1) || (FirstTrace < 0))
+  {
+    fprintf(stderr, "usage: %s [number of traces] [first trace] [plugin folder]\n", argv[0]);
+    return 1;
+  }
+
+  memset(PropertyFailures, 0, sizeof(PropertyFailures));
+  int FailedTraces = 0;
+  std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+
+  // sessions start on multiples of FUZZ_TRACES_PER_SESSION so a failure can be repeated
+  // by running just its session
+  int SessionFirst = -1;
+  for (int t = FirstTrace; t < FirstTrace + NumTraces; t++)
+  {
+    if ((SessionFirst < 0) || (t % FUZZ_TRACES_PER_SESSION == 0))
+    {
+      if ((SessionFirst >= 0) && !StopSession())
+      {
+        printf("Session %d: command held after the plugin stopped\n", SessionFirst);
+        FailedTraces++;
+      }
+
+      SessionFirst = t;
+      if (!StartSession(PluginFolder))
+      {
+        fprintf(stderr, "The plugin failed to start\n");
+        return 1;
+      }
+    }
+
+    if (!RunTrace(t, SessionFirst)) FailedTraces++;
+  }
+  if (!StopSession())
+  {
+    printf("Session %d: command held after the plugin stopped\n", SessionFirst);
+    FailedTraces++;
+  }
+
+  double Elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+
+  printf("%d traces of %llu frames in %.1f s, %.0f traces per second\n", NumTraces, (unsigned long long)TotalFrames, Elapsed, NumTraces / Elapsed);
+  for (int p = 0; p < NUM_PROPERTIES; p++)
+  {
+    if (PropertyFailures[p] > 0) printf("%8d %s\n", PropertyFailures[p], PropertyNames[p]);
+  }
+  printf("%d failed\n", FailedTraces);
+
+  return (FailedTraces == 0) ? 0 : 1;
+}
@@ -0,0 +1,202 @@
+// Landing Throttle Manager - LoggerCheck
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Checks that the logger keeps long strings inside a record.
+// records are filled with strings that don't fit, as the plugin does when it names a
+// handle it can't find, and must truncate them to a share of the text each without
+// writing past the text of the record. the same messages are then written through a
+// running logger and the log file checked
+//
+// usage: LoggerCheck [log file]
+
+#include <stdio.h>
+#include <string.h>
+#include "Logger.h"
+
+// length of the strings, longer than the text of a record
+#define LONG_TEXT_SIZE 128
+// bytes after the record that must not be written
+#define GUARD_SIZE 16
+#define GUARD_BYTE 0xA5
+// longest line read back from the log file
+#define LOG_LINE_SIZE 1024
+
+// a record with space after it that is checked for writes
+typedef struct _guarded_record_t
+{
+  logger_record_t Record;
+  unsigned char   Guard[GUARD_SIZE];
+} guarded_record_t;
+
+static int NumFailed = 0;
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// INTERNAL FUNCTIONS
+
+// counts and reports a failed check
+static void Check
+  (
+  bool Passed,
+  const char *Name
+  )
+{
+  if (Passed) return;
+  printf("FAILED: %s\n", Name);
+  NumFailed++;
+}
+
+// fills a string with one character
+static void MakeText
+  (
+  char *Text,
+  char Character
+  )
+{
+  memset(Text, Character, LONG_TEXT_SIZE - 1);
+  Text[LONG_TEXT_SIZE - 1] = '\0';
+}
+
+// returns true if a text argument of a record is terminated inside the text of the record
+static bool IsTerminated
+  (
+  const logger_record_t *Record,
+  int Arg
+  )
+{
+  uint32_t Offset = Record->Args[Arg].Value.TextOffset;
+  if (Offset >= LOGGER_TEXT_SIZE) return false;
+  return memchr(&Record->Text[Offset], '\0', LOGGER_TEXT_SIZE - Offset) != NULL;
+}
+
+// fills a record with three long strings and an int, as the plugin does when a
+// handle can't be found, and checks they share the text of the record
+static void CheckRecord
+  (
+  void
+  )
+{
+  char First[LONG_TEXT_SIZE];
+  char Second[LONG_TEXT_SIZE];
+  char Third[LONG_TEXT_SIZE];
+  MakeText(First, 'a');
+  MakeText(Second, 'b');
+  MakeText(Third, 'c');
+
+  guarded_record_t Guarded;
+  memset(&Guarded, GUARD_BYTE, sizeof(Guarded));
+  logger_record_t *Record = &Guarded.Record;
+  Record->Format = "%s %s %s %d\n";
+  Record->NumArgs = 0;
+  Record->TextUsed = 0;
+  Logger_AddArgs(Record, (const char *)First, (const char *)Second, (const char *)Third, 42);
+
+  bool GuardKept = true;
+  for (int g = 0; g < GUARD_SIZE; g++) GuardKept = GuardKept && (Guarded.Guard[g] == GUARD_BYTE);
+  Check(GuardKept, "nothing is written after the record");
+  Check(Record->TextUsed <= LOGGER_TEXT_SIZE, "text used is no more than the text size");
+  Check(Record->NumArgs == 4, "every argument takes a slot");
+
+  for (int a = 0; a < 3; a++) Check(IsTerminated(Record, a), "each string is terminated inside the record");
+  for (int a = 0; a < 3; a++)
+  {
+    Check(strlen(&Record->Text[Record->Args[a].Value.TextOffset]) == LOGGER_TEXT_SIZE / 3 - 1, "each string is truncated to a third of the text");
+  }
+  Check((Record->Args[3].Type == LOGGER_ARG_INT) && (Record->Args[3].Value.Int == 42), "int after the strings is kept");
+
+  // two strings that each fit but not together, as the landing log does
+  memset(&Guarded, GUARD_BYTE, sizeof(Guarded));
+  Record->NumArgs = 0;
+  Record->TextUsed = 0;
+  char Half[LOGGER_TEXT_SIZE / 2 + 8];
+  memset(Half, 'h', sizeof(Half) - 1);
+  Half[sizeof(Half) - 1] = '\0';
+  Logger_AddArgs(Record, (const char *)Half, (const char *)Half, (const char *)Half);
+
+  GuardKept = true;
+  for (int g = 0; g < GUARD_SIZE; g++) GuardKept = GuardKept && (Guarded.Guard[g] == GUARD_BYTE);
+  Check(GuardKept, "nothing is written after a record of strings that fit on their own");
+  Check(Record->TextUsed <= LOGGER_TEXT_SIZE, "text used is no more than the text size with strings that fit on their own");
+  for (int a = 0; a < 3; a++) Check(IsTerminated(Record, a), "each string that fits on its own is terminated inside the record");
+  Check(strlen(&Record->Text[Record->Args[0].Value.TextOffset]) == LOGGER_TEXT_SIZE / 3 - 1, "first string that fits on its own is truncated to its share");
+  Check(Record->Text[Record->Args[2].Value.TextOffset] != '\0', "last string that fits on its own isn't empty");
+
+  // a long dataref name followed by the short handle key and profile name, as the plugin
+  // writes when a custom dataref can't be found. the short strings must be kept whole
+  memset(&Guarded, GUARD_BYTE, sizeof(Guarded));
+  Record->NumArgs = 0;
+  Record->TextUsed = 0;
+  const char *Key = "reverse_thrust_command";
+  const char *Profile = "X-Crafts ERJ Family";
+  Logger_AddArgs(Record, (const char *)First, Key, Profile);
+
+  GuardKept = true;
+  for (int g = 0; g < GUARD_SIZE; g++) GuardKept = GuardKept && (Guarded.Guard[g] == GUARD_BYTE);
+  Check(GuardKept, "nothing is written after a record of a long string and short strings");
+  Check(strlen(&Record->Text[Record->Args[0].Value.TextOffset]) == LOGGER_TEXT_SIZE / 3 - 1, "long string before short strings is truncated to its share");
+  Check(strcmp(&Record->Text[Record->Args[1].Value.TextOffset], Key) == 0, "short string after a long string is kept whole");
+  Check(strcmp(&Record->Text[Record->Args[2].Value.TextOffset], Profile) == 0, "last short string after a long string is kept whole");
+}
+
+// writes the long strings through a running logger and checks the line in the log file
+static void CheckLogFile
+  (
+  const char *Path
+  )
+{
+  char First[LONG_TEXT_SIZE];
+  char Second[LONG_TEXT_SIZE];
+  char Third[LONG_TEXT_SIZE];
+  MakeText(First, 'a');
+  MakeText(Second, 'b');
+  MakeText(Third, 'c');
+
+  if (!Logger_Start(Path))
+  {
+    printf("FAILED: unable to open log file %s\n", Path);
+    NumFailed++;
+    return;
+  }
+  LOG_ERROR("Unable to find %s, the %s for %s [%d]\n", (const char *)First, (const char *)Second, (const char *)Third, 42);
+  Logger_Stop();
+
+  FILE *File = fopen(Path, "r");
+  if (File == NULL)
+  {
+    printf("FAILED: unable to read log file %s\n", Path);
+    NumFailed++;
+    return;
+  }
+
+  char Expected[LOG_LINE_SIZE];
+  int Share = LOGGER_TEXT_SIZE / 3 - 1;
+  snprintf(Expected, LOG_LINE_SIZE, "Unable to find %.*s, the %.*s for %.*s [42]\n", Share, First, Share, Second, Share, Third);
+  bool Found = false;
+  char Line[LOG_LINE_SIZE];
+  while (!Found && (fgets(Line, LOG_LINE_SIZE, File) != NULL))
+  {
+    size_t LineLength = strlen(Line);
+    size_t ExpectedLength = strlen(Expected);
+    Found = (LineLength >= ExpectedLength) && (strcmp(Line + LineLength - ExpectedLength, Expected) == 0);
+  }
+  fclose(File);
+
+  Check(Found, "log file has the truncated line with the int after the strings");
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ENTRY POINT
+
+int main
+  (
+  int argc,
+  char *argv[]
+  )
+{
+  CheckRecord();
+  CheckLogFile((argc >= 2) ? argv[1] : "LoggerCheck.log");
+
+  printf("%d failed\n", NumFailed);
+  return (NumFailed == 0) ? 0 : 1;
+}
@@ -0,0 +1,339 @@
+// Landing Throttle Manager - Replay
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Runs the state machine against a telemetry recording made by the plugin
+// so changes to it can be checked without flying a real approach.
+// the recording is split into landings and each landing is fed through the
+// state machine, only executing it on the frames it would have been scheduled for.
+// for each landing the decision latency is reported, e.g. the time from the
+// touch down of all wheels to the start of reverse thrust, alongside the same
+// figure from the recording
+//
+// usage: Replay <telemetry file> [repeat count]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "StateMachine.h"
+#include "Telemetry.h"
+
+// gap in the recording in seconds that means a new landing has started
+#define MAX_FRAME_GAP 10.0f
+// value used for times that didn't happen
+#define NO_TIME -1.0f
+
+// times of the events in one landing, NO_TIME if the event didn't happen
+typedef struct _landing_result_t
+{
+  float StartTime;              // first frame
+  float MainsDownTime;          // first frame with the main gear on the ground
+  float TouchdownTime;          // first frame with all wheels on the ground
+  float RecordedReverseTime;    // first frame with reverse thrust held in the recording
+  float ReplayIdleTime;         // throttle down released by the replay
+  float ReplayReverseTime;      // reverse thrust started by the replay
+  float ReplayReverseEndTime;   // reverse thrust released by the replay
+  float ReplayMainsDownTime;    // main gear command issued by the replay
+} landing_result_t;
+
+// the frame the state machine is currently looking at
+static const telemetry_frame_t *CurrentFrame = NULL;
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// SIM INTERFACE
+
+// supplies the sim values from the current frame, only those the plugin read on that
+// execution are given as read
+static void ReplayReadSnapshot
+  (
+  void *Refcon,
+  sim_snapshot_t *Snapshot,
+  int Fields
+  )
+{
+  Snapshot->Fields              = Fields & CurrentFrame->Fields;
+  Snapshot->SimTime             = CurrentFrame->SimTime;
+  Snapshot->IndicatedAirSpeed   = CurrentFrame->IndicatedAirSpeed;
+  Snapshot->ThrottleRatio       = CurrentFrame->ThrottleRatio;
+  Snapshot->AltitudeAboveGround = CurrentFrame->AltitudeAboveGround;
+  Snapshot->FlapAngle           = CurrentFrame->FlapAngle;
+  Snapshot->GearDeployRatio     = CurrentFrame->GearDeployRatio;
+  Snapshot->AllWheelsOnGround   = CurrentFrame->AllWheelsOnGround;
+  Snapshot->MainGearOnGround    = CurrentFrame->MainGearOnGround;
+  Snapshot->GroundSpeed         = CurrentFrame->GroundSpeed;
+
+  Snapshot->NumEngines = CurrentFrame->NumEngines;
+  if (Snapshot->NumEngines > SIM_MAX_ENGINES) Snapshot->NumEngines = SIM_MAX_ENGINES;
+  for (int e = 0; e < Snapshot->NumEngines; e++) Snapshot->EngineThrottleRatio[e] = CurrentFrame->EngineThrottleRatio[e];
+}
+
+// notes when the state machine starts holding a command
+static void ReplayCommandBegin
+  (
+  void *Refcon,     // the landing being replayed
+  manager_command_t Command
+  )
+{
+  landing_result_t *Result = (landing_result_t *)Refcon;
+  if ((Command & REVERSE_COMMANDS) && (Result->ReplayReverseTime == NO_TIME))
+  {
+    Result->ReplayReverseTime = CurrentFrame->SimTime;
+  }
+}
+
+// notes when the state machine stops holding a command
+static void ReplayCommandEnd
+  (
+  void *Refcon,     // the landing being replayed
+  manager_command_t Command
+  )
+{
+  landing_result_t *Result = (landing_result_t *)Refcon;
+  if ((Command == COMMAND_THROTTLE_DOWN) && (Result->ReplayIdleTime == NO_TIME))
+  {
+    Result->ReplayIdleTime = CurrentFrame->SimTime;
+  }
+  else if ((Command & REVERSE_COMMANDS) && (Result->ReplayReverseEndTime == NO_TIME))
+  {
+    Result->ReplayReverseEndTime = CurrentFrame->SimTime;
+  }
+}
+
+// notes when the state machine issues a command
+static void ReplayCommandOnce
+  (
+  void *Refcon,     // the landing being replayed
+  manager_command_t Command
+  )
+{
+  landing_result_t *Result = (landing_result_t *)Refcon;
+  if ((Command == COMMAND_MAINS_DOWN) && (Result->ReplayMainsDownTime == NO_TIME))
+  {
+    Result->ReplayMainsDownTime = CurrentFrame->SimTime;
+  }
+}
+
+// the replay is silent
+static void ReplaySpeak
+  (
+  void *Refcon,
+  const char *Message,
+  speech_priority_t Priority
+  )
+{
+}
+
+// the recording can't be changed so the throttles are left as they were
+static void ReplaySetEngineThrottles
+  (
+  void *Refcon,
+  const float *Ratios,
+  int NumEngines
+  )
+{
+}
+
+static const sim_interface_t ReplaySim =
+{
+  ReplayReadSnapshot,
+  ReplayCommandBegin,
+  ReplayCommandEnd,
+  ReplayCommandOnce,
+  ReplaySpeak,
+  ReplaySetEngineThrottles
+};
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// INTERNAL FUNCTIONS
+
+// reads the frames from a telemetry file, oldest first
+// returns true for success
+static bool LoadRecording
+  (
+  const char *Path,
+  std::vector<telemetry_frame_t> &Frames
+  )
+{
+  FILE *File = fopen(Path, "rb");
+  if (File == NULL)
+  {
+    fprintf(stderr, "Unable to open %s\n", Path);
+    return false;
+  }
+
+  telemetry_header_t Header;
+  if ((fread(&Header, sizeof(Header), 1, File) != 1) || (Header.Magic != TELEMETRY_MAGIC) ||
+      (Header.Version != TELEMETRY_VERSION) || (Header.FrameSize != sizeof(telemetry_frame_t)))
+  {
+    fprintf(stderr, "%s is not a telemetry recording this version understands\n", Path);
+    fclose(File);
+    return false;
+  }
+
+  std::vector<telemetry_frame_t> Ring(Header.Capacity);
+  size_t Read = fread(Ring.data(), sizeof(telemetry_frame_t), Header.Capacity, File);
+  fclose(File);
+
+  // once the ring has wrapped the oldest frame is the one that will be overwritten next
+  uint64_t Count = (Header.FramesWritten < Header.Capacity) ? Header.FramesWritten : Header.Capacity;
+  uint64_t First = (Header.FramesWritten < Header.Capacity) ? 0 : Header.FramesWritten % Header.Capacity;
+  if (Count > Read) Count = Read;
+
+  Frames.clear();
+  for (uint64_t f = 0; f < Count; f++)
+  {
+    Frames.push_back(Ring[(First + f) % Header.Capacity]);
+  }
+
+  return true;
+}
+
+// finds the end of the landing that starts at First
+// returns the index after the last frame of the landing
+static size_t FindEndOfLanding
+  (
+  const std::vector<telemetry_frame_t> &Frames,
+  size_t First
+  )
+{
+  for (size_t f = First; f < Frames.size(); f++)
+  {
+    if (Frames[f].State == WAIT_FOR_USER) return f + 1;
+    if ((f + 1 < Frames.size()) && ((Frames[f + 1].SimTime < Frames[f].SimTime) || (Frames[f + 1].SimTime - Frames[f].SimTime > MAX_FRAME_GAP))) return f + 1;
+  }
+
+  return Frames.size();
+}
+
+// runs the state machine over one landing
+// frames are skipped when the state machine asked to be executed later, the same
+// way the plugin schedules it
+static void ReplayLanding
+  (
+  const std::vector<telemetry_frame_t> &Frames,
+  size_t First,
+  size_t End,
+  landing_result_t *Result
+  )
+{
+  Result->StartTime            = Frames[First].SimTime;
+  Result->MainsDownTime        = NO_TIME;
+  Result->TouchdownTime        = NO_TIME;
+  Result->RecordedReverseTime  = NO_TIME;
+  Result->ReplayIdleTime       = NO_TIME;
+  Result->ReplayReverseTime    = NO_TIME;
+  Result->ReplayReverseEndTime = NO_TIME;
+  Result->ReplayMainsDownTime  = NO_TIME;
+
+  for (size_t f = First; f < End; f++)
+  {
+    bool WheelsRead = (Frames[f].Fields & SNAPSHOT_ALL_WHEELS_ON_GROUND) != 0;
+    if ((Result->MainsDownTime == NO_TIME) && WheelsRead && (Frames[f].MainGearOnGround != 0)) Result->MainsDownTime = Frames[f].SimTime;
+    if ((Result->TouchdownTime == NO_TIME) && WheelsRead && (Frames[f].AllWheelsOnGround != 0)) Result->TouchdownTime = Frames[f].SimTime;
+    if ((Result->RecordedReverseTime == NO_TIME) && (Frames[f].Commands & TELEMETRY_COMMAND_REVERSE_THRUST)) Result->RecordedReverseTime = Frames[f].SimTime;
+  }
+
+  // the recording starts on the first execution after the user enabled the manager
+  state_machine_t *Machine = StateMachine_Create(&ReplaySim, Result);
+  StateMachine_Arm(Machine);
+
+  for (size_t f = First; f < End; f++)
+  {
+    CurrentFrame = &Frames[f];
+    if (StateMachine_ExecuteDue(Frames[f].SimTime, NULL) == DORMANT_INTERVAL) break;
+  }
+
+  // don't leave anything held for the next landing
+  StateMachine_Stop(Machine);
+  StateMachine_Destroy(Machine);
+}
+
+// prints the time in milliseconds from one event to another
+static void PrintDelay
+  (
+  const char *Label,
+  float From,
+  float To
+  )
+{
+  if ((From == NO_TIME) || (To == NO_TIME))
+  {
+    printf("  %-32s       -\n", Label);
+  }
+  else
+  {
+    printf("  %-32s %8.1f ms\n", Label, (To - From) * 1000.0f);
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// MAIN
+
+int main
+  (
+  int argc,
+  char *argv[]
+  )
+{
+  if (argc < 2)
+  {
+    fprintf(stderr, "usage: %s <telemetry file> [repeat count]\n", argv[0]);
+    return 1;
+  }
+
+  int Repeat = (argc >= 3) ? atoi(argv[2]) : 1;
+  if (Repeat < 1) Repeat = 1;
+
+  std::vector<telemetry_frame_t> Frames;
+  if (!LoadRecording(argv[1], Frames)) return 1;
+
+  std::vector<landing_result_t> Results;
+  auto Start = std::chrono::steady_clock::now();
+
+  for (int r = 0; r < Repeat; r++)
+  {
+    Results.clear();
+    size_t First = 0;
+    while (First < Frames.size())
+    {
+      // skip anything recorded while not armed
+      if (Frames[First].State == WAIT_FOR_USER)
+      {
+        First++;
+        continue;
+      }
+
+      size_t End = FindEndOfLanding(Frames, First);
+      landing_result_t Result;
+      ReplayLanding(Frames, First, End, &Result);
+      Results.push_back(Result);
+      First = End;
+    }
+  }
+
+  double Elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+
+  double Flown = 0;
+  for (size_t l = 0; l < Results.size(); l++)
+  {
+    const landing_result_t *Result = &Results[l];
+    printf("Landing %u at %.2f s\n", (unsigned int)(l + 1), Result->StartTime);
+    PrintDelay("enable to idle throttle", Result->StartTime, Result->ReplayIdleTime);
+    PrintDelay("main gear to all wheels", Result->MainsDownTime, Result->TouchdownTime);
+    PrintDelay("main gear to mains down command", Result->MainsDownTime, Result->ReplayMainsDownTime);
+    PrintDelay("touch down to reverse", Result->TouchdownTime, Result->ReplayReverseTime);
+    PrintDelay("touch down to reverse, recorded", Result->TouchdownTime, Result->RecordedReverseTime);
+    PrintDelay("reverse held for", Result->ReplayReverseTime, Result->ReplayReverseEndTime);
+  }
+  if (!Frames.empty()) Flown = Frames.back().SimTime - Frames.front().SimTime;
+
+  printf("%u frames, %u landings replayed %d times in %.3f ms", (unsigned int)Frames.size(), (unsigned int)Results.size(), Repeat, Elapsed * 1000.0);
+  if ((Elapsed > 0) && (Flown > 0)) printf(", %.0f times real time", (Flown * Repeat) / Elapsed);
+  printf("\n");
+
+  return 0;
+}
@@ -0,0 +1,72 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Touchdown predictor, see TouchdownPredictor.h
+
+#include "TouchdownPredictor.h"
+
+// forgets the history
+void TouchdownPredictor_Reset
+  (
+  touchdown_predictor_t *Predictor
+  )
+{
+  Predictor->NumSamples    = 0;
+  Predictor->LastTime      = 0;
+  Predictor->LastAltitude  = 0;
+  Predictor->VerticalSpeed = 0;
+}
+
+// adds the height above ground at a sim time
+void TouchdownPredictor_Update
+  (
+  touchdown_predictor_t *Predictor,
+  float SimTime,
+  float AltitudeAboveGround
+  )
+{
+  float Elapsed = SimTime - Predictor->LastTime;
+
+  // start again if time went backwards, e.g. a replay
+  if (Elapsed < 0) Predictor->NumSamples = 0;
+
+  if (Predictor->NumSamples == 0)
+  {
+    Predictor->LastTime     = SimTime;
+    Predictor->LastAltitude = AltitudeAboveGround;
+    Predictor->NumSamples   = 1;
+    return;
+  }
+
+  // paused
+  if (Elapsed == 0) return;
+
+  // smooth with a time constant so the result doesn't depend on the sample rate
+  float Speed = (AltitudeAboveGround - Predictor->LastAltitude) / Elapsed;
+  if (Predictor->NumSamples == 1)
+  {
+    Predictor->VerticalSpeed = Speed;
+  }
+  else
+  {
+    float Weight = Elapsed / (TOUCHDOWN_PREDICTOR_SMOOTHING_TIME + Elapsed);
+    Predictor->VerticalSpeed += Weight * (Speed - Predictor->VerticalSpeed);
+  }
+
+  Predictor->LastTime     = SimTime;
+  Predictor->LastAltitude = AltitudeAboveGround;
+  Predictor->NumSamples++;
+}
+
+// returns the estimated time in seconds until the height above ground reaches zero,
+// or TOUCHDOWN_PREDICTOR_NEVER
+float TouchdownPredictor_GetTimeToTouchdown
+  (
+  const touchdown_predictor_t *Predictor
+  )
+{
+  if ((Predictor->NumSamples < 2) || (Predictor->VerticalSpeed >= 0)) return TOUCHDOWN_PREDICTOR_NEVER;
+  if (Predictor->LastAltitude <= 0) return 0;
+
+  return Predictor->LastAltitude / -Predictor->VerticalSpeed;
+}
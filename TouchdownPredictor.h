@@ -0,0 +1,34 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Touchdown predictor
+// estimates the time until touch down from the history of the height above ground.
+// the vertical speed is the smoothed rate of change of the height between samples,
+// so it works at whatever rate the state machine is executed
+
+#ifndef _TOUCHDOWN_PREDICTOR_H_
+#define _TOUCHDOWN_PREDICTOR_H_
+
+// time constant in seconds of the vertical speed smoothing
+#define TOUCHDOWN_PREDICTOR_SMOOTHING_TIME 0.5f
+// returned when touch down can't be predicted, e.g. when not descending
+#define TOUCHDOWN_PREDICTOR_NEVER 1.0e9f
+
+// the history of one approach
+typedef struct _touchdown_predictor_t
+{
+  int   NumSamples;
+  float LastTime;           // seconds
+  float LastAltitude;       // meters above ground
+  float VerticalSpeed;      // meters per second, negative when descending
+} touchdown_predictor_t;
+
+// forgets the history
+extern void TouchdownPredictor_Reset(touchdown_predictor_t *Predictor);
+// adds the height above ground at a sim time
+extern void TouchdownPredictor_Update(touchdown_predictor_t *Predictor, float SimTime, float AltitudeAboveGround);
+// returns the estimated time in seconds until the height above ground reaches zero,
+// or TOUCHDOWN_PREDICTOR_NEVER
+extern float TouchdownPredictor_GetTimeToTouchdown(const touchdown_predictor_t *Predictor);
+
+#endif // _TOUCHDOWN_PREDICTOR_H_
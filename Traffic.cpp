@@ -0,0 +1,519 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Multiplayer traffic, see Traffic.h
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "XPLMDataAccess.h"
+#include "XPLMProcessing.h"
+#include "XPLMScenery.h"
+#include "DatarefBrowser.h"
+#include "Logger.h"
+#include "Perf.h"
+#include "Traffic.h"
+
+// names of the datarefs the aircraft are read from
+#define TRAFFIC_NUM_AIRCRAFT_DATAREF "sim/cockpit2/tcas/indicators/tcas_num_acf"
+#define TRAFFIC_MODE_S_DATAREF       "sim/cockpit2/tcas/targets/modeS_id"
+#define TRAFFIC_X_DATAREF            "sim/cockpit2/tcas/targets/position/x"
+#define TRAFFIC_Y_DATAREF            "sim/cockpit2/tcas/targets/position/y"
+#define TRAFFIC_Z_DATAREF            "sim/cockpit2/tcas/targets/position/z"
+#define TRAFFIC_VX_DATAREF           "sim/cockpit2/tcas/targets/position/vx"
+#define TRAFFIC_VY_DATAREF           "sim/cockpit2/tcas/targets/position/vy"
+#define TRAFFIC_VZ_DATAREF           "sim/cockpit2/tcas/targets/position/vz"
+#define TRAFFIC_GEAR_DEPLOY_DATAREF  "sim/cockpit2/tcas/targets/position/gear_deploy"
+#define TRAFFIC_FLAP_RATIO_DATAREF   "sim/cockpit2/tcas/targets/position/flap_ratio"
+#define TRAFFIC_THROTTLE_DATAREF     "sim/cockpit2/tcas/targets/position/throttle"
+#define TRAFFIC_ON_GROUND_DATAREF    "sim/cockpit2/tcas/targets/position/weight_on_wheels"
+#define TRAFFIC_SIM_TIME_DATAREF     "sim/time/total_running_time_sec"
+// names of the published datarefs
+#define TRAFFIC_STATE_DATAREF    "landingthrottlemanager/traffic/state"
+#define TRAFFIC_COMMANDS_DATAREF "landingthrottlemanager/traffic/commands"
+
+// knots in a meter per second
+#define TRAFFIC_KNOTS_PER_MS 1.943844f
+// height above ground in meters of an aircraft with no terrain under it, e.g. it is beyond
+// the scenery x-plane has loaded, which is above every limit
+#define TRAFFIC_NO_TERRAIN_ALTITUDE 10000.0f
+
+// the datarefs the aircraft are read from
+static XPLMDataRef NumAircraftRef = NULL;
+static XPLMDataRef ModeSRef = NULL;
+static XPLMDataRef XRef = NULL;
+static XPLMDataRef YRef = NULL;
+static XPLMDataRef ZRef = NULL;
+static XPLMDataRef VXRef = NULL;
+static XPLMDataRef VYRef = NULL;
+static XPLMDataRef VZRef = NULL;
+static XPLMDataRef GearDeployRef = NULL;
+static XPLMDataRef FlapRatioRef = NULL;
+static XPLMDataRef ThrottleRef = NULL;
+static XPLMDataRef OnGroundRef = NULL;
+static XPLMDataRef SimTimeRef = NULL;
+// the published datarefs
+static XPLMDataRef StateRef = NULL;
+static XPLMDataRef CommandsRef = NULL;
+// finds the height of the terrain under an aircraft
+static XPLMProbeRef TerrainProbe = NULL;
+// flight loop that looks for aircraft that have arrived, left or can be enabled
+static XPLMFlightLoopID CheckFlightLoop = NULL;
+// schedules the flight loop that runs the state machines
+static void (*WakeStateMachines)(void) = NULL;
+// set while the aircraft are being followed
+static bool TrafficEnabled = false;
+
+// the slots from the last pass, an array for each value so that a pass is one read
+// for each dataref
+static int   NumSlots = 0;
+static int   ModeS[TRAFFIC_MAX_SLOTS];
+static float X[TRAFFIC_MAX_SLOTS];
+static float Y[TRAFFIC_MAX_SLOTS];
+static float Z[TRAFFIC_MAX_SLOTS];
+static float VX[TRAFFIC_MAX_SLOTS];
+static float VY[TRAFFIC_MAX_SLOTS];
+static float VZ[TRAFFIC_MAX_SLOTS];
+static float GearDeploy[TRAFFIC_MAX_SLOTS];
+static float FlapRatio[TRAFFIC_MAX_SLOTS];
+static float Throttle[TRAFFIC_MAX_SLOTS];
+static int   OnGround[TRAFFIC_MAX_SLOTS];
+// sim time of the last pass, a pass is only made once for each sim time
+static float PassTime = -1;
+
+// the followed aircraft by slot, NULL if the slot isn't followed
+static state_machine_t *Machines[TRAFFIC_MAX_SLOTS];
+// mode S id of the aircraft each state machine follows, a slot can be given to a
+// different aircraft
+static int MachineModeS[TRAFFIC_MAX_SLOTS];
+// set once the state machine has been enabled on this approach, cleared when the
+// conditions stop being met or the aircraft is on the ground
+static bool EnabledThisApproach[TRAFFIC_MAX_SLOTS];
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// INTERNAL FUNCTIONS
+
+// reads up to Count values of a float array dataref
+// returns the number read
+static int ReadFloats
+  (
+  XPLMDataRef Ref,
+  float *Values,
+  int Count
+  )
+{
+  int Read = XPLMGetDatavf(Ref, Values, 0, Count);
+  return (Read < Count) ? Read : Count;
+}
+
+// reads up to Count values of an int array dataref
+// returns the number read
+static int ReadInts
+  (
+  XPLMDataRef Ref,
+  int *Values,
+  int Count
+  )
+{
+  int Read = XPLMGetDatavi(Ref, Values, 0, Count);
+  return (Read < Count) ? Read : Count;
+}
+
+// reads every slot, however many state machines execute in a frame this is only done once
+static void ReadSlots
+  (
+  void
+  )
+{
+  float Now = XPLMGetDataf(SimTimeRef);
+  if (Now == PassTime) return;
+  PassTime = Now;
+
+  int Count = XPLMGetDatai(NumAircraftRef);
+  if (Count > TRAFFIC_MAX_SLOTS) Count = TRAFFIC_MAX_SLOTS;
+  if (Count < 0) Count = 0;
+
+  // a slot is only used if every value was read for it
+  Count = ReadInts(ModeSRef, ModeS, Count);
+  Count = ReadFloats(XRef, X, Count);
+  Count = ReadFloats(YRef, Y, Count);
+  Count = ReadFloats(ZRef, Z, Count);
+  Count = ReadFloats(VXRef, VX, Count);
+  Count = ReadFloats(VYRef, VY, Count);
+  Count = ReadFloats(VZRef, VZ, Count);
+  Count = ReadFloats(GearDeployRef, GearDeploy, Count);
+  Count = ReadFloats(FlapRatioRef, FlapRatio, Count);
+  Count = ReadFloats(ThrottleRef, Throttle, Count);
+  Count = ReadInts(OnGroundRef, OnGround, Count);
+  NumSlots = Count;
+}
+
+// gets the height above the terrain of the aircraft in a slot, in meters
+static float GetAltitudeAboveGround
+  (
+  int Slot
+  )
+{
+  XPLMProbeInfo_t Terrain;
+  Terrain.structSize = sizeof(XPLMProbeInfo_t);
+  if (XPLMProbeTerrainXYZ(TerrainProbe, X[Slot], Y[Slot], Z[Slot], &Terrain) != xplm_ProbeHitTerrain) return TRAFFIC_NO_TERRAIN_ALTITUDE;
+
+  return Y[Slot] - Terrain.locationY;
+}
+
+// reads the requested values of the aircraft in a slot into a snapshot
+// this is the only place the state machines of the traffic read sim data
+static void TrafficReadSnapshot
+  (
+  void *Refcon,           // the slot
+  sim_snapshot_t *Snap,   // snapshot to fill in
+  int Fields              // SNAPSHOT_* flags of the values to read
+  )
+{
+  int Slot = (int)(intptr_t)Refcon;
+  ReadSlots();
+
+  // the aircraft has left, nothing is read until its state machine is released
+  if (Slot >= NumSlots)
+  {
+    Snap->Fields = 0;
+    return;
+  }
+
+  Snap->Fields = Fields;
+
+  if (Fields & SNAPSHOT_INDICATED_AIRSPEED)    Snap->IndicatedAirSpeed   = sqrtf((VX[Slot] * VX[Slot]) + (VY[Slot] * VY[Slot]) + (VZ[Slot] * VZ[Slot])) * TRAFFIC_KNOTS_PER_MS;
+  if (Fields & SNAPSHOT_THROTTLE_RATIO)        Snap->ThrottleRatio       = Throttle[Slot];
+  if (Fields & SNAPSHOT_FLAP_ANGLE)            Snap->FlapAngle           = FlapRatio[Slot] * TRAFFIC_FULL_FLAP_ANGLE;
+  if (Fields & SNAPSHOT_GEAR_DEPLOY_RATIO)     Snap->GearDeployRatio     = GearDeploy[Slot];
+  if (Fields & SNAPSHOT_ALTITUDE_ABOVE_GROUND) Snap->AltitudeAboveGround = GetAltitudeAboveGround(Slot);
+  if (Fields & SNAPSHOT_SIM_TIME)              Snap->SimTime             = PassTime;
+  if (Fields & SNAPSHOT_GROUND_SPEED)          Snap->GroundSpeed         = sqrtf((VX[Slot] * VX[Slot]) + (VZ[Slot] * VZ[Slot]));
+
+  if (Fields & SNAPSHOT_ALL_WHEELS_ON_GROUND)
+  {
+    Snap->MainGearOnGround  = (OnGround[Slot] != 0) ? 1 : 0;
+    Snap->AllWheelsOnGround = Snap->MainGearOnGround;
+  }
+
+  if (Fields & SNAPSHOT_ENGINE_THROTTLE_RATIO)
+  {
+    Snap->NumEngines = 1;
+    Snap->EngineThrottleRatio[0] = Throttle[Slot];
+  }
+}
+
+// the commands held are published rather than sent, x-plane only sends them to the user aircraft
+static void TrafficCommand
+  (
+  void *Refcon,
+  manager_command_t Command
+  )
+{
+}
+
+// only the user is spoken to
+static void TrafficSpeak
+  (
+  void *Refcon,
+  const char *Message,
+  speech_priority_t Priority
+  )
+{
+}
+
+// the throttles of the traffic can't be written, reverse thrust is always full
+static void TrafficSetEngineThrottles
+  (
+  void *Refcon,
+  const float *Ratios,
+  int NumEngines
+  )
+{
+}
+
+// connects the state machines of the traffic to x-plane
+static const sim_interface_t TrafficSim =
+{
+  TrafficReadSnapshot,
+  TrafficCommand,
+  TrafficCommand,
+  TrafficCommand,
+  TrafficSpeak,
+  TrafficSetEngineThrottles
+};
+
+// stops following the aircraft in a slot
+static void Release
+  (
+  int Slot
+  )
+{
+  if (Machines[Slot] == NULL) return;
+
+  StateMachine_Stop(Machines[Slot]);
+  StateMachine_Destroy(Machines[Slot]);
+  Machines[Slot] = NULL;
+  LOG_INFO("Stopped following aircraft %X in slot %d\n", MachineModeS[Slot], Slot);
+}
+
+// follows the aircraft in a slot, enabling its state machine when the landing conditions
+// are met and stopping it if it climbs away
+// returns true if its state machine was enabled
+static bool CheckSlot
+  (
+  int Slot
+  )
+{
+  // the slot has been given to another aircraft
+  if ((Machines[Slot] != NULL) && (ModeS[Slot] != MachineModeS[Slot])) Release(Slot);
+
+  if (Machines[Slot] == NULL)
+  {
+    // every state machine is in use, try again on the next check
+    Machines[Slot] = StateMachine_Create(&TrafficSim, (void *)(intptr_t)Slot);
+    if (Machines[Slot] == NULL) return false;
+
+    MachineModeS[Slot] = ModeS[Slot];
+    EnabledThisApproach[Slot] = false;
+    LOG_INFO("Following aircraft %X in slot %d\n", ModeS[Slot], Slot);
+  }
+
+  state_machine_t *Machine = Machines[Slot];
+  sim_snapshot_t Arming;
+  TrafficReadSnapshot((void *)(intptr_t)Slot, &Arming, SNAPSHOT_ARMING | SNAPSHOT_SIM_TIME);
+  bool Airborne = (OnGround[Slot] == 0);
+
+  states_t State = StateMachine_GetState(Machine);
+  if (State != WAIT_FOR_USER)
+  {
+    // it has touched down so the next approach can be followed
+    if (!Airborne) EnabledThisApproach[Slot] = false;
+
+    // climbing out of the landing conditions is a go around, climbing away after touching
+    // down is a touch and go
+    if (Airborne && ((Arming.AltitudeAboveGround > MAX_ALTITUDE) ||
+        ((State >= APPLY_REVERSE) && (Arming.AltitudeAboveGround > TRAFFIC_MIN_ENABLE_ALTITUDE))))
+    {
+      LOG_INFO("Aircraft %X in slot %d climbed away, stopping\n", MachineModeS[Slot], Slot);
+      StateMachine_Stop(Machine);
+    }
+    return false;
+  }
+
+  int Failures = StateMachine_CheckArming(Machine, &Arming);
+  if ((Failures != 0) || !Airborne)
+  {
+    EnabledThisApproach[Slot] = false;
+    return false;
+  }
+
+  // only descending so a departure with the flaps and gear down isn't taken for a landing
+  if (EnabledThisApproach[Slot] || (VY[Slot] >= 0) || (Arming.AltitudeAboveGround < TRAFFIC_MIN_ENABLE_ALTITUDE)) return false;
+
+  EnabledThisApproach[Slot] = true;
+  if (!StateMachine_EnableChecked(Machine, Failures, Arming.SimTime)) return false;
+
+  LOG_INFO("Aircraft %X in slot %d is landing, enabled\n", MachineModeS[Slot], Slot);
+  return true;
+}
+
+// looks for aircraft that have arrived, left or can be enabled, called periodically by x-plane
+static float Check
+  (
+  float inElapsedSinceLastCall,
+  float inElapsedTimeSinceLastFlightLoop,
+  int inCounter,
+  void *inRefcon
+  )
+{
+  PERF_SCOPE(PERF_PROBE_TRAFFIC);
+
+  ReadSlots();
+
+  // slot 0 is the user aircraft, which has its own state machine
+  bool Enabled = false;
+  for (int Slot = 1; Slot < TRAFFIC_MAX_SLOTS; Slot++)
+  {
+    if (Slot >= NumSlots)
+    {
+      Release(Slot);
+      continue;
+    }
+    if (CheckSlot(Slot)) Enabled = true;
+  }
+
+  if (Enabled) WakeStateMachines();
+  return TRAFFIC_CHECK_INTERVAL;
+}
+
+// reads a value of each slot for an int array dataref, -1 for the slots that aren't
+// followed if States, otherwise 0
+static int ReadSlotValues
+  (
+  int *outValues,
+  int inOffset,
+  int inMax,
+  bool States
+  )
+{
+  if (outValues == NULL) return TRAFFIC_MAX_SLOTS;
+  if (inOffset < 0) return 0;
+
+  int Count = 0;
+  for (int Slot = inOffset; (Slot < TRAFFIC_MAX_SLOTS) && (Count < inMax); Slot++)
+  {
+    if (Machines[Slot] == NULL)
+    {
+      outValues[Count++] = States ? -1 : 0;
+    }
+    else
+    {
+      outValues[Count++] = States ? (int)StateMachine_GetState(Machines[Slot]) : StateMachine_GetActiveCommands(Machines[Slot]);
+    }
+  }
+
+  return Count;
+}
+
+// reads the state of each slot
+static int ReadStates
+  (
+  void *inRefcon,
+  int *outValues,
+  int inOffset,
+  int inMax
+  )
+{
+  return ReadSlotValues(outValues, inOffset, inMax, true);
+}
+
+// reads the commands held for each slot
+static int ReadCommands
+  (
+  void *inRefcon,
+  int *outValues,
+  int inOffset,
+  int inMax
+  )
+{
+  return ReadSlotValues(outValues, inOffset, inMax, false);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// TRAFFIC API
+
+// publishes the datarefs, Wake is called when a state machine has been enabled so the
+// flight loop running the state machines can be scheduled
+void Traffic_Start
+  (
+  void (*Wake)(void)
+  )
+{
+  WakeStateMachines = Wake;
+  TrafficEnabled = false;
+  NumSlots = 0;
+  PassTime = -1;
+  for (int Slot = 0; Slot < TRAFFIC_MAX_SLOTS; Slot++) Machines[Slot] = NULL;
+
+  // the tcas targets are only in x-plane 11.50 and later
+  NumAircraftRef = XPLMFindDataRef(TRAFFIC_NUM_AIRCRAFT_DATAREF);
+  ModeSRef       = XPLMFindDataRef(TRAFFIC_MODE_S_DATAREF);
+  XRef           = XPLMFindDataRef(TRAFFIC_X_DATAREF);
+  YRef           = XPLMFindDataRef(TRAFFIC_Y_DATAREF);
+  ZRef           = XPLMFindDataRef(TRAFFIC_Z_DATAREF);
+  VXRef          = XPLMFindDataRef(TRAFFIC_VX_DATAREF);
+  VYRef          = XPLMFindDataRef(TRAFFIC_VY_DATAREF);
+  VZRef          = XPLMFindDataRef(TRAFFIC_VZ_DATAREF);
+  GearDeployRef  = XPLMFindDataRef(TRAFFIC_GEAR_DEPLOY_DATAREF);
+  FlapRatioRef   = XPLMFindDataRef(TRAFFIC_FLAP_RATIO_DATAREF);
+  ThrottleRef    = XPLMFindDataRef(TRAFFIC_THROTTLE_DATAREF);
+  OnGroundRef    = XPLMFindDataRef(TRAFFIC_ON_GROUND_DATAREF);
+  SimTimeRef     = XPLMFindDataRef(TRAFFIC_SIM_TIME_DATAREF);
+
+  StateRef = XPLMRegisterDataAccessor(TRAFFIC_STATE_DATAREF, xplmType_IntArray, 0,
+    NULL, NULL, NULL, NULL, NULL, NULL, ReadStates, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL);
+  CommandsRef = XPLMRegisterDataAccessor(TRAFFIC_COMMANDS_DATAREF, xplmType_IntArray, 0,
+    NULL, NULL, NULL, NULL, NULL, NULL, ReadCommands, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL);
+
+  TerrainProbe = XPLMCreateProbe(xplm_ProbeY);
+
+  XPLMCreateFlightLoop_t FlightLoopParams;
+  FlightLoopParams.structSize   = sizeof(XPLMCreateFlightLoop_t);
+  FlightLoopParams.phase        = xplm_FlightLoop_Phase_BeforeFlightModel;
+  FlightLoopParams.callbackFunc = Check;
+  FlightLoopParams.refcon       = NULL;
+  CheckFlightLoop = XPLMCreateFlightLoop(&FlightLoopParams);
+}
+
+// tells dataref browsers such as DataRefTool about the datarefs, call once all plugins are loaded
+void Traffic_Announce
+  (
+  void
+  )
+{
+  XPLMPluginID Browser = DatarefBrowser_Find();
+  DatarefBrowser_Show(Browser, TRAFFIC_STATE_DATAREF);
+  DatarefBrowser_Show(Browser, TRAFFIC_COMMANDS_DATAREF);
+}
+
+// starts or stops following the aircraft, stopping releases every state machine
+void Traffic_SetEnabled
+  (
+  bool Enabled
+  )
+{
+  if (Enabled && ((NumAircraftRef == NULL) || (ModeSRef == NULL) || (XRef == NULL) || (YRef == NULL) || (ZRef == NULL) ||
+      (VXRef == NULL) || (VYRef == NULL) || (VZRef == NULL) || (GearDeployRef == NULL) || (FlapRatioRef == NULL) ||
+      (ThrottleRef == NULL) || (OnGroundRef == NULL) || (TerrainProbe == NULL)))
+  {
+    LOG_ERROR("Unable to find the TCAS target datarefs, following the traffic needs X-Plane 11.50 or later\n");
+    Enabled = false;
+  }
+
+  TrafficEnabled = Enabled;
+  if (!Enabled)
+  {
+    for (int Slot = 0; Slot < TRAFFIC_MAX_SLOTS; Slot++) Release(Slot);
+  }
+  PassTime = -1;
+
+  if (CheckFlightLoop != NULL) XPLMScheduleFlightLoop(CheckFlightLoop, Enabled ? TRAFFIC_CHECK_INTERVAL : DORMANT_INTERVAL, 1);
+}
+
+// returns true while the aircraft are being followed
+bool Traffic_IsEnabled
+  (
+  void
+  )
+{
+  return TrafficEnabled;
+}
+
+// releases the state machines and removes the datarefs
+void Traffic_Stop
+  (
+  void
+  )
+{
+  if (CheckFlightLoop != NULL)
+  {
+    XPLMDestroyFlightLoop(CheckFlightLoop);
+    CheckFlightLoop = NULL;
+  }
+
+  for (int Slot = 0; Slot < TRAFFIC_MAX_SLOTS; Slot++) Release(Slot);
+  TrafficEnabled = false;
+
+  if (TerrainProbe != NULL) XPLMDestroyProbe(TerrainProbe);
+  TerrainProbe = NULL;
+
+  if (StateRef != NULL) XPLMUnregisterDataAccessor(StateRef);
+  if (CommandsRef != NULL) XPLMUnregisterDataAccessor(CommandsRef);
+  StateRef = NULL;
+  CommandsRef = NULL;
+}
@@ -0,0 +1,52 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Multiplayer traffic
+// optionally follows the landings of the other aircraft in the session, e.g. the AI or
+// training aircraft an instructor station hosts, with a state machine for each one.
+// the aircraft are read from the TCAS target datarefs of X-Plane 11.50 and later, which
+// have a slot for each aircraft and the user aircraft in slot 0. every slot is read in
+// one pass a frame, a call for each dataref, and each state machine takes its values
+// from that pass by its slot.
+// x-plane only flies the user aircraft with the throttle and reverse commands, so the
+// commands the state machine of an aircraft wants held are published for whatever is
+// flying it to act on:
+//   landingthrottlemanager/traffic/state     int array, states_t of each slot, -1 if the slot isn't followed
+//   landingthrottlemanager/traffic/commands  int array, manager_command_t flags held for each slot
+// the slots don't have everything the user aircraft has so some values are worked out:
+//   the indicated airspeed is the speed through the air with no wind, from the velocity
+//   the height above ground is from a terrain probe under the aircraft
+//   the flap angle is the flap ratio of TRAFFIC_FULL_FLAP_ANGLE degrees
+//   all the wheels are on the ground when the slot has weight on the wheels
+//   there is one engine, the throttle of the slot
+// the state machine of an aircraft is enabled when it is descending with the landing
+// conditions met and stopped if it climbs away again. must only be used from the sim thread
+
+#ifndef _TRAFFIC_H_
+#define _TRAFFIC_H_
+
+#include "StateMachine.h"
+
+// number of slots in the TCAS target datarefs, slot 0 is the user aircraft
+#define TRAFFIC_MAX_SLOTS 64
+// time between looking for aircraft that have arrived, left or can be enabled, in seconds
+#define TRAFFIC_CHECK_INTERVAL 1.0f
+// flap angle in degrees taken for a flap ratio of 1
+#define TRAFFIC_FULL_FLAP_ANGLE 40.0f
+// minimum height above ground in meters for enabling, so a landed aircraft with the
+// flaps still down isn't enabled
+#define TRAFFIC_MIN_ENABLE_ALTITUDE 30.0f
+
+// publishes the datarefs, Wake is called when a state machine has been enabled so the
+// flight loop running the state machines can be scheduled
+extern void Traffic_Start(void (*Wake)(void));
+// tells dataref browsers such as DataRefTool about the datarefs, call once all plugins are loaded
+extern void Traffic_Announce(void);
+// starts or stops following the aircraft, stopping releases every state machine
+extern void Traffic_SetEnabled(bool Enabled);
+// returns true while the aircraft are being followed
+extern bool Traffic_IsEnabled(void);
+// releases the state machines and removes the datarefs
+extern void Traffic_Stop(void);
+
+#endif // _TRAFFIC_H_
@@ -0,0 +1,244 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Voice guidance, see Voice.h
+
+#include <stdio.h>
+#include <string.h>
+#include "XPLMDataAccess.h"
+#include "XPLMProcessing.h"
+#include "XPLMUtilities.h"
+#include "Logger.h"
+#include "Perf.h"
+#include "Voice.h"
+
+// one waiting message
+typedef struct _voice_message_t
+{
+  char              Text[VOICE_MESSAGE_SIZE];
+  speech_priority_t Priority;
+  float             QueuedTime;   // sim time it was queued
+} voice_message_t;
+
+// longest time a message can wait, indexed by speech_priority_t
+static const float MaxAges[SPEECH_NUM_PRIORITIES] =
+{
+  VOICE_GUIDANCE_MAX_AGE,   // SPEECH_PRIORITY_GUIDANCE
+  VOICE_SAFETY_MAX_AGE      // SPEECH_PRIORITY_SAFETY
+};
+
+// the waiting messages, in the order they were queued
+static voice_message_t Queue[VOICE_QUEUE_SIZE];
+static int NumQueued = 0;
+// when the last message was said, only valid if HaveSpoken is set
+static bool HaveSpoken = false;
+static float LastSpokenTime = 0;
+// flight loop that says the messages
+static XPLMFlightLoopID VoiceFlightLoop = NULL;
+static XPLMDataRef SimTimeRef = NULL;
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// INTERNAL FUNCTIONS
+
+// removes a message from the queue, keeping the others in order
+static void RemoveMessage
+  (
+  int Index
+  )
+{
+  NumQueued--;
+  for (int m = Index; m < NumQueued; m++) Queue[m] = Queue[m + 1];
+}
+
+// drops the messages that have waited too long to be worth saying
+static void DropStaleMessages
+  (
+  float Now
+  )
+{
+  int m = 0;
+  while (m < NumQueued)
+  {
+    // time going backwards means a new flight, nothing from before is worth saying
+    float Age = Now - Queue[m].QueuedTime;
+    if ((Age < 0) || (Age > MaxAges[Queue[m].Priority]))
+    {
+      LOG_INFO("Not saying \"%s\", it waited %f seconds\n", Queue[m].Text, Age);
+      RemoveMessage(m);
+    }
+    else
+    {
+      m++;
+    }
+  }
+}
+
+// finds the message to say next, the most urgent and then the oldest
+// returns the index of the message or -1 if none are waiting
+static int FindNextMessage
+  (
+  void
+  )
+{
+  int Next = -1;
+  for (int m = 0; m < NumQueued; m++)
+  {
+    if ((Next < 0) || (Queue[m].Priority > Queue[Next].Priority)) Next = m;
+  }
+  return Next;
+}
+
+// finds the message to drop to make room for one of a priority, the least urgent
+// and then the oldest
+// returns the index of the message or -1 if they are all more urgent
+static int FindMessageToDrop
+  (
+  speech_priority_t Priority
+  )
+{
+  int Drop = -1;
+  for (int m = 0; m < NumQueued; m++)
+  {
+    if ((Queue[m].Priority <= Priority) && ((Drop < 0) || (Queue[m].Priority < Queue[Drop].Priority))) Drop = m;
+  }
+  return Drop;
+}
+
+// returns the time in seconds until another message can be said, 0 if one can be said now
+static float TimeUntilNextMessage
+  (
+  float Now
+  )
+{
+  if (!HaveSpoken) return 0;
+
+  // time going backwards means a new flight
+  float Since = Now - LastSpokenTime;
+  if ((Since < 0) || (Since >= VOICE_INTERVAL)) return 0;
+  return VOICE_INTERVAL - Since;
+}
+
+// says the next waiting message, called by x-plane when one is due
+// returns the number of seconds to the next message or DORMANT_INTERVAL if none are waiting
+static float SayNextMessage
+  (
+  float inElapsedSinceLastCall,
+  float inElapsedTimeSinceLastFlightLoop,
+  int inCounter,
+  void *inRefcon
+  )
+{
+  PERF_SCOPE(PERF_PROBE_VOICE);
+
+  float Now = XPLMGetDataf(SimTimeRef);
+  DropStaleMessages(Now);
+  if (NumQueued == 0) return DORMANT_INTERVAL;
+
+  float Wait = TimeUntilNextMessage(Now);
+  if (Wait > 0) return Wait;
+
+  int Next = FindNextMessage();
+  LOG_TRACE("Saying \"%s\"\n", Queue[Next].Text);
+  XPLMSpeakString(Queue[Next].Text);
+  RemoveMessage(Next);
+  HaveSpoken = true;
+  LastSpokenTime = Now;
+
+  return (NumQueued > 0) ? VOICE_INTERVAL : DORMANT_INTERVAL;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////
+// VOICE API
+
+// creates the flight loop that says the messages, which starts parked
+void Voice_Start
+  (
+  void
+  )
+{
+  NumQueued = 0;
+  HaveSpoken = false;
+  SimTimeRef = XPLMFindDataRef("sim/time/total_running_time_sec");
+
+  XPLMCreateFlightLoop_t FlightLoopParams;
+  FlightLoopParams.structSize   = sizeof(XPLMCreateFlightLoop_t);
+  FlightLoopParams.phase        = xplm_FlightLoop_Phase_BeforeFlightModel;
+  FlightLoopParams.callbackFunc = SayNextMessage;
+  FlightLoopParams.refcon       = NULL;
+  VoiceFlightLoop = XPLMCreateFlightLoop(&FlightLoopParams);
+}
+
+// queues a message to be said, if it is already waiting it takes the higher of the two
+// priorities and its age starts again
+// returns false if the queue is full of messages that are at least as urgent
+bool Voice_Say
+  (
+  const char *Message,
+  speech_priority_t Priority
+  )
+{
+  if ((Message == NULL) || (Message[0] == '\0') || (VoiceFlightLoop == NULL)) return false;
+
+  float Now = XPLMGetDataf(SimTimeRef);
+  voice_message_t *Waiting = NULL;
+  for (int m = 0; m < NumQueued; m++)
+  {
+    if (strncmp(Queue[m].Text, Message, VOICE_MESSAGE_SIZE - 1) == 0) Waiting = &Queue[m];
+  }
+
+  if (Waiting != NULL)
+  {
+    LOG_TRACE("Already waiting to say \"%s\"\n", Waiting->Text);
+    if (Priority > Waiting->Priority) Waiting->Priority = Priority;
+    Waiting->QueuedTime = Now;
+    return true;
+  }
+
+  if (NumQueued == VOICE_QUEUE_SIZE)
+  {
+    int Drop = FindMessageToDrop(Priority);
+    if (Drop < 0)
+    {
+      LOG_INFO("Voice queue is full, not saying \"%s\"\n", Message);
+      return false;
+    }
+    LOG_INFO("Voice queue is full, not saying \"%s\"\n", Queue[Drop].Text);
+    RemoveMessage(Drop);
+  }
+
+  voice_message_t *Queued = &Queue[NumQueued++];
+  snprintf(Queued->Text, VOICE_MESSAGE_SIZE, "%s", Message);
+  Queued->Priority   = Priority;
+  Queued->QueuedTime = Now;
+
+  // say it on the next frame unless the last message was too recent
+  float Wait = TimeUntilNextMessage(Now);
+  XPLMScheduleFlightLoop(VoiceFlightLoop, (Wait > 0) ? Wait : EVERY_FRAME_INTERVAL, 1);
+  return true;
+}
+
+// drops every waiting message
+void Voice_Clear
+  (
+  void
+  )
+{
+  NumQueued = 0;
+  if (VoiceFlightLoop != NULL) XPLMScheduleFlightLoop(VoiceFlightLoop, DORMANT_INTERVAL, 1);
+}
+
+// removes the flight loop and drops every waiting message
+void Voice_Stop
+  (
+  void
+  )
+{
+  if (VoiceFlightLoop != NULL)
+  {
+    XPLMDestroyFlightLoop(VoiceFlightLoop);
+    VoiceFlightLoop = NULL;
+  }
+  NumQueued = 0;
+}
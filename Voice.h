@@ -0,0 +1,39 @@
+// Landing Throttle Manager
+// (C) andy@britishideas.com 2022, free for personal use, no commercial use
+
+// Voice guidance
+// messages for the user are queued and said from a flight loop rather than straight
+// away, so the command and menu handlers never wait for x-plane's speech and a burst
+// of messages doesn't pile up. at most one message is said every VOICE_INTERVAL
+// seconds, the most urgent first and otherwise the oldest first. a message that is
+// already waiting isn't queued again, and one that has waited longer than the age
+// limit of its priority is dropped as it is no longer news by the time it would be said
+// must only be used from the sim thread
+
+#ifndef _VOICE_H_
+#define _VOICE_H_
+
+#include "StateMachine.h"
+
+// number of messages that can be waiting
+#define VOICE_QUEUE_SIZE 8
+// longest message kept, longer messages are truncated
+#define VOICE_MESSAGE_SIZE 128
+// shortest time between the start of two messages in seconds
+#define VOICE_INTERVAL 1.5f
+// longest time a message can wait to be said in seconds, for each priority
+#define VOICE_GUIDANCE_MAX_AGE 5.0f
+#define VOICE_SAFETY_MAX_AGE   2.0f
+
+// creates the flight loop that says the messages, which starts parked
+extern void Voice_Start(void);
+// queues a message to be said, if it is already waiting it takes the higher of the two
+// priorities and its age starts again
+// returns false if the queue is full of messages that are at least as urgent
+extern bool Voice_Say(const char *Message, speech_priority_t Priority);
+// drops every waiting message
+extern void Voice_Clear(void);
+// removes the flight loop and drops every waiting message
+extern void Voice_Stop(void);
+
+#endif // _VOICE_H_